@@ -0,0 +1,195 @@
+// AsyncServiceListener.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the queued dispatch mode of a service listener:
+// the events are pushed into a bounded SPSC ring and the wrapped listener
+// (and hence the downstream service) runs on its own worker thread
+
+#ifndef AsyncServiceListener_hpp
+#define AsyncServiceListener_hpp
+
+#include "soa.hpp"
+#include "SpscRingBuffer.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+
+// Type of the event forwarded to the wrapped listener
+enum ServiceEventType { ADD_EVENT, REMOVE_EVENT, UPDATE_EVENT };
+
+// An event queued between two services
+// Type V is the data type of the service
+template <typename V>
+struct ServiceEvent
+{
+	ServiceEventType type;
+	V data;
+};
+
+// Asynchronous service listener
+// registered on the upstream service in place of the wrapped listener;
+// the upstream thread only copies the data into the ring and returns,
+// and the worker hands consecutive add/update events over as one batch
+template <typename V>
+class AsyncServiceListener : public ServiceListener<V>
+{
+protected:
+	ServiceListener<V>* listener; // the wrapped listener, called on the worker thread
+	SpscRingBuffer<ServiceEvent<V>> queue;
+	std::atomic<bool> running;
+	std::atomic<long> enqueued; // # of events pushed by the upstream service
+	std::atomic<long> processed; // # of events handed over to the wrapped listener
+	std::size_t maxBatch; // maximum # of events handed over at once
+	std::thread worker;
+
+	// Push an event into the ring (blocks while the ring is full)
+	void Enqueue(ServiceEventType type, V &data);
+
+	// Hand a batch of events over to the wrapped listener
+	void Dispatch(ServiceEventType type, std::vector<V> &batch);
+
+	// Worker thread loop
+	void Run();
+
+public:
+	AsyncServiceListener(ServiceListener<V>* _listener, std::size_t capacity = 65536, 
+		std::size_t _maxBatch = 1024); // ctor
+	~AsyncServiceListener(); // dtor, drains the ring and joins the worker
+
+	// Listener callback to process an add event to the Service
+	virtual void ProcessAdd(V &data);
+
+	// Listener callback to process a remove event to the Service
+	virtual void ProcessRemove(V &data);
+
+	// Listener callback to process an update event to the Service
+	virtual void ProcessUpdate(V &data);
+
+	// Wait until all the queued events have been processed by the wrapped listener
+	void Flush();
+
+	// Drain the ring and stop the worker thread
+	void Stop();
+
+	// Get the current number of queued events
+	std::size_t GetQueueDepth() const;
+};
+
+template <typename V>
+AsyncServiceListener<V>::AsyncServiceListener(ServiceListener<V>* _listener, std::size_t capacity, 
+	std::size_t _maxBatch) :
+	listener(_listener), queue(capacity), running(true), enqueued(0), processed(0), 
+	maxBatch(_maxBatch > 0 ? _maxBatch : 1)
+{
+	worker = std::thread(&AsyncServiceListener<V>::Run, this);
+}
+
+template <typename V>
+AsyncServiceListener<V>::~AsyncServiceListener()
+{
+	Stop();
+}
+
+template <typename V>
+void AsyncServiceListener<V>::Enqueue(ServiceEventType type, V &data)
+{
+	ServiceEvent<V> event;
+	event.type = type;
+	event.data = data;
+	queue.Push(event);
+	enqueued.fetch_add(1, std::memory_order_release);
+}
+
+template <typename V>
+void AsyncServiceListener<V>::Dispatch(ServiceEventType type, std::vector<V> &batch)
+{
+	if (type == ADD_EVENT)
+		listener->ProcessAddBatch(batch.data(), batch.size());
+	else
+		listener->ProcessUpdateBatch(batch.data(), batch.size());
+	processed.fetch_add(batch.size(), std::memory_order_release);
+	batch.clear();
+}
+
+template <typename V>
+void AsyncServiceListener<V>::Run()
+{
+	ServiceEvent<V> event;
+	std::vector<V> batch; // consecutive add (or update) events
+	batch.reserve(maxBatch);
+	ServiceEventType batchType = ADD_EVENT;
+	int idle = 0; // # of consecutive empty polls
+	while (running.load(std::memory_order_acquire) || !queue.Empty())
+	{
+		if (queue.TryPop(event))
+		{
+			if (!batch.empty() && event.type != batchType) // the run of events is broken
+				Dispatch(batchType, batch);
+			if (event.type == REMOVE_EVENT)
+			{
+				listener->ProcessRemove(event.data);
+				processed.fetch_add(1, std::memory_order_release);
+			}
+			else
+			{
+				batchType = event.type;
+				batch.push_back(std::move(event.data));
+				if (batch.size() == maxBatch)
+					Dispatch(batchType, batch);
+			}
+			idle = 0;
+		}
+		else if (!batch.empty()) // the ring is drained, hand over what we have
+			Dispatch(batchType, batch);
+		else if (++idle < 1000)
+			std::this_thread::yield();
+		else // back off when the upstream service is quiet
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	if (!batch.empty())
+		Dispatch(batchType, batch);
+}
+
+template <typename V>
+void AsyncServiceListener<V>::ProcessAdd(V &data)
+{
+	Enqueue(ADD_EVENT, data);
+}
+
+template <typename V>
+void AsyncServiceListener<V>::ProcessRemove(V &data)
+{
+	Enqueue(REMOVE_EVENT, data);
+}
+
+template <typename V>
+void AsyncServiceListener<V>::ProcessUpdate(V &data)
+{
+	Enqueue(UPDATE_EVENT, data);
+}
+
+template <typename V>
+void AsyncServiceListener<V>::Flush()
+{
+	while (processed.load(std::memory_order_acquire) < enqueued.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+template <typename V>
+void AsyncServiceListener<V>::Stop()
+{
+	running.store(false, std::memory_order_release);
+	if (worker.joinable())
+		worker.join();
+}
+
+template <typename V>
+std::size_t AsyncServiceListener<V>::GetQueueDepth() const
+{
+	return queue.Size();
+}
+
+#endif // !AsyncServiceListener_hpp
@@ -0,0 +1,191 @@
+// ConsolidatedBookBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Benchmark of the consolidated multi-venue order book:
+// incremental price level updates of many products on the 3 venues applied through the bond market data service,
+// and a check of the consolidated books against the sum of the venue books
+
+#ifndef ConsolidatedBookBenchmark_hpp
+#define ConsolidatedBookBenchmark_hpp
+
+#include "BondService/BondMarketDataSoa.hpp"
+#include "productservice.hpp"
+#include "OrderBookUpdate.hpp"
+#include "StopWatch.hpp"
+#include "boost/date_time/gregorian/gregorian.hpp"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+// Listener counting the deltas and the moves of the top of the book
+class ConsolidatedBookBenchmarkListener : public ServiceListener<OrderBookDelta<Bond>>
+{
+public:
+	long deltas = 0;
+	long topOfBookChanges = 0;
+	long levels = 0;
+
+	// Listener callback to process an add event to the Service
+	virtual void ProcessAdd(OrderBookDelta<Bond> &data) {} // not defined for the benchmark
+
+	// Listener callback to process a remove event to the Service
+	virtual void ProcessRemove(OrderBookDelta<Bond> &data) {} // not defined for the benchmark
+
+	// Listener callback to process an update event to the Service
+	virtual void ProcessUpdate(OrderBookDelta<Bond> &data)
+	{
+		deltas++;
+		levels += data.GetSize();
+		if (data.IsTopOfBookChanged()) topOfBookChanges++;
+	}
+};
+
+// Check the consolidated book of a product against the sum of its venue books, return the number of mismatches
+long consolidated_book_validate(BondMarketDataService &service, const std::string &productId);
+
+// Apply nUpdates incremental updates of nProducts products on the 3 venues (one price level modified,
+// or the book moved by a tick, per update) and print the throughput
+void consolidated_book_benchmark(long nProducts, long nUpdates, std::ostream &out = std::cout);
+
+long consolidated_book_validate(BondMarketDataService &service, const std::string &productId)
+{
+	const ConsolidatedOrderBook<> &consolidated = service.GetConsolidatedBook(productId);
+	long mismatches = 0;
+	PricingSide sides[2] = { BID, OFFER };
+	for (PricingSide side : sides)
+	{
+		// every venue level is in the consolidated book with its venue quantity
+		long venueLevels = 0;
+		for (int k = 0; k < NUM_MARKETS; k++)
+		{
+			const FixedDepthOrderBook<Bond> &venuebook = service.GetLevelBook(productId, Market(k));
+			for (int i = 0; i < venuebook.GetDepth(side); i++, venueLevels++)
+			{
+				int j = 0;
+				while (j < consolidated.GetDepth(side) && consolidated.GetPrice(side, j) != venuebook.GetPrice(side, i))
+					j++;
+				if (j == consolidated.GetDepth(side) || consolidated.GetVenueQuantity(side, j, Market(k)) != venuebook.GetQuantity(side, i))
+					mismatches++;
+			}
+		}
+
+		// every consolidated level is sorted and sums its venues
+		long consolidatedLevels = 0;
+		for (int j = 0; j < consolidated.GetDepth(side); j++)
+		{
+			long total = 0;
+			for (int k = 0; k < NUM_MARKETS; k++)
+			{
+				total += consolidated.GetVenueQuantity(side, j, Market(k));
+				if (consolidated.GetVenueQuantity(side, j, Market(k)) > 0) consolidatedLevels++;
+			}
+			if (total != consolidated.GetQuantity(side, j))
+				mismatches++;
+			if (j > 0 && ((side == BID) ? consolidated.GetPrice(side, j) >= consolidated.GetPrice(side, j - 1)
+				: consolidated.GetPrice(side, j) <= consolidated.GetPrice(side, j - 1)))
+				mismatches++;
+		}
+		if (consolidatedLevels != venueLevels)
+			mismatches++;
+	}
+	return mismatches;
+}
+
+void consolidated_book_benchmark(long nProducts, long nUpdates, std::ostream &out)
+{
+	if (nProducts <= 0)
+	{
+		std::cout << "Oh no! No product to run the consolidated book benchmark on!\n";
+		return;
+	}
+
+	// the products (synthetic CUSIPs), registered for their product handles
+	BondProductService bondProductService;
+	std::vector<std::string> productIds;
+	for (long p = 0; p < nProducts; p++)
+	{
+		std::stringstream ss;
+		ss << "BENCH" << std::setfill('0') << std::setw(4) << p;
+		productIds.push_back(ss.str());
+		Bond bond(productIds.back(), CUSIP, "T", 2.0, boost::gregorian::date(2027, Nov, 15));
+		bondProductService.Add(bond);
+	}
+
+	BondMarketDataService service(&bondProductService);
+	ConsolidatedBookBenchmarkListener listener;
+	service.AddDeltaListener(&listener);
+
+	// the state of the book of each product on each venue: mid in ticks (the venues quote a tick apart)
+	long nBooks = nProducts * NUM_MARKETS;
+	std::vector<long> mids(nBooks);
+	std::vector<long> moves(nBooks, 0);
+	for (long b = 0; b < nBooks; b++)
+		mids[b] = 99 * TickPrice::TICKS_PER_UNIT + b % NUM_MARKETS;
+
+	const size_t batchSize = 1024;
+	std::vector<MarketDataUpdate<Bond>> batch(batchSize);
+	StopWatch sw;
+	double seconds = 0.0;
+	long generated = 0;
+
+	// the first update of each book adds its 5 levels a side
+	while (generated < nUpdates)
+	{
+		size_t n = 0;
+		for (; n < batchSize && generated < nUpdates; n++, generated++)
+		{
+			long b = generated % nBooks;
+			const Bond &bond = bondProductService.GetData(productIds[b / NUM_MARKETS]);
+			MarketDataUpdate<Bond> &update = batch[n];
+			update.Reset(&bond, Market(b % NUM_MARKETS));
+			long mid = mids[b];
+			if (generated < nBooks) // the initial book
+			{
+				for (long i = 1; i <= 5; i++)
+				{
+					update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, BID, TickPrice::FromTicks(mid - i), 1000000 * i));
+					update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, OFFER, TickPrice::FromTicks(mid + i), 1000000 * i));
+				}
+			}
+			else if ((generated / nBooks) % 2 == 0) // one level modified
+			{
+				long i = 1 + (generated / nBooks) % 5;
+				PricingSide side = (generated % 2 == 0) ? BID : OFFER;
+				TickPrice price = TickPrice::FromTicks((side == BID) ? mid - i : mid + i);
+				update.AddLevelUpdate(PriceLevelUpdate(MODIFY_LEVEL, side, price, 1000000 * (1 + generated % 7)));
+			}
+			else // the book moved by a tick (up for 256 moves, then down)
+			{
+				bool up = (moves[b]++ / 256) % 2 == 0;
+				long step = up ? 1 : -1;
+				update.AddLevelUpdate(PriceLevelUpdate(DELETE_LEVEL, up ? BID : OFFER, TickPrice::FromTicks(up ? mid - 5 : mid + 5), 0));
+				update.AddLevelUpdate(PriceLevelUpdate(DELETE_LEVEL, up ? OFFER : BID, TickPrice::FromTicks(up ? mid + 1 : mid - 1), 0));
+				update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, up ? BID : OFFER, TickPrice::FromTicks(mid), 1000000));
+				update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, up ? OFFER : BID, TickPrice::FromTicks(mid + 6 * step), 5000000));
+				mids[b] = mid + step;
+			}
+		}
+
+		sw.Reset();
+		sw.StartStopWatch();
+		service.OnUpdateBatch(batch.data(), n);
+		sw.StopStopWatch();
+		seconds += sw.GetTime();
+	}
+
+	long mismatches = 0;
+	for (auto &productId : productIds)
+		mismatches += consolidated_book_validate(service, productId);
+	if (mismatches > 0)
+		std::cout << "Oh no! The consolidated books do not match the venue books (" << mismatches << " mismatches)!\n";
+
+	out << "Consolidated book of " << nProducts << " products x " << NUM_MARKETS << " venues: "
+		<< generated << " updates (" << listener.levels << " levels changed, " << listener.topOfBookChanges
+		<< " top of book moves) in " << seconds << " seconds ("
+		<< static_cast<long>((seconds > 0) ? generated / seconds : 0.0) << " updates/s, " << mismatches << " mismatches)\n";
+}
+
+#endif // !ConsolidatedBookBenchmark_hpp
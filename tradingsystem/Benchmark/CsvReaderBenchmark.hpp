@@ -0,0 +1,119 @@
+// CsvReaderBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Benchmark of the parsing of an input csv file:
+// getline + stringstream + boost::trim into a vector of strings (the former connectors)
+// against the memory-mapped zero-copy reader, and the parallel chunked reader on 1, 2, 4 and 8 threads
+
+#ifndef CsvReaderBenchmark_hpp
+#define CsvReaderBenchmark_hpp
+
+#include "CsvReader.hpp"
+#include "ParallelCsvReader.hpp"
+#include "StopWatch.hpp"
+#include "boost/algorithm/string.hpp"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+// Print the throughput of one way of parsing
+void csv_reader_benchmark_report(std::ostream &out, const std::string &name, long rows, double megabytes, double seconds);
+
+// Parse the csv file at path both ways (touching every field) and print the throughput
+void csv_reader_benchmark(const std::string &path, std::ostream &out = std::cout);
+
+void csv_reader_benchmark_report(std::ostream &out, const std::string &name, long rows, double megabytes, double seconds)
+{
+	out << "  " << name << ": " << rows << " rows in " << seconds << " seconds ("
+		<< ((seconds > 0) ? megabytes / seconds : 0.0) << " MB/s, "
+		<< static_cast<long>((seconds > 0) ? rows / seconds : 0.0) << " rows/s)\n";
+}
+
+void csv_reader_benchmark(const std::string &path, std::ostream &out)
+{
+	StopWatch sw;
+
+	// (a) getline + stringstream + trim
+	std::fstream file(path, std::ios::in);
+	if (!file.is_open())
+	{
+		std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+		return;
+	}
+	std::string line;
+	long rows = 0;
+	std::size_t checksum = 0; // total size of the fields, keeps the work observable
+	sw.StartStopWatch();
+	getline(file, line); // discard header
+	while (getline(file, line))
+	{
+		std::stringstream sin(line);
+		std::vector<std::string> tempData;
+		std::string info;
+		while (getline(sin, info, ','))
+		{
+			boost::algorithm::trim(info);
+			tempData.push_back(info);
+		}
+		for (auto &field : tempData)
+			checksum += field.size();
+		rows++;
+	}
+	sw.StopStopWatch();
+	double getlineSeconds = sw.GetTime();
+	long getlineRows = rows;
+	std::size_t getlineChecksum = checksum;
+
+	// (b) memory-mapped reader
+	sw.Reset();
+	rows = 0;
+	checksum = 0;
+	sw.StartStopWatch();
+	CsvReader reader(path);
+	while (reader.NextRow())
+	{
+		for (std::size_t i = 0; i < reader.GetFieldCount(); i++)
+			checksum += reader.GetField(i).size();
+		rows++;
+	}
+	sw.StopStopWatch();
+	double readerSeconds = sw.GetTime();
+
+	if (rows != getlineRows || checksum != getlineChecksum)
+		std::cout << "Oh no! The memory-mapped reader does not parse the same fields as getline!\n";
+
+	double megabytes = reader.GetBytes() / (1024.0 * 1024.0);
+	out << "Csv parsing of " << path << " (" << megabytes << " MB)\n";
+	csv_reader_benchmark_report(out, "getline + stringstream", getlineRows, megabytes, getlineSeconds);
+	csv_reader_benchmark_report(out, "memory-mapped reader", rows, megabytes, readerSeconds);
+	out << "  speedup " << ((readerSeconds > 0) ? getlineSeconds / readerSeconds : 0.0) << "x\n";
+
+	// (c) parallel chunked reader (the records are the field sizes of each row, handed over in file order)
+	for (std::size_t threads = 1; threads <= 8; threads *= 2)
+	{
+		ParallelCsvReader<std::size_t> parallelReader(path, threads);
+		std::size_t parallelChecksum = 0;
+		parallelReader.Run([](CsvReader &chunk, std::vector<std::size_t> &sizes) {
+			while (chunk.NextRow())
+			{
+				std::size_t size = 0;
+				for (std::size_t i = 0; i < chunk.GetFieldCount(); i++)
+					size += chunk.GetField(i).size();
+				sizes.push_back(size);
+			}
+		}, [&parallelChecksum](std::vector<std::size_t> &sizes) {
+			for (std::size_t size : sizes)
+				parallelChecksum += size;
+		});
+		if (parallelReader.GetRowCount() != rows || parallelChecksum != checksum)
+			std::cout << "Oh no! The parallel reader does not parse the same fields as the memory-mapped reader!\n";
+		std::ostringstream name;
+		name << "parallel reader, " << threads << " threads";
+		parallelReader.Report(out << "  ", name.str());
+	}
+}
+
+#endif // !CsvReaderBenchmark_hpp
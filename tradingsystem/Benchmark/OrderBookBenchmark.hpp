@@ -0,0 +1,114 @@
+// OrderBookBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Benchmark of the order book:
+// OrderBook<Bond> (vectors of orders, linear scan for the best bid/offer)
+// against the fixed-depth inline FixedDepthOrderBook<Bond>
+
+#ifndef OrderBookBenchmark_hpp
+#define OrderBookBenchmark_hpp
+
+#include "marketdataservice.hpp"
+#include "FixedDepthOrderBook.hpp"
+#include "products.hpp"
+#include "StopWatch.hpp"
+#include <vector>
+#include <iostream>
+
+// Print the throughput of one order book
+void order_book_benchmark_report(std::ostream &out, const std::string &name, long nBooks, double seconds);
+
+// Apply nBooks market data snapshots (5 levels a side, as in the generated data) to both order books,
+// query the best bid/offer after each of them, and print the results
+void order_book_benchmark(const std::vector<Bond> &bonds, long nBooks, std::ostream &out = std::cout);
+
+void order_book_benchmark_report(std::ostream &out, const std::string &name, long nBooks, double seconds)
+{
+	out << "  " << name << ": " << nBooks << " books in " << seconds << " seconds ("
+		<< static_cast<long>((seconds > 0) ? nBooks / seconds : 0.0) << " books/s)\n";
+}
+
+void order_book_benchmark(const std::vector<Bond> &bonds, long nBooks, std::ostream &out)
+{
+	if (bonds.empty())
+	{
+		std::cout << "Oh no! No product to run the order book benchmark on!\n";
+		return;
+	}
+
+	// generate the snapshots in memory (oscillating mid, spreads from 1/128 to 5/128)
+	std::vector<OrderBook<Bond>> snapshots;
+	snapshots.reserve(nBooks);
+	for (long i = 0; i < nBooks; i++)
+	{
+		TickPrice mid = TickPrice::FromTicks(99 * TickPrice::TICKS_PER_UNIT + i % 512);
+		long tightest = (i % 4 < 2) ? 2 : 4;
+		std::vector<Order> bidOrders;
+		std::vector<Order> offerOrders;
+		for (int k = 1; k <= 5; k++)
+		{
+			TickPrice spread = TickPrice::FromTicks(tightest + 2 * (k - 1));
+			bidOrders.push_back(Order(mid - spread, 1000000 * k, BID));
+			offerOrders.push_back(Order(mid + spread, 1000000 * k, OFFER));
+		}
+		snapshots.push_back(OrderBook<Bond>(bonds[i % bonds.size()], bidOrders, offerOrders));
+	}
+
+	StopWatch sw;
+	long checksum = 0; // sum of the best prices and quantities, keeps the work observable
+
+	// (a) OrderBook<Bond>: store a copy, scan both stacks for the best bid/offer
+	OrderBook<Bond> stored;
+	sw.StartStopWatch();
+	for (long i = 0; i < nBooks; i++)
+	{
+		stored = snapshots[i];
+		BidOffer bidOffer = stored.GetBestBidOffer();
+		checksum += bidOffer.GetBidOrder().GetPrice().GetTicks() + bidOffer.GetOfferOrder().GetQuantity();
+	}
+	sw.StopStopWatch();
+	double vectorSeconds = sw.GetTime();
+	long vectorChecksum = checksum;
+
+	// (b) FixedDepthOrderBook<Bond>: rebuild the sorted levels in place, read level 0
+	sw.Reset();
+	checksum = 0;
+	FixedDepthOrderBook<Bond> book(&bonds[0]);
+	sw.StartStopWatch();
+	for (long i = 0; i < nBooks; i++)
+	{
+		book.Assign(snapshots[i]);
+		BidOffer bidOffer = book.GetBestBidOffer();
+		checksum += bidOffer.GetBidOrder().GetPrice().GetTicks() + bidOffer.GetOfferOrder().GetQuantity();
+	}
+	sw.StopStopWatch();
+	double fixedSeconds = sw.GetTime();
+
+	if (checksum != vectorChecksum)
+		std::cout << "Oh no! The fixed-depth order book does not give the same best bid/offer!\n";
+
+	// (c) FixedDepthOrderBook<Bond>: one level modified per message instead of a whole snapshot
+	sw.Reset();
+	checksum = 0;
+	sw.StartStopWatch();
+	for (long i = 0; i < nBooks; i++)
+	{
+		PricingSide side = (i % 2 == 0) ? BID : OFFER;
+		int level = static_cast<int>(i % book.GetDepth(side));
+		book.ModifyLevel(side, book.GetPrice(side, level), 1000000 * (1 + i % 5));
+		BidOffer bidOffer = book.GetBestBidOffer();
+		checksum += bidOffer.GetBidOrder().GetPrice().GetTicks() + bidOffer.GetOfferOrder().GetQuantity();
+	}
+	sw.StopStopWatch();
+	double levelSeconds = sw.GetTime();
+
+	out << "Order book of 5 levels a side, best bid/offer after each update (checksum " << vectorChecksum + checksum << ")\n";
+	order_book_benchmark_report(out, "OrderBook<Bond> snapshot", nBooks, vectorSeconds);
+	order_book_benchmark_report(out, "FixedDepthOrderBook<Bond> snapshot", nBooks, fixedSeconds);
+	order_book_benchmark_report(out, "FixedDepthOrderBook<Bond> level update", nBooks, levelSeconds);
+	out << "  speedup " << ((fixedSeconds > 0) ? vectorSeconds / fixedSeconds : 0.0) << "x (snapshot), "
+		<< ((levelSeconds > 0) ? vectorSeconds / levelSeconds : 0.0) << "x (level update)\n";
+}
+
+#endif // !OrderBookBenchmark_hpp
@@ -0,0 +1,149 @@
+// PipelineBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Benchmark of the price line (algo streaming ==> streaming ==> historical data):
+// the runtime chain of virtual service listeners against the same hops fused as a static pipeline
+
+#ifndef PipelineBenchmark_hpp
+#define PipelineBenchmark_hpp
+
+#include "BondService/BondAlgoStreamingSoa.hpp"
+#include "BondService/BondStreamingSoa.hpp"
+#include "BondService/HistoricalDataSoa/BondStreamingHistoricalDataSoa.hpp"
+#include "StaticPipeline.hpp"
+#include "StopWatch.hpp"
+#include <vector>
+#include <iostream>
+
+// Publish connector which only counts the data, so that the benchmark measures the dispatch and not the I/O
+class PipelineBenchmarkConnector : public Connector<PriceStream<Bond>>
+{
+protected:
+	long counter = 0;
+	double checksum = 0.0;
+
+public:
+	PipelineBenchmarkConnector() {} // empty ctor
+
+	// Publish data to the Connector
+	virtual void Publish(PriceStream<Bond> &data);
+
+	// Publish a batch of data to the Connector
+	virtual void PublishBatch(PriceStream<Bond> *data, size_t size);
+
+	// Get the # of data published
+	long GetRecordCount() const;
+
+	// Get the sum of the published bid prices (keeps the work observable)
+	double GetChecksum() const;
+};
+
+// Time pushing the prices through a price line listener, one by one or in batches of batchSize (0 = one by one)
+// and return the number of nanoseconds per price
+double pipeline_benchmark_run(ServiceListener<Price<Bond>> *listener, std::vector<Price<Bond>> &prices, size_t batchSize);
+
+// Run the benchmark over the given products with nPrices prices, and print the results
+void pipeline_benchmark(const std::vector<Bond> &bonds, long nPrices, std::ostream &out = std::cout);
+
+void PipelineBenchmarkConnector::Publish(PriceStream<Bond> &data)
+{
+	counter++;
+	checksum += data.GetBidOrder().GetPrice().ToDouble();
+}
+
+void PipelineBenchmarkConnector::PublishBatch(PriceStream<Bond> *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		Publish(data[i]);
+}
+
+long PipelineBenchmarkConnector::GetRecordCount() const
+{
+	return counter;
+}
+
+double PipelineBenchmarkConnector::GetChecksum() const
+{
+	return checksum;
+}
+
+double pipeline_benchmark_run(ServiceListener<Price<Bond>> *listener, std::vector<Price<Bond>> &prices, size_t batchSize)
+{
+	StopWatch sw;
+	sw.StartStopWatch();
+	if (batchSize == 0)
+	{
+		for (auto &price : prices)
+			listener->ProcessAdd(price);
+	}
+	else
+	{
+		for (size_t i = 0; i < prices.size(); i += batchSize)
+		{
+			size_t size = (prices.size() - i < batchSize) ? prices.size() - i : batchSize;
+			listener->ProcessAddBatch(&prices[i], size);
+		}
+	}
+	sw.StopStopWatch();
+	return (prices.size() > 0) ? sw.GetTime() * 1e9 / prices.size() : 0.0;
+}
+
+void pipeline_benchmark(const std::vector<Bond> &bonds, long nPrices, std::ostream &out)
+{
+	if (bonds.empty())
+	{
+		std::cout << "Oh no! No product to run the pipeline benchmark on!\n";
+		return;
+	}
+
+	// generate the prices in memory (oscillating mid, spread between 1/128 and 1/64)
+	std::vector<Price<Bond>> prices;
+	prices.reserve(nPrices);
+	for (long i = 0; i < nPrices; i++)
+	{
+		TickPrice mid = TickPrice::FromTicks(99 * TickPrice::TICKS_PER_UNIT + i % 512);
+		TickPrice spread = TickPrice::FromTicks((i % 2 == 0) ? 2 : 4);
+		prices.push_back(Price<Bond>(bonds[i % bonds.size()], mid, spread));
+	}
+
+	// (a) runtime chain of virtual service listeners
+	PipelineBenchmarkConnector virtualConnector;
+	BondAlgoStreamingService virtualAlgoStreamingService;
+	BondAlgoStreamingListener virtualAlgoStreamingListener(&virtualAlgoStreamingService);
+	BondStreamingService virtualStreamingService;
+	BondStreamingListener virtualStreamingListener(&virtualStreamingService);
+	BondStreamingHistoricalDataService virtualHistoricalDataService(&virtualConnector);
+	BondStreamingHistoricalDataListener virtualHistoricalDataListener(&virtualHistoricalDataService);
+	virtualAlgoStreamingService.AddListener(&virtualStreamingListener);
+	virtualStreamingService.AddListener(&virtualHistoricalDataListener);
+
+	// (b) the same hops fused as a static pipeline
+	PipelineBenchmarkConnector fusedConnector;
+	BondAlgoStreamingService fusedAlgoStreamingService;
+	BondStreamingService fusedStreamingService;
+	BondStreamingHistoricalDataService fusedHistoricalDataService(&fusedConnector);
+	auto pipeline = MakePipeline(BondAlgoStreamingStage(&fusedAlgoStreamingService),
+		BondStreamingStage(&fusedStreamingService), BondStreamingHistoricalDataStage(&fusedHistoricalDataService));
+	StaticPipelineListener<Price<Bond>, decltype(pipeline)> fusedListener(&pipeline);
+
+	// warm up the maps, then time the one-by-one and the batched dispatch
+	pipeline_benchmark_run(&virtualAlgoStreamingListener, prices, 0);
+	pipeline_benchmark_run(&fusedListener, prices, 0);
+	double virtualSingle = pipeline_benchmark_run(&virtualAlgoStreamingListener, prices, 0);
+	double fusedSingle = pipeline_benchmark_run(&fusedListener, prices, 0);
+	double virtualBatch = pipeline_benchmark_run(&virtualAlgoStreamingListener, prices, 1024);
+	double fusedBatch = pipeline_benchmark_run(&fusedListener, prices, 1024);
+
+	if (virtualConnector.GetRecordCount() != fusedConnector.GetRecordCount() ||
+		virtualConnector.GetChecksum() != fusedConnector.GetChecksum())
+		std::cout << "Oh no! The fused pipeline does not publish the same data as the virtual chain!\n";
+
+	out << "Price line, " << nPrices << " prices over " << bonds.size() << " products\n";
+	out << "  one by one: virtual chain " << virtualSingle << " ns/price, fused pipeline " << fusedSingle
+		<< " ns/price (speedup " << ((fusedSingle > 0) ? virtualSingle / fusedSingle : 0.0) << "x)\n";
+	out << "  batch of 1024: virtual chain " << virtualBatch << " ns/price, fused pipeline " << fusedBatch
+		<< " ns/price (speedup " << ((fusedBatch > 0) ? virtualBatch / fusedBatch : 0.0) << "x)\n";
+}
+
+#endif // !PipelineBenchmark_hpp
@@ -0,0 +1,140 @@
+// PriceNotationBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Validation and benchmark of the fractional price notation 99-xyz:
+// StringtoPrice / PricetoString against the allocation-free BuffertoPrice / PricetoBuffer
+
+#ifndef PriceNotationBenchmark_hpp
+#define PriceNotationBenchmark_hpp
+
+#include "utilityfunction.hpp"
+#include "StopWatch.hpp"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+// Check the new functions against StringtoPrice / PricetoString, return the number of mismatches
+long price_notation_validate(std::ostream &out = std::cout);
+
+// Time the parsing and the formatting of nPrices prices both ways, and print the results
+void price_notation_benchmark(long nPrices, std::ostream &out = std::cout);
+
+long price_notation_validate(std::ostream &out)
+{
+	std::stringstream ss;
+	char buffer[32];
+	long mismatches = 0;
+	long checked = 0;
+
+	// every tick from 0-000 to 199-31+ (and 199-317)
+	for (long ticks = 0; ticks < 200 * 256; ticks++, checked++)
+	{
+		double price = ticks / 256.0;
+		std::string expected = PricetoString(price);
+		std::size_t size = PricetoBuffer(price, buffer);
+		if (expected != std::string(buffer, size))
+		{
+			if (mismatches++ < 5) out << "  format mismatch: " << expected << " vs " << buffer << "\n";
+			continue;
+		}
+		if (StringtoPrice<double>(ss, expected) != BuffertoPrice(buffer, size))
+		{
+			if (mismatches++ < 5) out << "  parse mismatch: " << expected << "\n";
+		}
+	}
+
+	// prices between the ticks are truncated to the tick below
+	for (long i = 0; i < 100000; i++, checked++)
+	{
+		double price = 90.0 + i * 0.000173;
+		if (PricetoString(price) != std::string(buffer, PricetoBuffer(price, buffer)))
+		{
+			if (mismatches++ < 5) out << "  format mismatch: " << PricetoString(price) << " vs " << buffer << "\n";
+		}
+	}
+
+	// the batch variant against the single one, including malformed fields
+	std::vector<std::string> fields = { "99-000", "100-31+", "99-16+", "0-002", "99-32+", "99-1", "9a-001", "99-008" };
+	std::vector<double> prices(fields.size());
+	BuffertoPriceBatch(fields.data(), fields.size(), prices.data());
+	for (std::size_t i = 0; i < fields.size(); i++, checked++)
+	{
+		double single = BuffertoPrice(fields[i].data(), fields[i].size());
+		bool same = (single == prices[i]) || (single != single && prices[i] != prices[i]); // NaN for the malformed
+		if (!same && mismatches++ < 5) out << "  batch mismatch: " << fields[i] << "\n";
+	}
+	long ticks;
+	for (std::size_t i = 4; i < fields.size(); i++, checked++) // the malformed ones
+	{
+		if (BuffertoTicks(fields[i].data(), fields[i].size(), ticks) && mismatches++ < 5)
+			out << "  accepted a malformed price: " << fields[i] << "\n";
+	}
+
+	out << "Price notation: " << checked << " checks, " << mismatches << " mismatches\n";
+	return mismatches;
+}
+
+void price_notation_benchmark(long nPrices, std::ostream &out)
+{
+	// the price strings, oscillating around par as in the generated data
+	std::vector<double> prices(nPrices);
+	std::vector<std::string> priceStrs(nPrices);
+	for (long i = 0; i < nPrices; i++)
+	{
+		prices[i] = 99.0 + (i % 512) / 256.0;
+		priceStrs[i] = PricetoString(prices[i]);
+	}
+	std::vector<double> output(nPrices);
+	std::stringstream ss;
+	char buffer[32];
+	StopWatch sw;
+	double checksum = 0.0;
+	std::size_t length = 0;
+
+	sw.StartStopWatch();
+	for (long i = 0; i < nPrices; i++)
+		output[i] = StringtoPrice<double>(ss, priceStrs[i]);
+	sw.StopStopWatch();
+	double parseOld = sw.GetTime();
+	checksum += output[nPrices - 1];
+
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nPrices; i++)
+		output[i] = BuffertoPrice(priceStrs[i].data(), priceStrs[i].size());
+	sw.StopStopWatch();
+	double parseNew = sw.GetTime();
+	checksum += output[nPrices - 1];
+
+	sw.Reset();
+	sw.StartStopWatch();
+	BuffertoPriceBatch(priceStrs.data(), priceStrs.size(), output.data());
+	sw.StopStopWatch();
+	double parseBatch = sw.GetTime();
+	checksum += output[nPrices - 1];
+
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nPrices; i++)
+		length += PricetoString(prices[i]).size();
+	sw.StopStopWatch();
+	double formatOld = sw.GetTime();
+
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nPrices; i++)
+		length += PricetoBuffer(prices[i], buffer);
+	sw.StopStopWatch();
+	double formatNew = sw.GetTime();
+
+	double scale = (nPrices > 0) ? 1e9 / nPrices : 0.0;
+	out << "Price notation, " << nPrices << " prices (checksum " << checksum << ", " << length << " characters)\n";
+	out << "  parse: StringtoPrice " << parseOld * scale << " ns, BuffertoPrice " << parseNew * scale
+		<< " ns, BuffertoPriceBatch " << parseBatch * scale << " ns per price\n";
+	out << "  format: PricetoString " << formatOld * scale << " ns, PricetoBuffer " << formatNew * scale
+		<< " ns per price\n";
+}
+
+#endif // !PriceNotationBenchmark_hpp
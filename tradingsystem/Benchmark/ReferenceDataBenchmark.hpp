@@ -0,0 +1,162 @@
+// ReferenceDataBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Validation and benchmark of the reference data of the bonds:
+// the lookups by identifier and the selections by ticker, maturity range and coupon
+// of a std::map of the bonds (as the BondProductService used to do) against the BondReferenceTable,
+// and the start-up load of a large securities master from its csv file and from its binary image
+
+#ifndef ReferenceDataBenchmark_hpp
+#define ReferenceDataBenchmark_hpp
+
+#include "products.hpp"
+#include "productservice.hpp"
+#include "StopWatch.hpp"
+#include "SecuritiesMaster.hpp"
+#include "Data/BondReferenceDataGenerator.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <map>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdio>
+
+// Register nBonds synthetic bonds, check the selections of the table against scans of a std::map of the bonds,
+// then time nLookups lookups by identifier and a round of selections both ways, and print the results
+void reference_data_benchmark(long nBonds, long nLookups, std::ostream &out = std::cout);
+
+// Write a securities master of nBonds synthetic bonds to path, then time its load from the csv file
+// and from the binary image up to the registration of the bonds, check both loads agree, and print the results
+// (the files are removed afterwards)
+void securities_master_benchmark(long nBonds, const std::string &path, std::ostream &out = std::cout);
+
+void reference_data_benchmark(long nBonds, long nLookups, std::ostream &out)
+{
+	if (nBonds <= 0)
+	{
+		std::cout << "Oh no! No bond to run the reference data benchmark on!\n";
+		return;
+	}
+
+	// synthetic bonds: 8 tickers, monthly maturities over 30 years, coupons by 1/8
+	const char* tickers[] = { "T", "TII", "FNMA", "FHLMC", "GNMA", "CORP", "MUNI", "AGCY" };
+	BondProductService bondProductService;
+	std::map<std::string, Bond> bondMap;
+	std::vector<std::string> productIds;
+	for (long b = 0; b < nBonds; b++)
+	{
+		std::stringstream ss;
+		ss << "RD" << std::setfill('0') << std::setw(7) << b;
+		productIds.push_back(ss.str());
+		boost::gregorian::date maturity = boost::gregorian::date(2018, Jan, 31) + boost::gregorian::months(b % 360);
+		Bond bond(productIds.back(), CUSIP, tickers[b % 8], 0.125f * (b % 48), maturity);
+		bondProductService.Add(bond);
+		bondMap.insert(std::make_pair(bond.GetProductId(), bond));
+	}
+	const BondReferenceTable &table = bondProductService.GetTable();
+
+	// the selections of the benchmark, checked against the scans
+	boost::gregorian::date from(2025, Jan, 1), to(2029, Dec, 31);
+	long mismatches = 0;
+	auto check = [&](const BondView &view, long expected, const char* name) {
+		if (static_cast<long>(view.size()) != expected && mismatches++ < 5)
+			out << "  mismatch: " << view.size() << " bonds " << name << " vs " << expected << "\n";
+	};
+	long byTicker = 0, byMaturity = 0, byCoupon = 0;
+	for (auto iter = bondMap.begin(); iter != bondMap.end(); iter++)
+	{
+		byTicker += iter->second.GetTicker() == "FNMA";
+		byMaturity += iter->second.GetMaturityDate() >= from && iter->second.GetMaturityDate() <= to;
+		byCoupon += iter->second.GetCoupon() >= 2.0f && iter->second.GetCoupon() <= 3.0f;
+	}
+	check(table.GetByTicker("FNMA"), byTicker, "of the ticker");
+	check(table.GetByMaturity(from, to), byMaturity, "in the maturity range");
+	check(table.GetByCoupon(2.0f, 3.0f), byCoupon, "in the coupon range");
+	for (long b = 0; b < nBonds; b++)
+	{
+		const Bond* bond = table.Find(productIds[b]);
+		if ((bond == nullptr || bond->GetHandle() != b) && mismatches++ < 5)
+			out << "  mismatch: bond " << productIds[b] << " not found by its identifier\n";
+	}
+	out << "Reference data: " << nBonds << " bonds, " << mismatches << " mismatches\n";
+
+	// lookups by identifier
+	StopWatch sw;
+	long found = 0;
+	sw.StartStopWatch();
+	for (long i = 0; i < nLookups; i++)
+		found += bondMap.find(productIds[(i * 7919) % nBonds])->second.GetHandle() >= 0;
+	sw.StopStopWatch();
+	double mapSeconds = sw.GetTime();
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nLookups; i++)
+		found += table.Find(productIds[(i * 7919) % nBonds])->GetHandle() >= 0;
+	sw.StopStopWatch();
+	double tableSeconds = sw.GetTime();
+	sw.Reset();
+	out << "Reference data: " << nLookups << " lookups in " << mapSeconds << " seconds (std::map) vs "
+		<< tableSeconds << " seconds (hash table), " << found << " found\n";
+
+	// the selections: copies of the matching bonds out of a scan against views of the sorted indexes
+	long selected = 0;
+	sw.StartStopWatch();
+	{
+		std::vector<Bond> ticker, maturity, coupon;
+		for (auto iter = bondMap.begin(); iter != bondMap.end(); iter++)
+		{
+			if (iter->second.GetTicker() == "FNMA") ticker.push_back(iter->second);
+			if (iter->second.GetMaturityDate() >= from && iter->second.GetMaturityDate() <= to) maturity.push_back(iter->second);
+			if (iter->second.GetCoupon() >= 2.0f && iter->second.GetCoupon() <= 3.0f) coupon.push_back(iter->second);
+		}
+		selected += ticker.size() + maturity.size() + coupon.size();
+	}
+	sw.StopStopWatch();
+	double scanSeconds = sw.GetTime();
+	sw.Reset();
+	sw.StartStopWatch();
+	selected += table.GetByTicker("FNMA").size() + table.GetByMaturity(from, to).size() + table.GetByCoupon(2.0f, 3.0f).size();
+	sw.StopStopWatch();
+	double viewSeconds = sw.GetTime();
+	out << "Reference data: selections by ticker, maturity and coupon in " << scanSeconds << " seconds (scan and copies) vs "
+		<< viewSeconds << " seconds (index views), " << selected << " bonds selected\n";
+}
+void securities_master_benchmark(long nBonds, const std::string &path, std::ostream &out)
+{
+	bond_reference_generator(path, nBonds);
+
+	// load from the csv file (the image is written), then from the image, each time up to a usable product service
+	double seconds[2];
+	std::size_t sizes[2];
+	float coupons[2] = { 0.0f, 0.0f };
+	for (int round = 0; round < 2; round++)
+	{
+		StopWatch sw;
+		sw.StartStopWatch();
+		SecuritiesMaster securitiesMaster;
+		if (!securitiesMaster.Load(path, true))
+		{
+			std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+			return;
+		}
+		BondProductService bondProductService;
+		securitiesMaster.AddBonds(bondProductService);
+		sizes[round] = bondProductService.GetSize(); // builds the table
+		sw.StopStopWatch();
+		seconds[round] = sw.GetTime();
+		for (const Bond &bond : bondProductService.GetBonds("SYN"))
+			coupons[round] += bond.GetCoupon();
+		securitiesMaster.Report(out);
+	}
+	long mismatches = (sizes[0] != sizes[1]) + (coupons[0] != coupons[1]);
+	out << "Securities master: " << sizes[1] << " bonds registered in " << seconds[0] * 1000 << " ms (csv file) vs "
+		<< seconds[1] * 1000 << " ms (binary image), " << mismatches << " mismatches\n";
+
+	std::remove(path.c_str());
+	std::remove((path + ".bin").c_str());
+}
+
+#endif // !ReferenceDataBenchmark_hpp
@@ -0,0 +1,86 @@
+// SwapScreenBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Validation and benchmark of the attribute queries of the IR Swaps:
+// a scan of the swaps testing each attribute (as the IRSwapProductService used to do)
+// against the AND/OR of the bitmaps of the attributes
+
+#ifndef SwapScreenBenchmark_hpp
+#define SwapScreenBenchmark_hpp
+
+#include "products.hpp"
+#include "productservice.hpp"
+#include "StopWatch.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+
+// Add nSwaps synthetic swaps, check a multi-attribute screen on the bitmaps against a scan,
+// then time nScreens screens both ways, and print the results
+void swap_screen_benchmark(long nSwaps, long nScreens, std::ostream &out = std::cout);
+
+void swap_screen_benchmark(long nSwaps, long nScreens, std::ostream &out)
+{
+	if (nSwaps <= 0)
+	{
+		std::cout << "Oh no! No swap to run the swap screen benchmark on!\n";
+		return;
+	}
+
+	// synthetic swaps, the attributes cycling with different periods
+	IRSwapProductService swapProductService;
+	std::vector<IRSwap> swaps;
+	boost::gregorian::date effective(2017, Nov, 30);
+	for (long s = 0; s < nSwaps; s++)
+	{
+		int termYears = 1 + s % 30;
+		IRSwap swap("SW" + std::to_string(s), DayCountConvention(s % 2), DayCountConvention((s / 2) % 2),
+			PaymentFrequency(s % 3), FloatingIndex((s / 3) % 2), FloatingIndexTenor(s % 4), effective,
+			effective + boost::gregorian::years(termYears), Currency(s % 3), termYears, SwapType(s % 5), SwapLegType((s / 5) % 3));
+		swaps.push_back(swap);
+		swapProductService.Add(swap);
+	}
+
+	// LIBOR swaps paying annually, outright or curve, shorter than 10 years
+	auto scan = [&swaps]() {
+		std::vector<IRSwap> result;
+		for (auto iter = swaps.begin(); iter != swaps.end(); iter++)
+		{
+			if (iter->GetFloatingIndex() == LIBOR && iter->GetFixedLegPaymentFrequency() == ANNUAL
+				&& (iter->GetSwapLegType() == OUTRIGHT || iter->GetSwapLegType() == CURVE) && iter->GetTermYears() < 10)
+				result.push_back(*iter);
+		}
+		return result;
+	};
+	auto screen = [&swapProductService]() {
+		return swapProductService.GetSwaps(swapProductService.Select(LIBOR) & swapProductService.Select(ANNUAL)
+			& (swapProductService.Select(OUTRIGHT) | swapProductService.Select(CURVE)) & swapProductService.SelectLessThan(10));
+	};
+
+	std::vector<IRSwap> expected = scan();
+	std::vector<IRSwap> screened = screen();
+	long mismatches = (expected.size() == screened.size()) ? 0 : 1;
+	for (std::size_t i = 0; mismatches == 0 && i < expected.size(); i++)
+		mismatches += expected[i].GetProductId() != screened[i].GetProductId();
+	out << "Swap screen: " << nSwaps << " swaps, " << screened.size() << " screened, " << mismatches << " mismatches\n";
+
+	StopWatch sw;
+	long selected = 0;
+	sw.StartStopWatch();
+	for (long i = 0; i < nScreens; i++)
+		selected += scan().size();
+	sw.StopStopWatch();
+	double scanSeconds = sw.GetTime();
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nScreens; i++)
+		selected += screen().size();
+	sw.StopStopWatch();
+	double bitmapSeconds = sw.GetTime();
+	out << "Swap screen: " << nScreens << " screens in " << scanSeconds << " seconds (scan) vs "
+		<< bitmapSeconds << " seconds (bitmaps), " << selected << " swaps selected\n";
+}
+
+#endif // !SwapScreenBenchmark_hpp
@@ -0,0 +1,114 @@
+// TimestampBenchmark.hpp
+//
+// Author: Yuchen Liu
+//
+// Validation and benchmark of the time stamp of the output records:
+// boost local_time + DatetoUsString + to_simple_string (as the connectors used to do)
+// against the cached TimestampFormatter
+
+#ifndef TimestampBenchmark_hpp
+#define TimestampBenchmark_hpp
+
+#include "TimestampFormatter.hpp"
+#include "utilityfunction.hpp"
+#include "StopWatch.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/date_time/c_local_time_adjustor.hpp"
+#include <chrono>
+#include <string>
+#include <iostream>
+
+// Format a time stamp the way the connectors used to, from a time in local time
+std::string timestamp_boost_format(const boost::posix_time::ptime &time);
+
+// Check the cached formatter against boost on a range of times, return the number of mismatches
+long timestamp_validate(std::ostream &out = std::cout);
+
+// Time the formatting of nStamps current time stamps both ways, and print the results
+void timestamp_benchmark(long nStamps, std::ostream &out = std::cout);
+
+std::string timestamp_boost_format(const boost::posix_time::ptime &time)
+{
+	std::string date = DatetoUsString(time.date());
+	std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
+	timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+	return date + " " + timeofDay;
+}
+
+long timestamp_validate(std::ostream &out)
+{
+	typedef boost::date_time::c_local_adjustor<boost::posix_time::ptime> local_adjustor;
+	TimestampFormatter formatter;
+	char buffer[TIMESTAMP_LENGTH + 1];
+	long mismatches = 0;
+	long checked = 0;
+
+	// 100000 times about 7.9 ms apart (crossing seconds, minutes and hours), from now
+	long long start = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	for (long i = 0; i < 100000; i++)
+	{
+		long long micros = start + i * 7919LL;
+		if (micros % 1000000 == 0) // boost omits the fraction of a whole second
+			continue;
+		std::chrono::system_clock::time_point time{ std::chrono::microseconds(micros) };
+		boost::posix_time::ptime utc = boost::posix_time::from_time_t(static_cast<std::time_t>(micros / 1000000))
+			+ boost::posix_time::microseconds(micros % 1000000);
+		std::string expected = timestamp_boost_format(local_adjustor::utc_to_local(utc));
+		std::size_t size = formatter.Format(time, buffer);
+		checked++;
+		if (expected != std::string(buffer, size) && mismatches++ < 5)
+			out << "  mismatch: " << expected << " vs " << buffer << "\n";
+	}
+
+	out << "Time stamp: " << checked << " checks, " << mismatches << " mismatches\n";
+	return mismatches;
+}
+
+void timestamp_benchmark(long nStamps, std::ostream &out)
+{
+	TimestampFormatter formatter;
+	char buffer[TIMESTAMP_LENGTH + 1];
+	std::string output; // the output buffer the time stamps are appended to
+	output.reserve(1 << 16);
+	StopWatch sw;
+	std::size_t length = 0;
+
+	sw.StartStopWatch();
+	for (long i = 0; i < nStamps; i++)
+	{
+		auto time = boost::posix_time::microsec_clock::local_time(); // current time
+		std::string date = DatetoUsString(time.date());
+		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
+		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		length += date.size() + 1 + timeofDay.size();
+	}
+	sw.StopStopWatch();
+	double boostTime = sw.GetTime();
+
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nStamps; i++)
+		length += formatter.Format(buffer);
+	sw.StopStopWatch();
+	double cachedTime = sw.GetTime();
+
+	sw.Reset();
+	sw.StartStopWatch();
+	for (long i = 0; i < nStamps; i++)
+	{
+		if (output.size() + TIMESTAMP_LENGTH > output.capacity())
+			output.clear();
+		formatter.AppendTo(output);
+	}
+	sw.StopStopWatch();
+	double appendTime = sw.GetTime();
+	length += output.size();
+
+	double scale = (nStamps > 0) ? 1e9 / nStamps : 0.0;
+	out << "Time stamp, " << nStamps << " stamps (" << length << " characters)\n";
+	out << "  boost local_time + to_simple_string " << boostTime * scale << " ns, TimestampFormatter::Format "
+		<< cachedTime * scale << " ns, TimestampFormatter::AppendTo " << appendTime * scale << " ns per stamp\n";
+}
+
+#endif // !TimestampBenchmark_hpp
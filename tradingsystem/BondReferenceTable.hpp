@@ -0,0 +1,289 @@
+// BondReferenceTable.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the immutable reference data table of the bonds: the bonds are stored contiguously in the order of their handles,
+// found by identifier (CUSIP/ISIN) through an open-addressing hash table, and selected by ticker, maturity range or coupon
+// through sorted secondary indexes, each selection being a view over the table (no bond is copied)
+
+#ifndef BondReferenceTable_hpp
+#define BondReferenceTable_hpp
+
+#include "products.hpp"
+#include "boost/utility/string_view.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+
+// View of a selection of the bonds of a table (e.g. the bonds of a ticker), in the order of its index
+// Valid as long as the table
+class BondView
+{
+public:
+	// Iterator over the bonds of the view
+	class const_iterator : public std::iterator<std::forward_iterator_tag, const Bond>
+	{
+	protected:
+		const Bond* bonds;
+		const ProductHandle* cursor;
+
+	public:
+		const_iterator(const Bond* _bonds, const ProductHandle* _cursor) : bonds(_bonds), cursor(_cursor) {} // ctor
+		const Bond& operator*() const { return bonds[*cursor]; }
+		const Bond* operator->() const { return bonds + *cursor; }
+		const_iterator& operator++() { cursor++; return *this; }
+		const_iterator operator++(int) { const_iterator old(*this); cursor++; return old; }
+		bool operator==(const const_iterator &other) const { return cursor == other.cursor; }
+		bool operator!=(const const_iterator &other) const { return cursor != other.cursor; }
+	};
+
+protected:
+	const Bond* bonds; // the bonds of the table
+	const ProductHandle* first; // the handles of the selected bonds are [first, last)
+	const ProductHandle* last;
+
+public:
+	BondView(); // empty view
+	BondView(const Bond* _bonds, const ProductHandle* _first, const ProductHandle* _last); // ctor
+
+	// Get the # of bonds of the view
+	std::size_t size() const;
+
+	// Whether the view has no bond
+	bool empty() const;
+
+	// Get the i-th bond of the view
+	const Bond& operator[](std::size_t i) const;
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	// Get the view of the first n bonds of the view (all of them if there are fewer)
+	BondView First(std::size_t n) const;
+};
+
+// Immutable table of the reference data of the bonds, built at once from the registered bonds
+class BondReferenceTable
+{
+protected:
+	std::vector<Bond> bonds; // indexed by handle
+	std::vector<ProductHandle> slots; // open-addressing hash table of the handles by identifier (NO_PRODUCT_HANDLE if free)
+	std::vector<ProductHandle> byTicker; // handles sorted by ticker, then by identifier
+	std::vector<ProductHandle> byMaturity; // handles sorted by maturity date, then by identifier
+	std::vector<ProductHandle> byCoupon; // handles sorted by coupon, then by identifier
+
+	// FNV-1a hash of an identifier
+	static std::uint64_t Hash(const boost::string_view &productId);
+
+	// Get the slot of an identifier: the slot holding its handle, or the free slot it would be stored in
+	std::size_t FindSlot(const boost::string_view &productId) const;
+
+public:
+	// ctor, the handle of each bond is set to its position (the identifiers are expected to be unique)
+	BondReferenceTable(const std::vector<Bond> &_bonds);
+
+	// Get the # of bonds
+	std::size_t GetSize() const;
+
+	// Find the bond of an identifier, nullptr if there is none
+	const Bond* Find(const boost::string_view &productId) const;
+
+	// Get the bond of an identifier, throw std::out_of_range if there is none
+	const Bond& GetBond(const boost::string_view &productId) const;
+
+	// Get the bond of a handle, throw std::out_of_range if there is none
+	const Bond& GetBond(ProductHandle handle) const;
+
+	// Get the handle of an identifier, NO_PRODUCT_HANDLE if there is none
+	ProductHandle GetHandle(const boost::string_view &productId) const;
+
+	// Get the bonds of a ticker (sorted by identifier)
+	BondView GetByTicker(const boost::string_view &ticker) const;
+
+	// Get the bonds maturing in [from, to] (sorted by maturity date)
+	BondView GetByMaturity(const date &from, const date &to) const;
+
+	// Get the bonds with a coupon in [low, high] (sorted by coupon)
+	BondView GetByCoupon(float low, float high) const;
+};
+
+BondView::BondView() :
+	bonds(nullptr), first(nullptr), last(nullptr)
+{
+}
+
+BondView::BondView(const Bond* _bonds, const ProductHandle* _first, const ProductHandle* _last) :
+	bonds(_bonds), first(_first), last(_last)
+{
+}
+
+std::size_t BondView::size() const
+{
+	return last - first;
+}
+
+bool BondView::empty() const
+{
+	return first == last;
+}
+
+const Bond& BondView::operator[](std::size_t i) const
+{
+	return bonds[first[i]];
+}
+
+BondView::const_iterator BondView::begin() const
+{
+	return const_iterator(bonds, first);
+}
+
+BondView::const_iterator BondView::end() const
+{
+	return const_iterator(bonds, last);
+}
+
+BondView BondView::First(std::size_t n) const
+{
+	return BondView(bonds, first, first + std::min(n, size()));
+}
+
+BondReferenceTable::BondReferenceTable(const std::vector<Bond> &_bonds) :
+	bonds(_bonds)
+{
+	// hash table at most half full
+	std::size_t capacity = 16;
+	while (capacity < 2 * bonds.size())
+		capacity *= 2;
+	slots.assign(capacity, NO_PRODUCT_HANDLE);
+	for (std::size_t i = 0; i < bonds.size(); i++)
+	{
+		ProductHandle handle = static_cast<ProductHandle>(i);
+		bonds[i].SetHandle(handle);
+		std::size_t slot = FindSlot(bonds[i].GetProductId());
+		if (slots[slot] != NO_PRODUCT_HANDLE)
+		{
+			std::cout << "Oh no! The bond " << bonds[i].GetProductId() << " is in the reference data twice!\n";
+			continue;
+		}
+		slots[slot] = handle;
+	}
+
+	// secondary indexes: the handles sorted by identifier, then stable sorted by each key
+	// (the keys are gathered into arrays first, so the sorts do not go through the bonds)
+	std::vector<boost::string_view> ids, tickers;
+	std::vector<std::int32_t> maturities;
+	std::vector<float> coupons;
+	std::vector<ProductHandle> byId;
+	for (std::size_t i = 0; i < bonds.size(); i++)
+	{
+		ids.push_back(bonds[i].GetProductId());
+		tickers.push_back(bonds[i].GetTicker());
+		maturities.push_back(bonds[i].GetMaturitySerialDate());
+		coupons.push_back(bonds[i].GetCoupon());
+		byId.push_back(static_cast<ProductHandle>(i));
+	}
+	std::sort(byId.begin(), byId.end(), [&ids](ProductHandle a, ProductHandle b) { return ids[a] < ids[b]; });
+	byTicker = byId;
+	std::stable_sort(byTicker.begin(), byTicker.end(), [&tickers](ProductHandle a, ProductHandle b) {
+		return tickers[a] < tickers[b]; });
+	byMaturity = byId;
+	std::stable_sort(byMaturity.begin(), byMaturity.end(), [&maturities](ProductHandle a, ProductHandle b) {
+		return maturities[a] < maturities[b]; });
+	byCoupon = byId;
+	std::stable_sort(byCoupon.begin(), byCoupon.end(), [&coupons](ProductHandle a, ProductHandle b) {
+		return coupons[a] < coupons[b]; });
+}
+
+std::uint64_t BondReferenceTable::Hash(const boost::string_view &productId)
+{
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (char c : productId)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+std::size_t BondReferenceTable::FindSlot(const boost::string_view &productId) const
+{
+	std::size_t mask = slots.size() - 1;
+	std::size_t slot = static_cast<std::size_t>(Hash(productId)) & mask;
+	while (slots[slot] != NO_PRODUCT_HANDLE && productId != bonds[slots[slot]].GetProductId())
+		slot = (slot + 1) & mask; // linear probing
+	return slot;
+}
+
+std::size_t BondReferenceTable::GetSize() const
+{
+	return bonds.size();
+}
+
+const Bond* BondReferenceTable::Find(const boost::string_view &productId) const
+{
+	ProductHandle handle = slots[FindSlot(productId)];
+	return (handle == NO_PRODUCT_HANDLE) ? nullptr : &bonds[handle];
+}
+
+const Bond& BondReferenceTable::GetBond(const boost::string_view &productId) const
+{
+	const Bond* bond = Find(productId);
+	if (bond == nullptr)
+		throw std::out_of_range("no bond " + std::string(productId.data(), productId.size()) + " in the reference data");
+	return *bond;
+}
+
+const Bond& BondReferenceTable::GetBond(ProductHandle handle) const
+{
+	return bonds.at(handle);
+}
+
+ProductHandle BondReferenceTable::GetHandle(const boost::string_view &productId) const
+{
+	return slots[FindSlot(productId)];
+}
+
+BondView BondReferenceTable::GetByTicker(const boost::string_view &ticker) const
+{
+	const std::vector<Bond> &table = bonds;
+	auto range = std::equal_range(byTicker.begin(), byTicker.end(), NO_PRODUCT_HANDLE,
+		[&table, &ticker](ProductHandle a, ProductHandle b) {
+			// NO_PRODUCT_HANDLE stands for the ticker searched
+			boost::string_view left = (a == NO_PRODUCT_HANDLE) ? ticker : boost::string_view(table[a].GetTicker());
+			boost::string_view right = (b == NO_PRODUCT_HANDLE) ? ticker : boost::string_view(table[b].GetTicker());
+			return left < right;
+		});
+	return BondView(bonds.data(), byTicker.data() + (range.first - byTicker.begin()),
+		byTicker.data() + (range.second - byTicker.begin()));
+}
+
+BondView BondReferenceTable::GetByMaturity(const date &from, const date &to) const
+{
+	const std::vector<Bond> &table = bonds;
+	std::int32_t fromSerialDate = static_cast<std::int32_t>(from.day_number());
+	std::int32_t toSerialDate = static_cast<std::int32_t>(to.day_number());
+	auto first = std::lower_bound(byMaturity.begin(), byMaturity.end(), fromSerialDate,
+		[&table](ProductHandle a, std::int32_t d) { return table[a].GetMaturitySerialDate() < d; });
+	auto last = std::upper_bound(first, byMaturity.end(), toSerialDate,
+		[&table](std::int32_t d, ProductHandle a) { return d < table[a].GetMaturitySerialDate(); });
+	return BondView(bonds.data(), byMaturity.data() + (first - byMaturity.begin()),
+		byMaturity.data() + (last - byMaturity.begin()));
+}
+
+BondView BondReferenceTable::GetByCoupon(float low, float high) const
+{
+	const std::vector<Bond> &table = bonds;
+	auto first = std::lower_bound(byCoupon.begin(), byCoupon.end(), low,
+		[&table](ProductHandle a, float c) { return table[a].GetCoupon() < c; });
+	auto last = std::upper_bound(first, byCoupon.end(), high,
+		[&table](float c, ProductHandle a) { return c < table[a].GetCoupon(); });
+	return BondView(bonds.data(), byCoupon.data() + (first - byCoupon.begin()),
+		byCoupon.data() + (last - byCoupon.begin()));
+}
+
+#endif // !BondReferenceTable_hpp
@@ -5,6 +5,7 @@
 // Define bond algo execution architecture, including 
 // bond algo execution service for the determination of the order to be executed, and
 // bond algo execution service listener for the data inflow from bond market data service
+// (either the full order books, or the incremental deltas of the books, on which the algo runs only when the top of the book moves)
 
 #ifndef BondAlgoExecutionSoa_hpp
 #define BondAlgoExecutionSoa_hpp
@@ -13,6 +14,9 @@
 #include "executionservice.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
+#include "OrderBookUpdate.hpp"
 #include <unordered_map>
 #include <sstream>
 
@@ -40,14 +44,14 @@ class BondAlgoExecutionService : public Service<string, AlgoExecution<Bond>>
 {
 protected:
 	std::vector<ServiceListener<AlgoExecution<Bond>>*> listeners;
-	std::unordered_map<string, AlgoExecution<Bond>> algoexecutionMap; // key on product identifier
+	ProductHandleMap<AlgoExecution<Bond>> algoexecutionMap; // key on product handle
 	long counter = 0; // counter to determine the side of the algo execution
 
 public:
-	BondAlgoExecutionService() {} // empty ctor
+	BondAlgoExecutionService(BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual AlgoExecution<Bond> & GetData(string key);
+	virtual AlgoExecution<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(AlgoExecution<Bond> &data);
@@ -61,6 +65,13 @@ public:
 
 	// Generate the execution order and update it to the stored data
 	virtual void AddOrder(const OrderBook<Bond>& orderBook);
+
+	// Generate the execution order from the best bid/offer of a product and update it to the stored data
+	// (none if a side of the book is empty)
+	virtual void AddOrder(const Bond& product, const BidOffer& bestBidOffer);
+
+	// Whether both sides of a best bid/offer are quoted (an empty side is an order of quantity 0)
+	static bool IsTwoSided(const BidOffer& bestBidOffer);
 };
 
 // Bond algo-execution service listener
@@ -83,6 +94,26 @@ public:
 	virtual void ProcessUpdate(OrderBook<Bond> &data);
 };
 
+// Bond algo-execution service listener
+// registered into the bond market data service to process the incremental deltas of the orderbooks
+class BondAlgoExecutionDeltaListener : public ServiceListener<OrderBookDelta<Bond>>
+{
+protected:
+	BondAlgoExecutionService* bondAlgoExecutionService;
+
+public:
+	BondAlgoExecutionDeltaListener(BondAlgoExecutionService* _bondAlgoExecutionService); // ctor
+
+	// Listener callback to process an add event to the Service
+	virtual void ProcessAdd(OrderBookDelta<Bond> &data);
+
+	// Listener callback to process a remove event to the Service
+	virtual void ProcessRemove(OrderBookDelta<Bond> &data);
+
+	// Listener callback to process an update event to the Service
+	virtual void ProcessUpdate(OrderBookDelta<Bond> &data);
+};
+
 template <typename T>
 AlgoExecution<T>::AlgoExecution(const ExecutionOrder<T>& _order) : order(_order)
 {
@@ -95,7 +126,12 @@ const ExecutionOrder<T>& AlgoExecution<T>::GetOrder() const
 	return order;
 }
 
-AlgoExecution<Bond> & BondAlgoExecutionService::GetData(string key)
+BondAlgoExecutionService::BondAlgoExecutionService(BondProductService* _bondProductService)
+{
+	algoexecutionMap.Bind(_bondProductService);
+}
+
+AlgoExecution<Bond> & BondAlgoExecutionService::GetData(const string &key)
 {
 	return algoexecutionMap[key];
 }
@@ -116,20 +152,30 @@ const vector< ServiceListener<AlgoExecution<Bond>>* >& BondAlgoExecutionService:
 
 void BondAlgoExecutionService::AddOrder(const OrderBook<Bond>& orderBook)
 {
-	string productId = orderBook.GetProduct().GetProductId();
-
 	// Get the best bid and offer in the order book
-	BidOffer bestBidOffer = orderBook.GetBestBidOffer();
+	AddOrder(orderBook.GetProduct(), orderBook.GetBestBidOffer());
+}
+
+bool BondAlgoExecutionService::IsTwoSided(const BidOffer& bestBidOffer)
+{
+	return bestBidOffer.GetBidOrder().GetQuantity() > 0 && bestBidOffer.GetOfferOrder().GetQuantity() > 0;
+}
+
+void BondAlgoExecutionService::AddOrder(const Bond& product, const BidOffer& bestBidOffer)
+{
+	// no spread to cross against an empty side (e.g. once its last level is deleted)
+	if (!IsTwoSided(bestBidOffer))
+		return;
 
 	// Generate an execution order only if the spread is tightest
-	double bestbid = bestBidOffer.GetOfferOrder().GetPrice();
-	double bestoffer = bestBidOffer.GetBidOrder().GetPrice();
-	if (bestoffer - bestbid <= 1.0 / 128)
+	TickPrice bestbid = bestBidOffer.GetOfferOrder().GetPrice();
+	TickPrice bestoffer = bestBidOffer.GetBidOrder().GetPrice();
+	if (bestoffer - bestbid <= TickPrice::FromTicks(TickPrice::TICKS_PER_UNIT / 128))
 	{
 		// determine the attributes of the execution order
 		// order ID (e.g. ORD2024T0001040)
 		std::stringstream ss;
-		ss << "ORD" << std::to_string(orderBook.GetProduct().GetMaturityDate().year()) << orderBook.GetProduct().GetTicker()
+		ss << "ORD" << std::to_string(product.GetMaturityDate().year()) << product.GetTicker()
 			<< std::setfill('0') << std::setw(7) << std::to_string(counter);
 		string orderId = ss.str();
 		ss.str(""); // release the buffer
@@ -158,15 +204,12 @@ void BondAlgoExecutionService::AddOrder(const OrderBook<Bond>& orderBook)
 			hiddenQuantity = allQuantity - visibleQuantity;
 
 			// generate the execution order
-			ExecutionOrder<Bond> execution(orderBook.GetProduct(), side, orderId, type,
+			ExecutionOrder<Bond> execution(product, side, orderId, type,
 				bestoffer, visibleQuantity, hiddenQuantity, parentOrderId, isChildOrder);
 
 			// Add an algo execution related to the execution order to the stored data
 			AlgoExecution<Bond> algoexecution(execution);
-			if (algoexecutionMap.find(productId) == algoexecutionMap.end()) // if not found this one then create one
-				algoexecutionMap.insert(std::make_pair(productId, algoexecution));
-			else
-				algoexecutionMap[productId] = algoexecution;
+			algoexecutionMap[execution.GetProduct()] = algoexecution;
 
 			// Call the listeners (update)
 			for (auto listener : listeners)
@@ -180,15 +223,12 @@ void BondAlgoExecutionService::AddOrder(const OrderBook<Bond>& orderBook)
 			hiddenQuantity = allQuantity - visibleQuantity;
 
 			// generate the execution order
-			ExecutionOrder<Bond> execution(orderBook.GetProduct(), side, orderId, type,
+			ExecutionOrder<Bond> execution(product, side, orderId, type,
 				bestbid, visibleQuantity, hiddenQuantity, parentOrderId, isChildOrder);
 
 			// Add an algo execution related to the execution order to the stored data
 			AlgoExecution<Bond> algoexecution(execution);
-			if (algoexecutionMap.find(productId) == algoexecutionMap.end()) // if not found this one then create one
-				algoexecutionMap.insert(std::make_pair(productId, algoexecution));
-			else
-				algoexecutionMap[productId] = algoexecution;
+			algoexecutionMap[execution.GetProduct()] = algoexecution;
 
 			// Call the listeners (update)
 			for (auto listener : listeners)
@@ -217,4 +257,24 @@ void BondAlgoExecutionListener::ProcessUpdate(OrderBook<Bond> &data)
 { // not defined for this service
 }
 
+BondAlgoExecutionDeltaListener::BondAlgoExecutionDeltaListener(BondAlgoExecutionService* _bondAlgoExecutionService):
+	bondAlgoExecutionService(_bondAlgoExecutionService)
+{
+}
+
+void BondAlgoExecutionDeltaListener::ProcessAdd(OrderBookDelta<Bond> &data)
+{ // not defined for this service
+}
+
+void BondAlgoExecutionDeltaListener::ProcessRemove(OrderBookDelta<Bond> &data)
+{ // not defined for this service
+}
+
+void BondAlgoExecutionDeltaListener::ProcessUpdate(OrderBookDelta<Bond> &data)
+{
+	// the algo runs only when the inside market moves, and both sides are quoted
+	if (data.IsTopOfBookChanged() && BondAlgoExecutionService::IsTwoSided(data.GetBestBidOffer()))
+		bondAlgoExecutionService->AddOrder(data.GetProduct(), data.GetBestBidOffer());
+}
+
 #endif // ! BondAlgoExecutionSoa_hpp
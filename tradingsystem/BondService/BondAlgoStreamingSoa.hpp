@@ -13,6 +13,8 @@
 #include "streamingservice.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include <unordered_map>
 
 // Algo Stream with a two-way price stream
@@ -39,13 +41,18 @@ class BondAlgoStreamingService : public Service<string, AlgoStream<Bond>>
 {
 protected:
 	std::vector<ServiceListener<AlgoStream<Bond>>*> listeners;
-	std::unordered_map<string, AlgoStream<Bond>> algostreamMap; // key on product identifier
+	ProductHandleMap<AlgoStream<Bond>> algostreamMap; // key on product handle
 	long counter = 0; // counter to determine the quantity of the price stream
+	std::vector<AlgoStream<Bond>> batch; // re-used buffer for the batch update
+
+	// Generate the price stream, update it to the stored data and return the stored algo stream
+	AlgoStream<Bond>& UpdateStream(const Price<Bond>& price);
+
 public:
-	BondAlgoStreamingService() {} // empty ctor
+	BondAlgoStreamingService(BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual AlgoStream<Bond> & GetData(string key);
+	virtual AlgoStream<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(AlgoStream<Bond> &data);
@@ -59,6 +66,17 @@ public:
 
 	// Generate the price stream and update it to the stored data
 	virtual void AddStream(const Price<Bond>& price);
+
+	// Generate the price streams for a batch of prices and update them to the stored data
+	virtual void AddStreamBatch(const Price<Bond>* prices, size_t size);
+
+	// Generate the price stream and hand it to the next stage of a static pipeline
+	template <typename Next>
+	void AddStream(const Price<Bond>& price, Next& next);
+
+	// Generate the price streams for a batch of prices and hand them to the next stage of a static pipeline
+	template <typename Next>
+	void AddStreamBatch(const Price<Bond>* prices, size_t size, Next& next);
 };
 
 // Bond algo-streaming service listener
@@ -79,6 +97,28 @@ public:
 
 	// Listener callback to process an update event to the Service
 	virtual void ProcessUpdate(Price<Bond> &data);
+
+	// Listener callback to process a batch of add events to the Service
+	virtual void ProcessAddBatch(Price<Bond> *data, size_t size);
+};
+
+// Bond algo-streaming stage of a static pipeline (see StaticPipeline.hpp)
+// takes the price data in place of the bond algo-streaming service listener
+class BondAlgoStreamingStage
+{
+protected:
+	BondAlgoStreamingService* bondAlgoStreamingService;
+
+public:
+	BondAlgoStreamingStage(BondAlgoStreamingService* _bondAlgoStreamingService); // ctor
+
+	// Process the price data and hand the algo stream to the next stage
+	template <typename Next>
+	void Process(Price<Bond> &data, Next &next);
+
+	// Process a batch of price data and hand the algo streams to the next stage
+	template <typename Next>
+	void ProcessBatch(Price<Bond> *data, size_t size, Next &next);
 };
 
 template <typename T>
@@ -92,7 +132,12 @@ const PriceStream<T>& AlgoStream<T>::GetStream() const
 	return stream;
 }
 
-AlgoStream<Bond> & BondAlgoStreamingService::GetData(string key)
+BondAlgoStreamingService::BondAlgoStreamingService(BondProductService* _bondProductService)
+{
+	algostreamMap.Bind(_bondProductService);
+}
+
+AlgoStream<Bond> & BondAlgoStreamingService::GetData(const string &key)
 {
 	return algostreamMap[key];
 }
@@ -111,37 +156,76 @@ const vector< ServiceListener<AlgoStream<Bond>>* >& BondAlgoStreamingService::Ge
 	return listeners;
 }
 
-void BondAlgoStreamingService::AddStream(const Price<Bond>& price)
+AlgoStream<Bond>& BondAlgoStreamingService::UpdateStream(const Price<Bond>& price)
 {
 	// mid price and bid-offer spread from price object
-	double mid = price.GetMid();
-	double spread = price.GetBidOfferSpread();
+	TickPrice mid = price.GetMid();
+	long spread = price.GetBidOfferSpread().GetTicks();
 
 	// create bid/offer price stream order with hard-coded visible and hidden quantity 
 	long visibleQuantity;
 	if (counter % 2 == 0) visibleQuantity = 1000000;
 	else if (counter % 2 == 1) visibleQuantity = 2000000;
 	long hiddenQuantity = 2 * visibleQuantity;
-	PriceStreamOrder bidOrder(mid - spread / 2, visibleQuantity, hiddenQuantity, BID);
-	PriceStreamOrder offerOrder(mid + spread / 2, visibleQuantity, hiddenQuantity, OFFER);
+	// (the offer takes the odd tick of the spread, so that bid and offer stay a whole spread apart)
+	PriceStreamOrder bidOrder(mid - TickPrice::FromTicks(spread / 2), visibleQuantity, hiddenQuantity, BID);
+	PriceStreamOrder offerOrder(mid + TickPrice::FromTicks(spread - spread / 2), visibleQuantity, hiddenQuantity, OFFER);
 
 	// Generate a price stream based on the data
 	PriceStream<Bond> stream(price.GetProduct(), bidOrder, offerOrder);
 
 	// Add an algo stream related to the price stream to the stored data
-	string productId = price.GetProduct().GetProductId();
-	AlgoStream<Bond> algostream(stream);
-	if (algostreamMap.find(productId) == algostreamMap.end()) // if not found this one then create one
-		algostreamMap.insert(std::make_pair(productId, algostream));
-	else
-		algostreamMap[productId] = algostream;
+	AlgoStream<Bond>& algostream = algostreamMap[price.GetProduct()];
+	algostream = AlgoStream<Bond>(stream);
 	counter++;
 
+	return algostream;
+}
+
+void BondAlgoStreamingService::AddStream(const Price<Bond>& price)
+{
+	AlgoStream<Bond> algostream = UpdateStream(price);
+
 	// Call the listeners (update)
 	for (auto listener : listeners)
 		listener->ProcessUpdate(algostream);
 }
 
+void BondAlgoStreamingService::AddStreamBatch(const Price<Bond>* prices, size_t size)
+{
+	if (batch.size() < size) batch.resize(size);
+	for (size_t i = 0; i < size; i++)
+		batch[i] = UpdateStream(prices[i]);
+
+	// Call the listeners with the whole batch (update)
+	for (auto listener : listeners)
+		listener->ProcessUpdateBatch(batch.data(), size);
+}
+
+template <typename Next>
+void BondAlgoStreamingService::AddStream(const Price<Bond>& price, Next& next)
+{
+	AlgoStream<Bond> algostream = UpdateStream(price);
+
+	// Hand the algo stream to the next stage, then call the listeners (update)
+	next.Push(algostream);
+	for (auto listener : listeners)
+		listener->ProcessUpdate(algostream);
+}
+
+template <typename Next>
+void BondAlgoStreamingService::AddStreamBatch(const Price<Bond>* prices, size_t size, Next& next)
+{
+	if (batch.size() < size) batch.resize(size);
+	for (size_t i = 0; i < size; i++)
+		batch[i] = UpdateStream(prices[i]);
+
+	// Hand the whole batch to the next stage, then call the listeners (update)
+	next.PushBatch(batch.data(), size);
+	for (auto listener : listeners)
+		listener->ProcessUpdateBatch(batch.data(), size);
+}
+
 BondAlgoStreamingListener::BondAlgoStreamingListener(BondAlgoStreamingService* _bondAlgoStreamingService) :
 	bondAlgoStreamingService(_bondAlgoStreamingService)
 {
@@ -161,5 +245,28 @@ void BondAlgoStreamingListener::ProcessUpdate(Price<Bond> &data)
 { // not defined for this service
 }
 
+void BondAlgoStreamingListener::ProcessAddBatch(Price<Bond> *data, size_t size)
+{
+	// Add the algo streams based on the whole batch
+	bondAlgoStreamingService->AddStreamBatch(data, size);
+}
+
+BondAlgoStreamingStage::BondAlgoStreamingStage(BondAlgoStreamingService* _bondAlgoStreamingService) :
+	bondAlgoStreamingService(_bondAlgoStreamingService)
+{
+}
+
+template <typename Next>
+void BondAlgoStreamingStage::Process(Price<Bond> &data, Next &next)
+{
+	bondAlgoStreamingService->AddStream(data, next);
+}
+
+template <typename Next>
+void BondAlgoStreamingStage::ProcessBatch(Price<Bond> *data, size_t size, Next &next)
+{
+	bondAlgoStreamingService->AddStreamBatch(data, size, next);
+}
+
 
 #endif // !BondAlgoStreamingSoa_hpp
@@ -13,6 +13,8 @@
 #include "BondService/BondAlgoExecutionSoa.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include <unordered_map>
 #include <random> // to determine the market where the order is executed
 
@@ -21,13 +23,13 @@ class BondExecutionService : public ExecutionService<Bond>
 {
 protected:
 	std::vector<ServiceListener<ExecutionOrder<Bond>>*> listeners;
-	std::unordered_map<string, ExecutionOrder<Bond>> orderMap; // key on product identifier
+	ProductHandleMap<ExecutionOrder<Bond>> orderMap; // key on product handle
 
 public:
-	BondExecutionService() {} // empty ctor
+	BondExecutionService(BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual ExecutionOrder<Bond> & GetData(string key);
+	virtual ExecutionOrder<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(ExecutionOrder<Bond> &data);
@@ -64,7 +66,12 @@ public:
 };
 
 
-ExecutionOrder<Bond> & BondExecutionService::GetData(string key)
+BondExecutionService::BondExecutionService(BondProductService* _bondProductService)
+{
+	orderMap.Bind(_bondProductService);
+}
+
+ExecutionOrder<Bond> & BondExecutionService::GetData(const string &key)
 {
 	return orderMap[key];
 }
@@ -86,11 +93,7 @@ const vector< ServiceListener<ExecutionOrder<Bond>>* >& BondExecutionService::Ge
 void BondExecutionService::ExecuteOrder(const ExecutionOrder<Bond>& order, Market market)
 {
 	// execute the order (push data to the map)
-	string productId = order.GetProduct().GetProductId();
-	if (orderMap.find(productId) == orderMap.end()) // if not found this one then create one
-		orderMap.insert(std::make_pair(productId, order));
-	else
-		orderMap[productId] = order;
+	orderMap[order.GetProduct()] = order;
 
 	// call the listeners
 	ExecutionOrder<Bond> temp(order);
@@ -14,7 +14,10 @@
 #include "GUIService.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include "utilityfunction.hpp"
+#include "TimestampFormatter.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include <vector>
@@ -30,16 +33,16 @@ class BondGUIService : public GUIService<Bond>
 protected:
 	std::vector<ServiceListener<Price<Bond>>*> listeners;
 	Connector<Price<Bond>>* bondGuiConnector; // publish connector
-	std::unordered_map<string, Price<Bond>> priceMap; // key on product identifier
+	ProductHandleMap<Price<Bond>> priceMap; // key on product handle
 
 	// throttles modeling
 	std::chrono::milliseconds interval;
 
 public:
-	BondGUIService(int _interval, Connector<Price<Bond>>* _bondGuiConnector); // ctor
+	BondGUIService(int _interval, Connector<Price<Bond>>* _bondGuiConnector, BondProductService* _bondProductService = nullptr); // ctor
 
 	// Get data on our service given a key
-	virtual Price<Bond> & GetData(string key);
+	virtual Price<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Price<Bond> &data);
@@ -63,6 +66,7 @@ class BondGUIConnector : public Connector<Price<Bond>>
 {
 protected:
 	fstream file;
+	TimestampFormatter timestampFormatter; // the time stamp of the output
 public:
 	BondGUIConnector(string _path); // ctor
 
@@ -94,12 +98,13 @@ public:
 	virtual void ProcessUpdate(Price<Bond> &data);
 };
 
-BondGUIService::BondGUIService(int _interval, Connector<Price<Bond>>* _bondGuiConnector): 
+BondGUIService::BondGUIService(int _interval, Connector<Price<Bond>>* _bondGuiConnector, BondProductService* _bondProductService): 
 	interval(_interval), bondGuiConnector(_bondGuiConnector)
 {
+	priceMap.Bind(_bondProductService);
 }
 
-Price<Bond> & BondGUIService::GetData(string key)
+Price<Bond> & BondGUIService::GetData(const string &key)
 {
 	return priceMap[key];
 }
@@ -121,11 +126,7 @@ const vector< ServiceListener<Price<Bond>>* >& BondGUIService::GetListeners() co
 void BondGUIService::AddPrice(const Price<Bond> &price)
 {
 	// push the data into the service
-	string productId = price.GetProduct().GetProductId();
-	if (priceMap.find(productId) == priceMap.end()) // if not found this one then create one
-		priceMap.insert(std::make_pair(productId, price));
-	else
-		priceMap[productId] = price;
+	priceMap[price.GetProduct()] = price;
 
 	// publish it
 	Price<Bond> temp(price);
@@ -152,15 +153,14 @@ void BondGUIConnector::Publish(Price <Bond> &data)
 	if (file.is_open())
 	{
 		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		char timestamp[TIMESTAMP_LENGTH + 1]; // current time
+		timestampFormatter.Format(timestamp);
 		Bond bond = data.GetProduct(); // get the product
 		std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
-		std::string priceStr = PricetoString(data.GetMid());
+		char priceStr[32];
+		data.GetMid().ToBuffer(priceStr);
 		// make the output
-		file << date << " " << timeofDay << "," << Idtype << "," 
+		file << timestamp << "," << Idtype << "," 
 			<< bond.GetProductId() << ","<< priceStr << "\n";
 	}
 	else
@@ -17,6 +17,7 @@
 #include "boost/date_time/gregorian/gregorian.hpp" // date operation
 #include "boost/algorithm/string.hpp" // string algorithm
 #include "utilityfunction.hpp"
+#include "CsvReader.hpp"
 #include <vector>
 #include <unordered_map>
 #include <fstream>
@@ -38,7 +39,7 @@ public:
 	void SetConnector(Connector<Inquiry<Bond>>* _bondInquiryConnector);
 
 	// Get data on our service given a key
-	virtual Inquiry<Bond> & GetData(string key);
+	virtual Inquiry<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Inquiry<Bond> &data);
@@ -64,6 +65,7 @@ class BondInquiryConnector : public Connector<Inquiry<Bond>>
 {
 protected:
 	BondInquiryService* bondInquiryService;
+	long counter = 0; // # of records read
 
 public:
 	BondInquiryConnector(string path, BondInquiryService* _bondInquiryService, 
@@ -72,6 +74,9 @@ public:
 	// Publish data to the Connector
 	virtual void Publish(Inquiry <Bond> &data);
 
+	// Get the number of records read
+	long GetRecordCount() const;
+
 };
 
 // corresponding service listener
@@ -98,7 +103,7 @@ void BondInquiryService::SetConnector(Connector<Inquiry<Bond>>* _bondInquiryConn
 	bondInquiryConnector = _bondInquiryConnector;
 }
 
-Inquiry<Bond> & BondInquiryService::GetData(string key)
+Inquiry<Bond> & BondInquiryService::GetData(const string &key)
 {
 	return inquiryMap[key];
 }
@@ -150,57 +155,56 @@ BondInquiryConnector::BondInquiryConnector(string path, BondInquiryService* _bon
 {
 	bondInquiryService->SetConnector(this);
 
-	fstream file(path, std::ios::in);
-	string line;
-	std::stringstream ss;
-	char separator = ','; // comma seperator
+	CsvReader reader(path); // discard header
+	string inquiryId, bondId; // re-used field buffers
 
-	if (file.is_open())
+	if (reader.IsOpen())
 	{
 		std::cout << "Inquiry: Begin to read data...\n";
-		getline(file, line); // discard header
 
-		while (getline(file, line))
+		while (reader.NextRow())
 		{
-			stringstream sin(line);
-
-			// save all trimmed data into a vector of strings
-			std::vector<string> tempData;
-			string info;
-			while (getline(sin, info, separator))
+			if (reader.GetFieldCount() < 7)
 			{
-				boost::algorithm::trim(info);
-				tempData.push_back(info);
+				std::cout << "Oh no! Inquiry: skip a row with missing fields!\n";
+				continue;
 			}
 
 			// make the corresponding inquiry object
 			// inquiry Id
-			string inquiryId = tempData[0];
+			reader.GetString(0, inquiryId);
 			// bond Id
-			BondIdType type = (boost::algorithm::to_upper_copy(tempData[1]) == "CUSIP") ? CUSIP : ISIN;
-			string bondId = tempData[2];
+			reader.GetString(2, bondId);
 			// the bond product
-			Bond bond = _bondProductService->GetData(bondId); // bond id, bond id type, ticker, coupon, maturity
+			const Bond* product = _bondProductService->GetTable().Find(bondId); // bond id, bond id type, ticker, coupon, maturity
+			if (product == nullptr)
+			{
+				std::cout << "Oh no! Inquiry: skip a row with an unknown bond!\n";
+				continue;
+			}
+			const Bond &bond = *product;
 			// inquiry side
-			Side side = (boost::algorithm::to_upper_copy(tempData[3]) == "BUY") ? BUY : SELL;
+			Side side = boost::algorithm::iequals(reader.GetField(3), "BUY") ? BUY : SELL;
 			// inquiry quantity
-			long quantity = StringtoType<long>(ss, tempData[4]);
+			long quantity = reader.GetLong(4);
 			// inquiry price
-			double price = StringtoPrice<double>(ss, tempData[5]);
+			double price = reader.GetPrice(5);
 			// inquiry state
-			boost::algorithm::to_upper(tempData[6]);
+			const boost::string_view &stateStr = reader.GetField(6);
 			InquiryState state = RECEIVED; // default as RECEIVED
-			if (tempData[6] == "QUOTED") state = QUOTED;
-			else if (tempData[6] == "DONE") state = DONE;
-			else if (tempData[6] == "REJECTED") state = REJECTED;
-			else if (tempData[6] == "CUSTOMER_REJECTED") state = CUSTOMER_REJECTED;
+			if (boost::algorithm::iequals(stateStr, "QUOTED")) state = QUOTED;
+			else if (boost::algorithm::iequals(stateStr, "DONE")) state = DONE;
+			else if (boost::algorithm::iequals(stateStr, "REJECTED")) state = REJECTED;
+			else if (boost::algorithm::iequals(stateStr, "CUSTOMER_REJECTED")) state = CUSTOMER_REJECTED;
 
 			// inquiry object
 			Inquiry<Bond> inquiry(inquiryId, bond, side, quantity, price, state);
 
 			bondInquiryService->OnMessage(inquiry);
+			counter++;
 		}
 		std::cout << "Inquiry: finished!\n";
+		reader.Report(std::cout, "Inquiry");
 	}
 	else
 	{
@@ -233,6 +237,11 @@ void BondInquiryConnector::Publish(Inquiry <Bond> &data)
 
 }
 
+long BondInquiryConnector::GetRecordCount() const
+{
+	return counter;
+}
+
 BondInquiryListener::BondInquiryListener(BondInquiryService* _bondInquiryService) :
 	bondInquiryService(_bondInquiryService)
 {
@@ -5,6 +5,8 @@
 // Define bond market data architecture, including 
 // bond market data service for the market data related to a bond, and
 // bond market data connector for the data inflow
+// The service takes full order book snapshots (OnMessage) and incremental price level updates (OnUpdate),
+// both applied to a fixed-depth book per product and venue, merged into a book consolidated across the venues
 
 #ifndef BondMarketDataSoa_hpp
 #define BondMarketDataSoa_hpp
@@ -12,7 +14,14 @@
 #include "marketdataservice.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "FixedDepthOrderBook.hpp"
+#include "OrderBookUpdate.hpp"
 #include "utilityfunction.hpp"
+#include "productservice.hpp"
+#include "CsvReader.hpp"
+#include "ParallelCsvReader.hpp"
+#include "RecordPipe.hpp"
 #include "boost/algorithm/string.hpp" // string algorithm
 #include "boost/date_time/gregorian/gregorian.hpp" // date operation
 #include <unordered_map>
@@ -20,21 +29,55 @@
 #include <iostream>
 #include <sstream>
 
+// Price levels of a product, and whether its order book and its aggregated depth are behind them
+struct BondLevelBook
+{
+	FixedDepthOrderBook<Bond> venues[NUM_MARKETS]; // price levels of each venue
+	ConsolidatedOrderBook<> levels; // consolidated across the venues, aggregated by price and sorted from the best price
+	const Bond* product = nullptr; // the product of the last incremental update (owned by the product service)
+	bool stale = false; // changed (by a snapshot or an incremental update) since the order book was last built
+	OrderBook<Bond> depth; // cached aggregated depth, sorted from the best price
+	bool depthStale = true; // changed since the aggregated depth was last built
+};
+
+// A parsed row of the market data file
+struct BondMarketDataRow
+{
+	const Bond* product; // owned by the product service
+	Market venue;
+	long ticks[6]; // mid price and the 5 spreads (in ticks)
+	long quantities[5]; // quantity of each of the 5 levels
+};
+
 // Bond market data service
 class BondMarketDataService : public MarketDataService<Bond>
 {
 protected:
-	std::vector<ServiceListener<OrderBook<Bond>>*> listeners;
-	std::unordered_map<string, OrderBook<Bond>> orderbookMap; // key on product identifier
+	std::vector<ServiceListener<OrderBook<Bond>>*> listeners; // notified of the snapshots
+	std::vector<ServiceListener<OrderBookDelta<Bond>>*> deltaListeners; // notified of the incremental updates
+	ProductHandleMap<OrderBook<Bond>> orderbookMap; // key on product handle
+	ProductHandleMap<BondLevelBook> levelbookMap; // key on product handle
+	std::vector<OrderBookDelta<Bond>> deltaBatch; // re-used batch of deltas
+
+	// Apply an incremental update to the venue book of its product, merge it into the consolidated book
+	// and fill its delta
+	void ApplyUpdate(const MarketDataUpdate<Bond> &update, OrderBookDelta<Bond> &delta);
+
+	// Apply a snapshot as the book of a venue (through the messages from the last book of the venue)
+	void ApplySnapshot(const OrderBook<Bond> &data, Market venue);
+
 public:
-	BondMarketDataService() {} // empty ctor
+	BondMarketDataService(BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
-	// Get data on our service given a key
-	virtual OrderBook<Bond> & GetData(string key);
+	// Get data on our service given a key (the book consolidated across the venues, after snapshots and updates alike)
+	virtual OrderBook<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(OrderBook<Bond> &data);
 
+	// The callback that a Connector can invoke for a contiguous batch of new or updated data
+	virtual void OnMessageBatch(OrderBook<Bond> *data, size_t size);
+
 	// Add a listener to the Service for callbacks on add, remove, and update events
 	// for data to the Service.
 	virtual void AddListener(ServiceListener<OrderBook<Bond>> *listener);
@@ -42,46 +85,117 @@ public:
 	// Get all listeners on the Service.
 	virtual const vector< ServiceListener<OrderBook<Bond>>* >& GetListeners() const;
 
-	// Get the best bid/offer order
-	virtual const BidOffer& GetBestBidOffer(const string &productId);
+	// The callback that a Connector should invoke for an incremental update of the price levels
+	virtual void OnUpdate(MarketDataUpdate<Bond> &data);
+
+	// The callback that a Connector can invoke for a contiguous batch of incremental updates
+	virtual void OnUpdateBatch(MarketDataUpdate<Bond> *data, size_t size);
+
+	// Add a listener to the Service for callbacks on the incremental updates
+	virtual void AddDeltaListener(ServiceListener<OrderBookDelta<Bond>> *listener);
+
+	// Get all listeners on the incremental updates
+	virtual const vector< ServiceListener<OrderBookDelta<Bond>>* >& GetDeltaListeners() const;
+
+	// Get the price levels of a product on a venue
+	virtual const FixedDepthOrderBook<Bond>& GetLevelBook(const string &productId, Market venue);
 
-	// Aggregate the order book
+	// Get the price levels of a product consolidated across the venues (with the quantity of each venue)
+	virtual const ConsolidatedOrderBook<>& GetConsolidatedBook(const string &productId);
+
+	// Get the best bid/offer order (consolidated across the venues)
+	virtual BidOffer GetBestBidOffer(const string &productId);
+
+	// Aggregate the order book across the venues (sorted from the best price, cached until the next change
+	// of the book, the stored order book is left untouched)
 	virtual const OrderBook<Bond>& AggregateDepth(const string &productId);
 };
 
 // Corresponding subscribe connector
+// Each row of the input is a full snapshot of the book of a product on a venue (an optional 14th column,
+// BROKERTEC if absent); in the incremental mode the connector acts as the feed handler and hands over
+// only the price levels changed since the last row of the product on the venue
 class BondMarketDataConnector : public Connector<OrderBook<Bond>>
 {
 protected:
-	Service<string, OrderBook<Bond>>* bondMarketDataService;
+	BondMarketDataService* bondMarketDataService;
+	ProductHandleMap<FixedDepthOrderBook<Bond>> lastbookMap[NUM_MARKETS]; // the last snapshot of each product on each venue, key on product handle
+	long counter = 0; // # of records read
+	size_t batchSize; // # of order books (or incremental updates) handed over at once
+	bool incremental; // whether the rows are handed over as incremental updates
+	std::vector<OrderBook<Bond>> batch; // re-used batch buffer (snapshot mode)
+	std::vector<MarketDataUpdate<Bond>> updateBatch; // re-used batch buffer (incremental mode)
+	size_t batchCount = 0; // # of order books (or incremental updates) in the batch
+
+	// Hand over the rows of a chunk in batches, in order
+	void HandOver(std::vector<BondMarketDataRow> &rows);
+
+	// Hand over the last partial batch
+	void FlushBatch();
 
 public:
-	BondMarketDataConnector(string path, Service<string, OrderBook<Bond>>* _bondMarketDataService, BondProductService* _bondProductService); // ctor
+	BondMarketDataConnector(string path, BondMarketDataService* _bondMarketDataService, 
+		BondProductService* _bondProductService, size_t batchSize = 1024, 
+		bool incremental = true, size_t parseThreads = 1); // ctor, hands over batchSize order books (or incremental updates) at once
+	// (the file is parsed in chunks on parseThreads threads, 0 for one per core, the rows still handed over in file order)
+
+	// ctor, hands over batchSize order books (or incremental updates) at once,
+	// made of the rows taken from the pipe fed by a generator (no file)
+	BondMarketDataConnector(RecordPipe<BondMarketDataRow>* pipe, BondMarketDataService* _bondMarketDataService,
+		size_t _batchSize = 1024, bool _incremental = true);
 
 	// Publish data to the Connector
 	virtual void Publish(OrderBook <Bond> &data);
 
+	// Get the number of records read
+	long GetRecordCount() const;
+
 };
 
-OrderBook<Bond> & BondMarketDataService::GetData(string key)
+BondMarketDataService::BondMarketDataService(BondProductService* _bondProductService)
+{
+	orderbookMap.Bind(_bondProductService);
+	levelbookMap.Bind(_bondProductService);
+}
+
+OrderBook<Bond> & BondMarketDataService::GetData(const string &key)
 {
-	return orderbookMap[key];
+	OrderBook<Bond> &orderbook = orderbookMap[key];
+	BondLevelBook &levelbook = levelbookMap[key];
+	if (levelbook.stale) // re-build the order book from the price levels
+	{
+		// the product of the last update, or of the last snapshot stored
+		orderbook = levelbook.levels.ToOrderBook((levelbook.product != nullptr) ? *levelbook.product : orderbook.GetProduct());
+		levelbook.stale = false;
+	}
+	return orderbook;
 }
 
 void BondMarketDataService::OnMessage(OrderBook<Bond> &data)
 {
 	// push the data into map
-	string productId = data.GetProduct().GetProductId();
-	if (orderbookMap.find(productId) == orderbookMap.end()) // if not found this one then create one
-		orderbookMap.insert(std::make_pair(productId, data));
-	else
-		orderbookMap[productId] = data;
+	orderbookMap[data.GetProduct()] = data;
+	ApplySnapshot(data, BROKERTEC);
 
 	// call the listeners
 	for (auto listener : listeners)
 		listener->ProcessAdd(data);
 }
 
+void BondMarketDataService::OnMessageBatch(OrderBook<Bond> *data, size_t size)
+{
+	// push the data into map
+	for (size_t i = 0; i < size; i++)
+	{
+		orderbookMap[data[i].GetProduct()] = data[i];
+		ApplySnapshot(data[i], BROKERTEC);
+	}
+
+	// call the listeners with the whole batch
+	for (auto listener : listeners)
+		listener->ProcessAddBatch(data, size);
+}
+
 void BondMarketDataService::AddListener(ServiceListener<OrderBook<Bond>> *listener)
 {
 	listeners.push_back(listener);
@@ -92,129 +206,313 @@ const vector< ServiceListener<OrderBook<Bond>>* >& BondMarketDataService::GetLis
 	return listeners;
 }
 
-const BidOffer& BondMarketDataService::GetBestBidOffer(const string &productId)
+void BondMarketDataService::ApplyUpdate(const MarketDataUpdate<Bond> &update, OrderBookDelta<Bond> &delta)
 {
-	return orderbookMap[productId].GetBestBidOffer();
+	const Bond &product = update.GetProduct();
+	Market venue = update.GetVenue();
+	BondLevelBook &levelbook = levelbookMap[product];
+	FixedDepthOrderBook<Bond> &venuebook = levelbook.venues[venue];
+	ConsolidatedOrderBook<> &consolidated = levelbook.levels;
+	bool topOfBookChanged = false;
+
+	// apply the messages in order to the venue book, keep the ones that changed a level,
+	// and merge each change of quantity into the consolidated book
+	delta.Reset(&product, venue);
+	for (int i = 0; i < update.GetSize(); i++)
+	{
+		const PriceLevelUpdate &levelUpdate = update.GetLevelUpdate(i);
+		PricingSide side = levelUpdate.GetSide();
+		TickPrice price = levelUpdate.GetPrice();
+		int oldLevel = venuebook.FindLevel(side, price);
+		long oldQuantity = (oldLevel >= 0) ? venuebook.GetQuantity(side, oldLevel) : 0;
+		int level = -1;
+		if (levelUpdate.GetAction() == ADD_LEVEL)
+		{
+			// the worst level falls off a full venue book when a better one is added
+			bool full = (venuebook.GetDepth(side) == FixedDepthOrderBook<Bond>::MAX_DEPTH);
+			TickPrice worstPrice = full ? venuebook.GetPrice(side, FixedDepthOrderBook<Bond>::MAX_DEPTH - 1) : TickPrice();
+			long worstQuantity = full ? venuebook.GetQuantity(side, FixedDepthOrderBook<Bond>::MAX_DEPTH - 1) : 0;
+			level = venuebook.AddLevel(side, price, levelUpdate.GetQuantity());
+			if (level >= 0 && full && oldLevel < 0)
+				topOfBookChanged |= (consolidated.ApplyVenueChange(side, venue, worstPrice, -worstQuantity) == 0);
+		}
+		else if (levelUpdate.GetAction() == MODIFY_LEVEL)
+			level = venuebook.ModifyLevel(side, price, levelUpdate.GetQuantity());
+		else if (levelUpdate.GetAction() == DELETE_LEVEL)
+			level = venuebook.DeleteLevel(side, price);
+		if (level < 0)
+			continue;
+
+		// the change of quantity of the venue at the price
+		int newLevel = venuebook.FindLevel(side, price);
+		long newQuantity = (newLevel >= 0) ? venuebook.GetQuantity(side, newLevel) : 0;
+		topOfBookChanged |= (consolidated.ApplyVenueChange(side, venue, price, newQuantity - oldQuantity) == 0);
+		delta.AddLevelUpdate(PriceLevelUpdate(levelUpdate.GetAction(), side, price, levelUpdate.GetQuantity(), level));
+	}
+	if (delta.GetSize() > 0)
+	{
+		levelbook.stale = true;
+		levelbook.depthStale = true;
+	}
+
+	// the top of the consolidated book, with its venue attribution
+	delta.SetTopOfBookChanged(topOfBookChanged);
+	delta.SetBestBidOffer(consolidated.GetBestBidOffer());
+	PricingSide sides[2] = { BID, OFFER };
+	for (PricingSide side : sides)
+	{
+		for (int k = 0; k < NUM_MARKETS; k++)
+			delta.SetBestVenueQuantity(side, Market(k), 
+				(consolidated.GetDepth(side) > 0) ? consolidated.GetVenueQuantity(side, 0, Market(k)) : 0);
+	}
 }
 
-const OrderBook<Bond>& BondMarketDataService::AggregateDepth(const string &productId)
+void BondMarketDataService::ApplySnapshot(const OrderBook<Bond> &data, Market venue)
 {
-	OrderBook<Bond> orderbook = orderbookMap[productId];
-	std::vector<Order> bidOrders = orderbook.GetBidStack();
-	std::vector<Order> offerOrders = orderbook.GetOfferStack();
-	
-	// use map for aggregation
-	std::unordered_map<double, long> bidMap;
-	std::unordered_map<double, long> offerMap;
-
-	double price; // temp price
-
-	// for bid orders
-	for (auto iter = bidOrders.begin(); iter != bidOrders.end(); iter++)
+	BondLevelBook &levelbook = levelbookMap[data.GetProduct()];
+	FixedDepthOrderBook<Bond> venuebook;
+	venuebook.Assign(data);
+	MarketDataUpdate<Bond> update;
+	OrderBookDelta<Bond> delta;
+	bool complete = false;
+	while (!complete) // too many messages for one update: the rest is diffed from the book they were applied to
 	{
-		price = iter->GetPrice();
-		if (bidMap.find(price) != bidMap.end()) // if found
-			bidMap[price] += iter->GetQuantity();
-		else
-			bidMap.insert(std::make_pair(price, iter->GetQuantity()));
+		update.Reset(&data.GetProduct(), venue);
+		complete = MakeLevelUpdates(levelbook.venues[venue], venuebook, update);
+		ApplyUpdate(update, delta);
 	}
+	levelbook.stale = true; // the order book is re-built from the consolidated levels, as after an update
+}
+
+void BondMarketDataService::OnUpdate(MarketDataUpdate<Bond> &data)
+{
+	levelbookMap[data.GetProduct()].product = &data.GetProduct();
+	if (deltaBatch.empty()) deltaBatch.resize(1);
+	ApplyUpdate(data, deltaBatch[0]);
 
-	// for offer orders
-	for (auto iter = offerOrders.begin(); iter != offerOrders.end(); iter++)
+	// call the listeners
+	for (auto listener : deltaListeners)
+		listener->ProcessUpdate(deltaBatch[0]);
+}
+
+void BondMarketDataService::OnUpdateBatch(MarketDataUpdate<Bond> *data, size_t size)
+{
+	if (deltaBatch.size() < size) deltaBatch.resize(size);
+	for (size_t i = 0; i < size; i++)
 	{
-		price = iter->GetPrice();
-		if (offerMap.find(price) != offerMap.end()) // if found
-			offerMap[price] += iter->GetQuantity();
-		else
-			offerMap.insert(std::make_pair(price, iter->GetQuantity()));
+		levelbookMap[data[i].GetProduct()].product = &data[i].GetProduct();
+		ApplyUpdate(data[i], deltaBatch[i]);
 	}
 
-	std::vector<Order> newbidOrders; 
-	std::vector<Order> newofferOrders; 
+	// call the listeners with the whole batch
+	for (auto listener : deltaListeners)
+		listener->ProcessUpdateBatch(deltaBatch.data(), size);
+}
 
-	// re-construct the bid and offer orders
-	for (auto iter = bidMap.begin(); iter != bidMap.end(); iter++)
+void BondMarketDataService::AddDeltaListener(ServiceListener<OrderBookDelta<Bond>> *listener)
+{
+	deltaListeners.push_back(listener);
+}
+
+const vector< ServiceListener<OrderBookDelta<Bond>>* >& BondMarketDataService::GetDeltaListeners() const
+{
+	return deltaListeners;
+}
+
+const FixedDepthOrderBook<Bond>& BondMarketDataService::GetLevelBook(const string &productId, Market venue)
+{
+	return levelbookMap[productId].venues[venue];
+}
+
+const ConsolidatedOrderBook<>& BondMarketDataService::GetConsolidatedBook(const string &productId)
+{
+	return levelbookMap[productId].levels;
+}
+
+BidOffer BondMarketDataService::GetBestBidOffer(const string &productId)
+{
+	return levelbookMap[productId].levels.GetBestBidOffer();
+}
+
+const OrderBook<Bond>& BondMarketDataService::AggregateDepth(const string &productId)
+{
+	// the price levels are kept aggregated and sorted as the orders change,
+	// the order book view of them is only re-built on the first query after a change
+	BondLevelBook &levelbook = levelbookMap[productId];
+	if (levelbook.depthStale)
 	{
-		Order bid(iter->first, iter->second, BID);
-		newbidOrders.push_back(bid);
+		const Bond &product = levelbook.stale ? *levelbook.product : orderbookMap[productId].GetProduct();
+		levelbook.depth = levelbook.levels.ToOrderBook(product);
+		levelbook.depthStale = false;
 	}
-	for (auto iter = offerMap.begin(); iter != offerMap.end(); iter++)
+	return levelbook.depth;
+}
+
+BondMarketDataConnector::BondMarketDataConnector(string path, BondMarketDataService* _bondMarketDataService, 
+	BondProductService* _bondProductService, size_t _batchSize, bool _incremental, size_t parseThreads):
+	bondMarketDataService(_bondMarketDataService), batchSize(_batchSize), incremental(_incremental)
+{
+	if (batchSize == 0) batchSize = 1;
+	batch.resize(incremental ? 0 : batchSize);
+	updateBatch.resize(incremental ? batchSize : 0);
+	for (int venue = 0; venue < NUM_MARKETS; venue++)
+		lastbookMap[venue].Bind(_bondProductService);
+	ParallelCsvReader<BondMarketDataRow> reader(path, parseThreads); // discard header
+
+	if (reader.IsOpen())
 	{
-		Order offer(iter->first, iter->second, OFFER);
-		newofferOrders.push_back(offer);
-	}
+		std::cout << "Market data: Begin to read data...\n";
 
-	// re-construct the order book
-	OrderBook<Bond> neworderbook(orderbook.GetProduct(), newbidOrders, newofferOrders);
+		// parse the rows of a chunk (on a thread of the pool)
+		auto parse = [_bondProductService](CsvReader &chunk, std::vector<BondMarketDataRow> &rows) {
+			const BondReferenceTable &bonds = _bondProductService->GetTable(); // looked up without a lock, straight from the parsed fields
+			BondMarketDataRow row;
+			while (chunk.NextRow())
+			{
+				if (chunk.GetFieldCount() < 13)
+				{
+					std::cout << "Oh no! Market data: skip a row with missing fields!\n";
+					continue;
+				}
+
+				// the bond product of the bond Id
+				row.product = bonds.Find(chunk.GetField(1)); // bond id, bond id type, ticker, coupon, maturity
+				if (row.product == nullptr)
+				{
+					std::cout << "Oh no! Market data: skip a row with an unknown bond!\n";
+					continue;
+				}
+				// mid price and the 5 spreads (parsed as one column)
+				if (!chunk.GetTicks(2, 6, row.ticks))
+				{
+					std::cout << "Oh no! Market data: skip a row with a malformed price!\n";
+					continue;
+				}
+				for (int i = 0; i < 5; i++)
+					row.quantities[i] = chunk.GetLong(8 + i);
+				// venue
+				row.venue = BROKERTEC;
+				if (chunk.GetFieldCount() > 13 && boost::algorithm::iequals(chunk.GetField(13), "ESPEED")) row.venue = ESPEED;
+				else if (chunk.GetFieldCount() > 13 && boost::algorithm::iequals(chunk.GetField(13), "CME")) row.venue = CME;
+				rows.push_back(row);
+			}
+		};
 
-	orderbookMap[productId] = neworderbook;
-	return orderbookMap[productId];
+		// hand over the rows in file order
+		reader.Run(parse, [this](std::vector<BondMarketDataRow> &rows) { HandOver(rows); });
+		FlushBatch();
+		std::cout << "Market data: finished!\n";
+		reader.Report(std::cout, "Market data");
+	}
+	else
+	{
+		std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+	}
 }
-
-BondMarketDataConnector::BondMarketDataConnector(
-	string path, Service<string, OrderBook<Bond>>* _bondMarketDataService, BondProductService* _bondProductService):
-	bondMarketDataService(_bondMarketDataService)
+								
+BondMarketDataConnector::BondMarketDataConnector(RecordPipe<BondMarketDataRow>* pipe, 
+	BondMarketDataService* _bondMarketDataService, size_t _batchSize, bool _incremental):
+	bondMarketDataService(_bondMarketDataService), batchSize(_batchSize), incremental(_incremental)
 {
-	fstream file(path, std::ios::in);
-	string line;
-	std::stringstream ss;
-	char separator = ','; // comma seperator
+	if (batchSize == 0) batchSize = 1;
+	batch.resize(incremental ? 0 : batchSize);
+	updateBatch.resize(incremental ? batchSize : 0);
+
+	std::cout << "Market data: Begin to take data from the generator...\n";
+	std::vector<BondMarketDataRow> rows; // re-used chunk
+	RecordPipeCloser<BondMarketDataRow> closer(pipe); // the generator stops if the chunks are no longer taken
+	while (pipe->Pop(rows))
+		HandOver(rows);
+	FlushBatch();
+	std::cout << "Market data: finished!\n";
+}
 
-	if (file.is_open())
+void BondMarketDataConnector::HandOver(std::vector<BondMarketDataRow> &rows)
+{
+	for (const BondMarketDataRow &row : rows)
 	{
-		std::cout << "Market data: Begin to read data...\n";
-		getline(file, line); // discard header
+		const Bond &bond = *row.product;
+		const long* ticks = row.ticks;
+		TickPrice midprice = TickPrice::FromTicks(ticks[0]);
+		Market venue = row.venue;
 
-		while (getline(file, line))
+		if (incremental)
 		{
-			stringstream sin(line);
-
-			// save all trimmed data into a vector of strings
-			std::vector<string> tempData;
-			string info;
-			while (getline(sin, info, separator))
+			// the price levels of the row
+			FixedDepthOrderBook<Bond> levelbook(&bond);
+			for (int i = 1; i <= 5; i++)
 			{
-				boost::algorithm::trim(info);
-				tempData.push_back(info);
+				TickPrice spread = TickPrice::FromTicks(ticks[i]);
+				long quantity = row.quantities[i - 1];
+				levelbook.AddLevel(BID, midprice - spread, quantity);
+				levelbook.AddLevel(OFFER, midprice + spread, quantity);
 			}
 
-			// make the corresponding trade object
-			// bond Id
-			BondIdType type = (boost::algorithm::to_upper_copy(tempData[0]) == "CUSIP") ? CUSIP : ISIN;
-			string bondId = tempData[1];
-			// the bond product
-			Bond bond = _bondProductService->GetData(bondId); // bond id, bond id type, ticker, coupon, maturity
-			// mid price
-			double midprice = StringtoPrice<double>(ss, tempData[2]);
-			// 5 bid orders and 5 offer orders
-			std::vector<Order> bidOrders;
-			std::vector<Order> offerOrders;
-			for (int i = 1; i <= 5; i++)
+			// the messages from the last snapshot of the product
+			// (too many for one update: the book the service has after the first ones is diffed again for the rest)
+			FixedDepthOrderBook<Bond> &lastbook = lastbookMap[venue][bond];
+			bool complete = false;
+			while (!complete)
 			{
-				Order bid(midprice - StringtoPrice<double>(ss, tempData[2 + i]), 
-					StringtoType<long>(ss, tempData[7 + i]), BID);
-				Order offer(midprice + StringtoPrice<double>(ss, tempData[2 + i]),
-					StringtoType<long>(ss, tempData[7 + i]), OFFER);
-				bidOrders.push_back(bid);
-				offerOrders.push_back(offer);
+				MarketDataUpdate<Bond> &update = updateBatch[batchCount];
+				update.Reset(&bond, venue);
+				complete = MakeLevelUpdates(lastbook, levelbook, update);
+				if (complete)
+					lastbook = levelbook;
+				else
+					ApplyLevelUpdates(lastbook, update);
+				if (update.GetSize() > 0) batchCount++; // nothing to hand over if the book has not changed
+				if (batchCount == batchSize) // hand over a full batch
+				{
+					bondMarketDataService->OnUpdateBatch(updateBatch.data(), batchCount);
+					batchCount = 0;
+				}
 			}
+			counter++;
+			continue;
+		}
 
-			// order book object
-			OrderBook<Bond> orderbook(bond, bidOrders, offerOrders);
+		// 5 bid orders and 5 offer orders
+		std::vector<Order> bidOrders;
+		std::vector<Order> offerOrders;
+		for (int i = 1; i <= 5; i++)
+		{
+			TickPrice spread = TickPrice::FromTicks(ticks[i]);
+			long quantity = row.quantities[i - 1];
+			Order bid(midprice - spread, quantity, BID);
+			Order offer(midprice + spread, quantity, OFFER);
+			bidOrders.push_back(bid);
+			offerOrders.push_back(offer);
+		}
 
-			bondMarketDataService->OnMessage(orderbook);
+		// order book object
+		batch[batchCount++] = OrderBook<Bond>(bond, bidOrders, offerOrders);
+		if (batchCount == batchSize) // hand over a full batch
+		{
+			bondMarketDataService->OnMessageBatch(batch.data(), batchCount);
+			batchCount = 0;
 		}
-		std::cout << "Market data: finished!\n";
-	}
-	else
-	{
-		std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+		counter++;
 	}
 }
-								
+
+void BondMarketDataConnector::FlushBatch()
+{
+	if (batchCount > 0 && incremental) // the last partial batch
+		bondMarketDataService->OnUpdateBatch(updateBatch.data(), batchCount);
+	else if (batchCount > 0)
+		bondMarketDataService->OnMessageBatch(batch.data(), batchCount);
+	batchCount = 0;
+}
+
 void BondMarketDataConnector::Publish(OrderBook <Bond> &data)
 {  // undefined publish() for subsribe connector
 }
 
+long BondMarketDataConnector::GetRecordCount() const
+{
+	return counter;
+}
+
 #endif // !BondMarketDataSoa_hpp
 
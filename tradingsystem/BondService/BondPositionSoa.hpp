@@ -14,20 +14,39 @@
 #include "tradebookingservice.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "HistoricalJournal.hpp"
+#include "ServiceSnapshot.hpp"
 #include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
 
 // Bond position service
 class BondPositionService : public PositionService<Bond>
 {
 protected:
 	std::vector<ServiceListener<Position<Bond>>*> listeners;
-	std::unordered_map<string, Position<Bond>> positionMap; // key on product identifier
+	ProductHandleMap<Position<Bond>> positionMap; // key on product handle
+	std::string snapshotPath; // the file of the snapshots of the positions
+	std::size_t snapshotEvery; // # of position updates between two snapshots (0 for none)
+	std::size_t sinceSnapshot; // # of position updates since the last snapshot
+	std::uint64_t updateCount; // # of position updates sent, i.e. of position records in the journal
+	SnapshotCommitter snapshotCommitter; // writes the periodic snapshots in the background
+	const JournalWriter* journal; // the journal the position updates are persisted to, if any
+
+	// Add the positions to a snapshot
+	void MakeSnapshot(SnapshotWriter &writer);
+
+	// Set the position of a bond from a snapshot or journal record
+	void RestorePosition(const PositionRecord &record);
 
 public:
 	BondPositionService(BondProductService* bondProductService, std::string ticker); 
 
 	// Get data on our service given a key
-	virtual Position<Bond> & GetData(string key);
+	virtual Position<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Position<Bond> &data);
@@ -42,6 +61,21 @@ public:
 	// Add a trade to the service
 	virtual void AddTrade(const Trade<Bond> &trade);
 
+	// Take a snapshot of the positions into the file every this # of position updates (0 for none), written in the background
+	void SetSnapshot(const std::string &_snapshotPath, std::size_t _snapshotEvery);
+
+	// Write a snapshot of the positions now, return false if it cannot be written
+	bool SaveSnapshot();
+
+	// Set the journal the position updates are persisted to (by the historical data connector), recorded in the snapshots
+	void SetJournal(const JournalWriter* _journal);
+
+	// Restore the positions from the snapshot, then replay the position records of the journal that follow it
+	// (only if the journal was attached when the snapshot was taken)
+	// return the # of journal records replayed, -1 if there is no snapshot
+	// (the updates are then counted from zero for the journal of the new run: save a snapshot once it is set)
+	long Restore(const std::string &journalPath);
+
 };
 
 // corresponding service listener
@@ -63,19 +97,21 @@ public:
 	virtual void ProcessUpdate(Trade<Bond> &data);
 };
 
-BondPositionService::BondPositionService(BondProductService* bondProductService, std::string ticker)
+BondPositionService::BondPositionService(BondProductService* bondProductService, std::string ticker) :
+	snapshotEvery(0), sinceSnapshot(0), updateCount(0), journal(nullptr)
 {
-	std::vector<Bond> products = bondProductService->GetBonds(ticker);
+	BondView products = bondProductService->GetBonds(ticker);
 
-	// initialize the position map
+	// initialize the position map, with a slot for each product
+	positionMap.Bind(bondProductService);
 	for (auto iter = products.begin(); iter != products.end(); iter++)
 	{
 		Position<Bond> position(*iter);
-		positionMap.insert(std::make_pair(iter->GetProductId(), position));
+		positionMap[*iter] = position;
 	}
 }
 
-Position<Bond> & BondPositionService::GetData(string key)
+Position<Bond> & BondPositionService::GetData(const string &key)
 {
 	return positionMap[key];
 }
@@ -97,19 +133,111 @@ const vector< ServiceListener<Position<Bond>>* >& BondPositionService::GetListen
 void BondPositionService::AddTrade(const Trade<Bond> &trade)
 {
 	// Update the position based on this trade
-	string productId = trade.GetProduct().GetProductId();
 	string book = trade.GetBook();
 	int sign = (trade.GetSide() == BUY) ? 1 : -1;
 	long quantity = sign * trade.GetQuantity();
-	Position<Bond> position = positionMap[productId];
+	Position<Bond> position = positionMap[trade.GetProduct()];
 	position.AddNewPosition(book, quantity);
-	positionMap[productId] = position;
+	positionMap[trade.GetProduct()] = position;
 
 	// Send this position to the listeners
 	for (auto listener : listeners)
 		listener->ProcessUpdate(position);
-	
+	updateCount++;
+
+	// periodic snapshot
+	if (snapshotEvery > 0 && ++sinceSnapshot >= snapshotEvery)
+	{
+		sinceSnapshot = 0;
+		SnapshotWriter writer(snapshotPath, (journal != nullptr) ? journal->GetRunId() : 0);
+		MakeSnapshot(writer);
+		snapshotCommitter.Commit(writer);
+	}
+}
+
+void BondPositionService::SetSnapshot(const std::string &_snapshotPath, std::size_t _snapshotEvery)
+{
+	snapshotPath = _snapshotPath;
+	snapshotEvery = _snapshotEvery;
+}
+
+bool BondPositionService::SaveSnapshot()
+{
+	sinceSnapshot = 0;
+	snapshotCommitter.Wait();
+	if (snapshotPath.empty())
+		return false;
+	SnapshotWriter writer(snapshotPath, (journal != nullptr) ? journal->GetRunId() : 0);
+	MakeSnapshot(writer);
+	return writer.Commit();
+}
+
+void BondPositionService::SetJournal(const JournalWriter* _journal)
+{
+	journal = _journal;
+}
+
+void BondPositionService::MakeSnapshot(SnapshotWriter &writer)
+{
+	std::vector<PositionRecord> records;
+	positionMap.ForEach([&records](Position<Bond> position) { // a copy: reading a book creates it
+		PositionRecord record;
+		MakeJournalRecord(position, record);
+		records.push_back(record);
+	});
+	writer.AddSection(POSITION_RECORD, updateCount, records);
+}
+
+void BondPositionService::RestorePosition(const PositionRecord &record)
+{
+	// hard-coded the book id, as in the journal records
+	std::string books[3] = { "TRSY1", "TRSY2", "TRSY3" };
+	std::string productId = GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH);
+	try
+	{
+		Position<Bond> &position = positionMap.At(productId);
+		Position<Bond> restored(position.GetProduct());
+		for (int i = 0; i < 3; i++)
+		{
+			if (record.positions[i] != 0)
+				restored.AddNewPosition(books[i], static_cast<long>(record.positions[i]));
+		}
+		position = restored;
+	}
+	catch (const std::out_of_range &)
+	{
+		std::cout << "Oh no! No position of " << productId << " to restore!\n";
+	}
+}
+
+long BondPositionService::Restore(const std::string &journalPath)
+{
+	SnapshotReader snapshot(snapshotPath);
+	std::vector<PositionRecord> records;
+	std::uint64_t journalRecords = 0;
+	if (!snapshot.GetSection(POSITION_RECORD, records, journalRecords))
+		return -1;
+	for (const PositionRecord &record : records)
+		RestorePosition(record);
+
+	// the position records that follow the snapshot, if the journal is the one they were counted in
+	// (the journal may be missing or shorter if the run stopped early)
+	long replayed = 0;
+	std::uint64_t seen = 0;
+	JournalReader reader(journalPath);
+	bool follows = snapshot.GetJournalRunId() != 0 && reader.GetRunId() == snapshot.GetJournalRunId();
+	if (reader.IsOpen() && !follows)
+		std::cout << "Oh no! The journal " << journalPath << " does not follow the snapshot, it is not replayed!\n";
+	while (follows && reader.NextRecord())
+	{
+		if (reader.GetHeader().type != POSITION_RECORD || seen++ < journalRecords)
+			continue;
+		RestorePosition(reader.GetRecord<PositionRecord>());
+		replayed++;
+	}
 
+	updateCount = 0;
+	return replayed;
 }
 
 BondPositionListener::BondPositionListener(BondPositionService* _bondPositionService) :
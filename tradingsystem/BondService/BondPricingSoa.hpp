@@ -12,8 +12,12 @@
 #include "pricingservice.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
 #include "utilityfunction.hpp"
 #include "productservice.hpp"
+#include "CsvReader.hpp"
+#include "ParallelCsvReader.hpp"
+#include "RecordPipe.hpp"
 #include "boost/algorithm/string.hpp" // string algorithm
 #include "boost/date_time/gregorian/gregorian.hpp" // date operation
 #include <string>
@@ -28,17 +32,20 @@ class BondPricingService : public PricingService<Bond>
 {
 protected:
 	std::vector<ServiceListener<Price<Bond>>*> listeners;
-	std::unordered_map<string, Price<Bond>> priceMap; // key on product identifier
+	ProductHandleMap<Price<Bond>> priceMap; // key on product handle
 
 public:
-	BondPricingService() {} // empty ctor
+	BondPricingService(BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual Price<Bond> & GetData(string key);
+	virtual Price<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Price<Bond> &data);
 
+	// The callback that a Connector can invoke for a contiguous batch of new or updated data
+	virtual void OnMessageBatch(Price<Bond> *data, size_t size);
+
 	// Add a listener to the Service for callbacks on add, remove, and update events
 	// for data to the Service.
 	virtual void AddListener(ServiceListener<Price<Bond>> *listener);
@@ -54,17 +61,40 @@ class BondPricingConnector : public Connector<Price<Bond>>
 {
 protected:
 	Service<string,Price <Bond>>* bondPricingService;
+	long counter = 0; // # of records read
+	std::vector<Price<Bond>> batch; // re-used batch buffer
+	size_t batchCount = 0; // # of prices in the batch
+
+	// Hand over the prices of a chunk in batches, in order
+	void HandOver(std::vector<Price<Bond>> &prices);
+
+	// Hand over the last partial batch
+	void FlushBatch();
 
 public:
-	BondPricingConnector(string path, 
-		Service<string, Price <Bond>>* _bondPricingService, BondProductService* _bondProductService); // ctor
+	// ctor, hands over batchSize prices at once
+	// (the file is parsed in chunks on parseThreads threads, 0 for one per core, the prices still handed over in file order)
+	BondPricingConnector(string path, Service<string, Price <Bond>>* _bondPricingService, 
+		BondProductService* _bondProductService, size_t batchSize = 1024, size_t parseThreads = 1);
+
+	// ctor, hands over batchSize prices at once, taken from the pipe fed by a generator (no file)
+	BondPricingConnector(RecordPipe<Price<Bond>>* pipe, Service<string, Price <Bond>>* _bondPricingService,
+		size_t batchSize = 1024);
 
 	// Publish data to the Connector
 	virtual void Publish(Price <Bond> &data);
 
+	// Get the number of records read
+	long GetRecordCount() const;
+
 };
 
-Price<Bond> & BondPricingService::GetData(string key)
+BondPricingService::BondPricingService(BondProductService* _bondProductService)
+{
+	priceMap.Bind(_bondProductService);
+}
+
+Price<Bond> & BondPricingService::GetData(const string &key)
 {
 	return priceMap[key]; 
 }
@@ -72,11 +102,7 @@ Price<Bond> & BondPricingService::GetData(string key)
 void BondPricingService::OnMessage(Price<Bond> &data)
 {
 	// push the data into map
-	string productId = data.GetProduct().GetProductId();
-	if (priceMap.find(productId) == priceMap.end()) // if not found this one then create one
-		priceMap.insert(std::make_pair(productId, data));
-	else
-		priceMap[productId] = data;
+	priceMap[data.GetProduct()] = data;
 
 	// call the listeners
 	for (auto listener : listeners)
@@ -84,6 +110,17 @@ void BondPricingService::OnMessage(Price<Bond> &data)
 
 }
 
+void BondPricingService::OnMessageBatch(Price<Bond> *data, size_t size)
+{
+	// push the data into map
+	for (size_t i = 0; i < size; i++)
+		priceMap[data[i].GetProduct()] = data[i];
+
+	// call the listeners with the whole batch
+	for (auto listener : listeners)
+		listener->ProcessAddBatch(data, size);
+}
+
 void BondPricingService::AddListener(ServiceListener<Price<Bond>> *listener)
 {
 	listeners.push_back(listener);
@@ -94,50 +131,54 @@ const vector< ServiceListener<Price<Bond>>* >& BondPricingService::GetListeners(
 	return listeners;
 }
 
-BondPricingConnector::BondPricingConnector(string path,
-	Service<string, Price <Bond>>* _bondPricingService, BondProductService* _bondProductService):
+BondPricingConnector::BondPricingConnector(string path, Service<string, Price <Bond>>* _bondPricingService,
+	BondProductService* _bondProductService, size_t batchSize, size_t parseThreads):
 	bondPricingService(_bondPricingService)
 {
-	fstream file(path, std::ios::in);
-	string line;
-	std::stringstream ss;
-	char separator = ','; // comma seperator
+	ParallelCsvReader<Price<Bond>> reader(path, parseThreads); // discard header
+	if (batchSize == 0) batchSize = 1;
+	batch.resize(batchSize);
 
-	if (file.is_open())
+	if (reader.IsOpen())
 	{
 		std::cout << "Price: Begin to read data...\n";
-		getline(file, line); // discard header
-
-		while (getline(file, line))
-		{
-			stringstream sin(line);
 
-			// save all trimmed data into a vector of strings
-			std::vector<string> tempData;
-			string info;
-			while (getline(sin, info, separator))
+		// parse the price objects of a chunk (on a thread of the pool)
+		auto parse = [_bondProductService](CsvReader &chunk, std::vector<Price<Bond>> &prices) {
+			const BondReferenceTable &bonds = _bondProductService->GetTable(); // looked up without a lock, straight from the parsed fields
+			while (chunk.NextRow())
 			{
-				boost::algorithm::trim(info);
-				tempData.push_back(info);
+				if (chunk.GetFieldCount() < 4)
+				{
+					std::cout << "Oh no! Price: skip a row with missing fields!\n";
+					continue;
+				}
+
+				// the bond product of the bond Id
+				const Bond* bond = bonds.Find(chunk.GetField(1)); // bond id, bond id type, ticker, coupon, maturity
+				if (bond == nullptr)
+				{
+					std::cout << "Oh no! Price: skip a row with an unknown bond!\n";
+					continue;
+				}
+				// bond price and bond price spread
+				TickPrice mid, spread;
+				if (!chunk.GetTickPrice(2, mid) || !chunk.GetTickPrice(3, spread))
+				{
+					std::cout << "Oh no! Price: skip a row with a malformed price!\n";
+					continue;
+				}
+
+				// price object
+				prices.push_back(Price<Bond>(*bond, mid, spread));
 			}
+		};
 
-			// make the corresponding trade object
-			// bond Id
-			BondIdType type = (boost::algorithm::to_upper_copy(tempData[0]) == "CUSIP") ? CUSIP : ISIN;
-			string bondId = tempData[1];
-			// the bond product
-			Bond bond = _bondProductService->GetData(bondId); // bond id, bond id type, ticker, coupon, maturity
-			// bond price
-			double mid = StringtoPrice<double>(ss, tempData[2]);
-			// bond price spread
-			double spread = StringtoPrice<double>(ss, tempData[3]);
-
-			// price object
-			Price<Bond> price(bond, mid, spread);
-
-			bondPricingService->OnMessage(price);
-		}
+		// hand over the prices in file order
+		reader.Run(parse, [this](std::vector<Price<Bond>> &prices) { HandOver(prices); });
+		FlushBatch();
 		std::cout << "Price: finished!\n";
+		reader.Report(std::cout, "Price");
 	}
 	else
 	{
@@ -145,8 +186,50 @@ BondPricingConnector::BondPricingConnector(string path,
 	}
 }
 
+BondPricingConnector::BondPricingConnector(RecordPipe<Price<Bond>>* pipe, 
+	Service<string, Price <Bond>>* _bondPricingService, size_t batchSize):
+	bondPricingService(_bondPricingService)
+{
+	if (batchSize == 0) batchSize = 1;
+	batch.resize(batchSize);
+
+	std::cout << "Price: Begin to take data from the generator...\n";
+	std::vector<Price<Bond>> prices; // re-used chunk
+	RecordPipeCloser<Price<Bond>> closer(pipe); // the generator stops if the chunks are no longer taken
+	while (pipe->Pop(prices))
+		HandOver(prices);
+	FlushBatch();
+	std::cout << "Price: finished!\n";
+}
+
+void BondPricingConnector::HandOver(std::vector<Price<Bond>> &prices)
+{
+	for (auto &price : prices)
+	{
+		batch[batchCount++] = std::move(price);
+		if (batchCount == batch.size()) // hand over a full batch
+		{
+			bondPricingService->OnMessageBatch(batch.data(), batchCount);
+			batchCount = 0;
+		}
+		counter++;
+	}
+}
+
+void BondPricingConnector::FlushBatch()
+{
+	if (batchCount > 0) // the last partial batch
+		bondPricingService->OnMessageBatch(batch.data(), batchCount);
+	batchCount = 0;
+}
+
 void BondPricingConnector::Publish(Price <Bond> &data)
 { // undefined publish() for subsribe connector
 }
 
+long BondPricingConnector::GetRecordCount() const
+{
+	return counter;
+}
+
 #endif // !BondPricingSoa_hpp
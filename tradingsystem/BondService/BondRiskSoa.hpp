@@ -14,8 +14,14 @@
 #include "productservice.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "HistoricalJournal.hpp"
+#include "ServiceSnapshot.hpp"
 #include <unordered_map>
 #include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
 
 // Bond risk service
 class BondRiskService : public RiskService<Bond>
@@ -23,14 +29,30 @@ class BondRiskService : public RiskService<Bond>
 protected:
 	BondProductService* bondProductService;
 	std::vector<ServiceListener<PV01<Bond>>*> listeners;
-	std::unordered_map<string, PV01<Bond>> pv01Map; // key on product identifier
+	ProductHandleMap<PV01<Bond>> pv01Map; // key on product handle
 	std::unordered_map<string, PV01<BucketedSector<Bond>>> bucketpv01Map; // key on sector name
+	std::string snapshotPath; // the file of the snapshots of the PV01s
+	std::size_t snapshotEvery; // # of PV01 updates between two snapshots (0 for none)
+	std::size_t sinceSnapshot; // # of PV01 updates since the last snapshot
+	std::uint64_t updateCount; // # of PV01 updates sent, i.e. of PV01 records in the journal
+	std::uint64_t bucketUpdateCount; // # of bucketed risk updates, i.e. of bucketed PV01 records in the journal
+	SnapshotCommitter snapshotCommitter; // writes the periodic snapshots in the background
+	const JournalWriter* journal; // the journal the PV01 and bucketed risk updates are persisted to, if any
+
+	// Add the PV01s and the bucketed PV01s to a snapshot
+	void MakeSnapshot(SnapshotWriter &writer);
+
+	// Set the PV01 of a bond from a snapshot or journal record
+	void RestorePV01(const PV01Record &record);
+
+	// Set the PV01 of a bucketed sector from a snapshot or journal record
+	void RestoreBucketedPV01(const PV01Record &record, const std::unordered_map<string, std::vector<string>> &buckets);
 
 public:
 	BondRiskService(BondProductService* _bondProductService, std::unordered_map<string, double>& _pv01); // ctor
 
 	// Get data on our service given a key
-	virtual PV01<Bond> & GetData(string key);
+	virtual PV01<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(PV01<Bond> &data);
@@ -50,6 +72,23 @@ public:
 
 	// Get the bucketed risk for the bucket sector
 	virtual const PV01<BucketedSector<Bond>>& GetBucketedRisk(const BucketedSector<Bond> &sector) const;
+
+	// Take a snapshot of the PV01s and the bucketed PV01s into the file every this # of PV01 updates (0 for none), written in the background
+	// (taken on the thread of AddPosition(): the bucketed risk must be updated by a listener called on that thread)
+	void SetSnapshot(const std::string &_snapshotPath, std::size_t _snapshotEvery);
+
+	// Write a snapshot of the PV01s and the bucketed PV01s now, return false if it cannot be written
+	bool SaveSnapshot();
+
+	// Set the journal the PV01s and the bucketed PV01s are persisted to (by the historical data connector), recorded in the snapshots
+	void SetJournal(const JournalWriter* _journal);
+
+	// Restore the PV01s and the bucketed PV01s (of the sectors of buckets: sector name -> product identifiers)
+	// from the snapshot, then replay the records of the journal that follow it
+	// (only if the journal was attached when the snapshot was taken)
+	// return the # of journal records replayed, -1 if there is no snapshot
+	// (the updates are then counted from zero for the journal of the new run: save a snapshot once it is set)
+	long Restore(const std::string &journalPath, const std::unordered_map<string, std::vector<string>> &buckets);
 };
 
 // corresponding service listener
@@ -72,18 +111,24 @@ public:
 };
 
 BondRiskService::BondRiskService(BondProductService* _bondProductService, std::unordered_map<string, double>& _pv01):
-	bondProductService(_bondProductService)
+	bondProductService(_bondProductService), snapshotEvery(0), sinceSnapshot(0), updateCount(0), bucketUpdateCount(0),
+	journal(nullptr)
 {
-	// initialize the pv01 map
+	// initialize the pv01 map, with a slot for each product
+	pv01Map.Bind(bondProductService);
 	for (auto iter = _pv01.begin(); iter != _pv01.end(); iter++)
 	{
-		string productId = iter->first;
-		pv01Map.insert(std::make_pair(productId, 
-			PV01<Bond>(bondProductService->GetData(productId), iter->second, 0)));
+		const Bond* bond = bondProductService->GetTable().Find(iter->first);
+		if (bond == nullptr)
+		{
+			std::cout << "Oh no! No bond " << iter->first << " for its PV01!\n";
+			continue;
+		}
+		pv01Map[*bond] = PV01<Bond>(*bond, iter->second, 0);
 	}
 }
 
-PV01<Bond> & BondRiskService::GetData(string key)
+PV01<Bond> & BondRiskService::GetData(const string &key)
 {
 	return pv01Map[key];
 }
@@ -105,34 +150,40 @@ const vector< ServiceListener<PV01<Bond>>* >& BondRiskService::GetListeners() co
 void BondRiskService::AddPosition(Position<Bond> &position)
 {
 	// retrieve the corresponding pv01
-	string productId = position.GetProduct().GetProductId();
-	PV01<Bond> productPv = pv01Map[productId];
+	PV01<Bond> productPv = pv01Map[position.GetProduct()];
 
 	// Update the pv01 object
 	long long newQuantity = position.GetAggregatePosition() + productPv.GetQuantity();
 	PV01<Bond> productNewPv(productPv.GetProduct(), productPv.GetPV01(), newQuantity);
-	pv01Map[productId] = productNewPv;
+	pv01Map[position.GetProduct()] = productNewPv;
 		
 	// call the listeners with the pv01 update of a single product
 	for (auto listener : listeners)
 		listener->ProcessUpdate(productNewPv); 
-	
-	
+	updateCount++;
+
+	// periodic snapshot
+	if (snapshotEvery > 0 && ++sinceSnapshot >= snapshotEvery)
+	{
+		sinceSnapshot = 0;
+		SnapshotWriter writer(snapshotPath, (journal != nullptr) ? journal->GetRunId() : 0);
+		MakeSnapshot(writer);
+		snapshotCommitter.Commit(writer);
+	}
 }
 
 void BondRiskService::UpdateBucketedRisk(const BucketedSector<Bond> &sector)
 {
 	std::vector<Bond> products = sector.GetProducts();
-	string productId;
 	long long sum_quantity = 0;
 	double sum_pv01 = 0.0;
 
 	// calculate the overall pv01 and the overall quantity
 	for (Bond product : products)
 	{
-		productId = product.GetProductId();
-		sum_quantity += pv01Map.at(productId).GetQuantity();
-		sum_pv01 += pv01Map.at(productId).GetPV01() * pv01Map.at(productId).GetQuantity();
+		const PV01<Bond> &productPv = pv01Map.At(product);
+		sum_quantity += productPv.GetQuantity();
+		sum_pv01 += productPv.GetPV01() * productPv.GetQuantity();
 	}
 
 	double unit_pv01 = 0.0;
@@ -147,6 +198,7 @@ void BondRiskService::UpdateBucketedRisk(const BucketedSector<Bond> &sector)
 		bucketpv01Map.insert(std::make_pair(name, bucketpv01));
 	else
 		bucketpv01Map[name] = bucketpv01;
+	bucketUpdateCount++;
 }
 
 const PV01<BucketedSector<Bond>>& BondRiskService::GetBucketedRisk(const BucketedSector<Bond> &sector) const
@@ -156,6 +208,125 @@ const PV01<BucketedSector<Bond>>& BondRiskService::GetBucketedRisk(const Buckete
 
 }
 
+void BondRiskService::SetSnapshot(const std::string &_snapshotPath, std::size_t _snapshotEvery)
+{
+	snapshotPath = _snapshotPath;
+	snapshotEvery = _snapshotEvery;
+}
+
+bool BondRiskService::SaveSnapshot()
+{
+	sinceSnapshot = 0;
+	snapshotCommitter.Wait();
+	if (snapshotPath.empty())
+		return false;
+	SnapshotWriter writer(snapshotPath, (journal != nullptr) ? journal->GetRunId() : 0);
+	MakeSnapshot(writer);
+	return writer.Commit();
+}
+
+void BondRiskService::SetJournal(const JournalWriter* _journal)
+{
+	journal = _journal;
+}
+
+void BondRiskService::MakeSnapshot(SnapshotWriter &writer)
+{
+	std::vector<PV01Record> records;
+	pv01Map.ForEach([&records](PV01<Bond> &pv01) {
+		PV01Record record;
+		MakeJournalRecord(pv01, record);
+		records.push_back(record);
+	});
+	std::vector<PV01Record> bucketRecords;
+	for (auto iter = bucketpv01Map.begin(); iter != bucketpv01Map.end(); iter++)
+	{
+		PV01Record record;
+		MakeJournalRecord(iter->second, record);
+		bucketRecords.push_back(record);
+	}
+	writer.AddSection(PV01_RECORD, updateCount, records);
+	writer.AddSection(BUCKETED_PV01_RECORD, bucketUpdateCount, bucketRecords);
+}
+
+void BondRiskService::RestorePV01(const PV01Record &record)
+{
+	std::string productId = GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH);
+	try
+	{
+		PV01<Bond> &pv01 = pv01Map.At(productId);
+		pv01 = PV01<Bond>(pv01.GetProduct(), record.pv01, record.quantity);
+	}
+	catch (const std::out_of_range &)
+	{
+		std::cout << "Oh no! No PV01 of " << productId << " to restore!\n";
+	}
+}
+
+void BondRiskService::RestoreBucketedPV01(const PV01Record &record,
+	const std::unordered_map<string, std::vector<string>> &buckets)
+{
+	std::string name = GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH);
+	auto bucket = buckets.find(name);
+	if (bucket == buckets.end())
+	{
+		std::cout << "Oh no! No bucketed sector " << name << " to restore!\n";
+		return;
+	}
+	std::vector<Bond> bonds;
+	for (auto iter = bucket->second.begin(); iter != bucket->second.end(); iter++)
+	{
+		const Bond* bond = bondProductService->GetTable().Find(*iter);
+		if (bond == nullptr)
+			std::cout << "Oh no! No bond " << *iter << " in the bucketed sector " << name << "!\n";
+		else
+			bonds.push_back(*bond);
+	}
+	PV01<BucketedSector<Bond>> bucketpv01(BucketedSector<Bond>(bonds, name), record.pv01, record.quantity);
+	if (bucketpv01Map.find(name) == bucketpv01Map.end()) // if not found this one then create one
+		bucketpv01Map.insert(std::make_pair(name, bucketpv01));
+	else
+		bucketpv01Map[name] = bucketpv01;
+}
+
+long BondRiskService::Restore(const std::string &journalPath, const std::unordered_map<string, std::vector<string>> &buckets)
+{
+	SnapshotReader snapshot(snapshotPath);
+	std::vector<PV01Record> records, bucketRecords;
+	std::uint64_t journalRecords = 0, bucketJournalRecords = 0;
+	if (!snapshot.GetSection(PV01_RECORD, records, journalRecords)
+		|| !snapshot.GetSection(BUCKETED_PV01_RECORD, bucketRecords, bucketJournalRecords))
+		return -1;
+	for (const PV01Record &record : records)
+		RestorePV01(record);
+	for (const PV01Record &record : bucketRecords)
+		RestoreBucketedPV01(record, buckets);
+
+	// the records that follow the snapshot, if the journal is the one they were counted in
+	// (the journal may be missing or shorter if the run stopped early)
+	long replayed = 0;
+	std::uint64_t seen = 0, bucketSeen = 0;
+	JournalReader reader(journalPath);
+	bool follows = snapshot.GetJournalRunId() != 0 && reader.GetRunId() == snapshot.GetJournalRunId();
+	if (reader.IsOpen() && !follows)
+		std::cout << "Oh no! The journal " << journalPath << " does not follow the snapshot, it is not replayed!\n";
+	while (follows && reader.NextRecord())
+	{
+		std::uint16_t type = reader.GetHeader().type;
+		if (type == PV01_RECORD && seen++ >= journalRecords)
+			RestorePV01(reader.GetRecord<PV01Record>());
+		else if (type == BUCKETED_PV01_RECORD && bucketSeen++ >= bucketJournalRecords)
+			RestoreBucketedPV01(reader.GetRecord<PV01Record>(), buckets);
+		else
+			continue;
+		replayed++;
+	}
+
+	updateCount = 0;
+	bucketUpdateCount = 0;
+	return replayed;
+}
+
 BondRiskListener::BondRiskListener(BondRiskService* _bondRiskService) :
 	bondRiskService(_bondRiskService)
 {
@@ -13,6 +13,8 @@
 #include "BondService/BondAlgoStreamingSoa.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include <unordered_map>
 
 // Bond streaming service
@@ -20,12 +22,13 @@ class BondStreamingService : public StreamingService<Bond>
 {
 protected:
 	std::vector<ServiceListener<PriceStream<Bond>>*> listeners;
-	std::unordered_map<string, PriceStream<Bond>> streamMap; // key on product identifier
+	ProductHandleMap<PriceStream<Bond>> streamMap; // key on product handle
+	std::vector<PriceStream<Bond>> batch; // re-used buffer for the batch publish
 public:
-	BondStreamingService() {} // empty ctor
+	BondStreamingService(BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual PriceStream<Bond> & GetData(string key);
+	virtual PriceStream<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(PriceStream<Bond> &data);
@@ -39,6 +42,17 @@ public:
 
 	// Publish two-way prices
 	void PublishPrice(const PriceStream<Bond>& priceStream);
+
+	// Publish a batch of two-way prices
+	void PublishPriceBatch(const AlgoStream<Bond>* algoStreams, size_t size);
+
+	// Publish two-way prices to the next stage of a static pipeline
+	template <typename Next>
+	void PublishPrice(const PriceStream<Bond>& priceStream, Next& next);
+
+	// Publish a batch of two-way prices to the next stage of a static pipeline
+	template <typename Next>
+	void PublishPriceBatch(const AlgoStream<Bond>* algoStreams, size_t size, Next& next);
 };
 
 // Bond streaming service listener
@@ -58,9 +72,36 @@ public:
 
 	// Listener callback to process an update event to the Service
 	virtual void ProcessUpdate(AlgoStream<Bond> &data);
+
+	// Listener callback to process a batch of update events to the Service
+	virtual void ProcessUpdateBatch(AlgoStream<Bond> *data, size_t size);
+};
+
+// Bond streaming stage of a static pipeline (see StaticPipeline.hpp)
+// takes the algo streams in place of the bond streaming service listener
+class BondStreamingStage
+{
+protected:
+	BondStreamingService* bondStreamingService;
+
+public:
+	BondStreamingStage(BondStreamingService* _bondStreamingService); // ctor
+
+	// Process the algo stream and hand the price stream to the next stage
+	template <typename Next>
+	void Process(AlgoStream<Bond> &data, Next &next);
+
+	// Process a batch of algo streams and hand the price streams to the next stage
+	template <typename Next>
+	void ProcessBatch(AlgoStream<Bond> *data, size_t size, Next &next);
 };
 
-PriceStream<Bond> & BondStreamingService::GetData(string key)
+BondStreamingService::BondStreamingService(BondProductService* _bondProductService)
+{
+	streamMap.Bind(_bondProductService);
+}
+
+PriceStream<Bond> & BondStreamingService::GetData(const string &key)
 {
 	return streamMap[key];
 }
@@ -82,11 +123,7 @@ const vector< ServiceListener<PriceStream<Bond>>* >& BondStreamingService::GetLi
 void BondStreamingService::PublishPrice(const PriceStream<Bond>& priceStream)
 {
 	// push data to the map
-	string productId = priceStream.GetProduct().GetProductId();
-	if (streamMap.find(productId) == streamMap.end()) // if not found this one then create one
-		streamMap.insert(std::make_pair(productId, priceStream));
-	else
-		streamMap[productId] = priceStream;
+	streamMap[priceStream.GetProduct()] = priceStream;
 
 	// call the listeners
 	PriceStream<Bond> temp(priceStream);
@@ -94,6 +131,53 @@ void BondStreamingService::PublishPrice(const PriceStream<Bond>& priceStream)
 		listener->ProcessAdd(temp);
 }
 
+void BondStreamingService::PublishPriceBatch(const AlgoStream<Bond>* algoStreams, size_t size)
+{
+	// push data to the map
+	if (batch.size() < size) batch.resize(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		const PriceStream<Bond>& priceStream = algoStreams[i].GetStream();
+		streamMap[priceStream.GetProduct()] = priceStream;
+		batch[i] = priceStream;
+	}
+
+	// call the listeners with the whole batch
+	for (auto listener : listeners)
+		listener->ProcessAddBatch(batch.data(), size);
+}
+
+template <typename Next>
+void BondStreamingService::PublishPrice(const PriceStream<Bond>& priceStream, Next& next)
+{
+	// push data to the map
+	streamMap[priceStream.GetProduct()] = priceStream;
+
+	// hand the data to the next stage, then call the listeners
+	PriceStream<Bond> temp(priceStream);
+	next.Push(temp);
+	for (auto listener : listeners)
+		listener->ProcessAdd(temp);
+}
+
+template <typename Next>
+void BondStreamingService::PublishPriceBatch(const AlgoStream<Bond>* algoStreams, size_t size, Next& next)
+{
+	// push data to the map
+	if (batch.size() < size) batch.resize(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		const PriceStream<Bond>& priceStream = algoStreams[i].GetStream();
+		streamMap[priceStream.GetProduct()] = priceStream;
+		batch[i] = priceStream;
+	}
+
+	// hand the whole batch to the next stage, then call the listeners
+	next.PushBatch(batch.data(), size);
+	for (auto listener : listeners)
+		listener->ProcessAddBatch(batch.data(), size);
+}
+
 BondStreamingListener::BondStreamingListener(BondStreamingService* _bondStreamingService):
 	bondStreamingService(_bondStreamingService)
 {
@@ -115,5 +199,28 @@ void BondStreamingListener::ProcessUpdate(AlgoStream<Bond> &data)
 
 }
 
+void BondStreamingListener::ProcessUpdateBatch(AlgoStream<Bond> *data, size_t size)
+{
+	// publish the price streams of the whole batch
+	bondStreamingService->PublishPriceBatch(data, size);
+}
+
+BondStreamingStage::BondStreamingStage(BondStreamingService* _bondStreamingService) :
+	bondStreamingService(_bondStreamingService)
+{
+}
+
+template <typename Next>
+void BondStreamingStage::Process(AlgoStream<Bond> &data, Next &next)
+{
+	bondStreamingService->PublishPrice(data.GetStream(), next);
+}
+
+template <typename Next>
+void BondStreamingStage::ProcessBatch(AlgoStream<Bond> *data, size_t size, Next &next)
+{
+	bondStreamingService->PublishPriceBatch(data, size, next);
+}
+
 
 #endif // !BondStreamingSoa_hpp
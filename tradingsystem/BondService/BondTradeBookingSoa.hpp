@@ -16,6 +16,7 @@
 #include "soa.hpp"
 #include "utilityfunction.hpp"
 #include "productservice.hpp"
+#include "CsvReader.hpp"
 #include "boost/algorithm/string.hpp" // string algorithm
 #include "boost/date_time/gregorian/gregorian.hpp" // date operation
 #include <vector>
@@ -23,20 +24,26 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <atomic>
+#include <mutex>
 
 // Bond trade booking service
 class BondTradeBookingService : public TradeBookingService<Bond>
 {
 protected:
 	std::vector<ServiceListener<Trade<Bond>>*> listeners;
-	long counter = 0; // counter to determine the trade book of the trade coming from bond execution service
+	std::atomic<long> counter{ 0 }; // counter to determine the trade book of the trade coming from bond execution service
 	std::unordered_map<string, Trade<Bond>> tradeMap; // key on trade identifier
+	std::mutex bookingMutex; // trades are booked by both the trade line and the execution line
+
+	// Book the trade, under the booking lock
+	void BookTradeLocked(const Trade<Bond> &trade);
 
 public:
 	BondTradeBookingService() {} // empty ctor
 
 	// Get data on our service given a key
-	virtual Trade<Bond> & GetData(string key);
+	virtual Trade<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Trade<Bond> &data);
@@ -51,6 +58,10 @@ public:
 	// Book the trade
 	virtual void BookTrade(const Trade<Bond> &trade);
 
+	// Book the trade of an execution order: its trade ID and its book are taken from the counter
+	// under the booking lock, so each trade gets its own ID whichever line books first
+	void BookTrade(const ExecutionOrder<Bond> &order);
+
 	// Get the current value of counter
 	const long GetCounter() const;
 
@@ -61,6 +72,7 @@ class BondTradeBookingConnector : public Connector<Trade<Bond>>
 {
 protected:
 	Service<string, Trade<Bond>>* bondTradeBookingService;
+	long counter = 0; // # of records read
 
 public:
 	BondTradeBookingConnector(string path, 
@@ -69,6 +81,9 @@ public:
 	// Publish data to the Connector
 	virtual void Publish(Trade <Bond> &data);
 
+	// Get the number of records read
+	long GetRecordCount() const;
+
 };
 
 // corresponding service listener
@@ -90,7 +105,7 @@ public:
 	virtual void ProcessUpdate(ExecutionOrder<Bond> &data);
 };
 
-Trade<Bond> & BondTradeBookingService::GetData(string key)
+Trade<Bond> & BondTradeBookingService::GetData(const string &key)
 {
 	return tradeMap[key]; 
 
@@ -114,6 +129,44 @@ const vector< ServiceListener<Trade<Bond>>* >& BondTradeBookingService::GetListe
 }
 
 void BondTradeBookingService::BookTrade(const Trade<Bond> &trade)
+{
+	// the whole downstream chain (position, risk and their historical data) runs under the lock
+	std::lock_guard<std::mutex> lock(bookingMutex);
+	BookTradeLocked(trade);
+}
+
+void BondTradeBookingService::BookTrade(const ExecutionOrder<Bond> &order)
+{
+	std::lock_guard<std::mutex> lock(bookingMutex);
+
+	// Determine the atributes of the trade
+	long count = counter;
+	Bond bond = order.GetProduct();
+	// Trade ID (e.g. TRS2024T0000023)
+	std::stringstream ss;
+	ss << "TRS" << std::to_string(bond.GetMaturityDate().year()) << bond.GetTicker()
+		<< std::setfill('0') << std::setw(7) << std::to_string(count);
+	string tradeId = ss.str();
+	// 'hard-coded' determine the book id
+	string bookId;
+	switch (count % 3)
+	{
+	case 0: bookId = "TRSY1"; break;
+	case 1: bookId = "TRSY2"; break;
+	default: bookId = "TRSY3"; break;
+	}
+	// determine the side
+	Side side = BUY;
+	if (order.GetSide() == BID)
+		side = SELL;
+
+	// generate a trade based on the coming execution order
+	Trade<Bond> trade(order.GetProduct(), tradeId, order.GetPrice().ToDouble(), bookId,
+		order.GetHiddenQuantity() + order.GetVisibleQuantity(), side);
+	BookTradeLocked(trade);
+}
+
+void BondTradeBookingService::BookTradeLocked(const Trade<Bond> &trade)
 {
 	string tradeId = trade.GetTradeId();
 	if (tradeMap.find(tradeId) == tradeMap.end()) // if not found this one then create one
@@ -137,52 +190,51 @@ BondTradeBookingConnector::BondTradeBookingConnector(
 	string path, Service<string, Trade<Bond>>* _bondTradeBookingService, BondProductService* _bondProductService):
 	bondTradeBookingService(_bondTradeBookingService)
 {
-	fstream file(path, std::ios::in);
-	string line;
-	std::stringstream ss;
-	char separator = ','; // comma seperator
+	CsvReader reader(path); // discard header
+	string tradeId, bondId, bookId; // re-used field buffers
 
-	if (file.is_open())
+	if (reader.IsOpen())
 	{
 		std::cout << "Trade: Begin to read data...\n";
-		getline(file, line); // discard header
 
-		while (getline(file, line))
+		while (reader.NextRow())
 		{
-			stringstream sin(line);
-
-			// save all trimmed data into a vector of strings
-			std::vector<string> tempData;
-			string info;
-			while (getline(sin, info, separator))
+			if (reader.GetFieldCount() < 7)
 			{
-				boost::algorithm::trim(info);
-				tempData.push_back(info);
+				std::cout << "Oh no! Trade: skip a row with missing fields!\n";
+				continue;
 			}
 
 			// make the corresponding trade object
 			// trade Id
-			string tradeId = tempData[0];
+			reader.GetString(0, tradeId);
 			// bond Id
-			BondIdType type = (boost::algorithm::to_upper_copy(tempData[1]) == "CUSIP") ? CUSIP : ISIN;
-			string bondId = tempData[2];
+			reader.GetString(2, bondId);
 			// the bond product
-			Bond bond = _bondProductService->GetData(bondId); // bond id, bond id type, ticker, coupon, maturity
+			const Bond* product = _bondProductService->GetTable().Find(bondId); // bond id, bond id type, ticker, coupon, maturity
+			if (product == nullptr)
+			{
+				std::cout << "Oh no! Trade: skip a row with an unknown bond!\n";
+				continue;
+			}
+			const Bond &bond = *product;
 			// trade side
-			Side side = (boost::algorithm::to_upper_copy(tempData[3]) == "BUY") ? BUY : SELL;
+			Side side = boost::algorithm::iequals(reader.GetField(3), "BUY") ? BUY : SELL;
 			// trade quantity
-			long quantity = StringtoType<long>(ss, tempData[4]);
+			long quantity = reader.GetLong(4);
 			// trade price
-			double price = StringtoPrice<double>(ss, tempData[5]);
+			double price = reader.GetPrice(5);
 			// book id
-			string bookId = tempData[6];
+			reader.GetString(6, bookId);
 
 			// trade object
 			Trade<Bond> trade(bond, tradeId, price, bookId, quantity, side);
 
 			bondTradeBookingService->OnMessage(trade);
+			counter++;
 		}
 		std::cout << "Trade: finished!\n";
+		reader.Report(std::cout, "Trade");
 	}
 	else
 	{
@@ -194,6 +246,11 @@ void BondTradeBookingConnector::Publish(Trade <Bond> &data)
 { // undefined publish() for subsribe connector
 }
 
+long BondTradeBookingConnector::GetRecordCount() const
+{
+	return counter;
+}
+
 BondTradeBookingListener::BondTradeBookingListener(BondTradeBookingService* _bondTradeBookingService) :
 	bondTradeBookingService(_bondTradeBookingService)
 {
@@ -202,35 +259,8 @@ BondTradeBookingListener::BondTradeBookingListener(BondTradeBookingService* _bon
 
 void BondTradeBookingListener::ProcessAdd(ExecutionOrder<Bond> &data)
 {
-	// Determine the atributes of the trade
-	long counter = bondTradeBookingService->GetCounter();
-	Bond bond = data.GetProduct();
-	// Trade ID (e.g. TRS2024T0000023)
-	std::stringstream ss;
-	ss << "TRS" << std::to_string(bond.GetMaturityDate().year()) << bond.GetTicker()
-		<< std::setfill('0') << std::setw(7) << std::to_string(counter);
-	string tradeId = ss.str();
-	ss.str(""); // release the buffer
-	// 'hard-coded' determine the book id
-	string bookId;
-	switch (counter % 3)
-	{
-	case 0: bookId = "TRSY1"; break;
-	case 1: bookId = "TRSY2"; break;
-	default: bookId = "TRSY3"; break;
-	}
-	// determine the side
-	Side side = BUY;
-	if (data.GetSide() == BID)
-		side = SELL;
-
-	// generate a trade based on the coming execution order
-	Trade<Bond> trade(data.GetProduct(), tradeId, data.GetPrice(), bookId,
-		data.GetHiddenQuantity() + data.GetVisibleQuantity(), side);
-
-	// book the trade
-	bondTradeBookingService->BookTrade(trade);
-
+	// book the trade of the execution order (trade ID and book assigned by the service)
+	bondTradeBookingService->BookTrade(data);
 }
 
 void BondTradeBookingListener::ProcessRemove(ExecutionOrder<Bond> &data)
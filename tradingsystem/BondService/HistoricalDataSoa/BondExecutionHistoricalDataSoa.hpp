@@ -14,28 +14,33 @@
 #include "BondService/BondExecutionSoa.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include "utilityfunction.hpp"
+#include "TimestampFormatter.hpp"
+#include "GroupCommitWriter.hpp"
+#include "JournalQuery.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include <unordered_map>
-#include <fstream>
 #include <sstream>
 #include <iostream>
 
 
 // Bond historical data service for position data
-class BondExecutionHistoricalDataService : public HistoricalDataService<ExecutionOrder<Bond>>
+class BondExecutionHistoricalDataService : public HistoricalDataService<ExecutionOrder<Bond>>, public JournaledHistoricalData
 {
 protected:
 	std::vector<ServiceListener<ExecutionOrder<Bond>>*> listeners;
 	Connector<ExecutionOrder<Bond>>* bondExecutionHistoricalDataConnector;
-	std::unordered_map<string, ExecutionOrder<Bond>> orderMap; // key on product indentifier
+	ProductHandleMap<ExecutionOrder<Bond>> orderMap; // key on product handle
 
 public:
-	BondExecutionHistoricalDataService(Connector<ExecutionOrder<Bond>>* _bondExecutionHistoricalDataConnector); // ctor
+	BondExecutionHistoricalDataService(Connector<ExecutionOrder<Bond>>* _bondExecutionHistoricalDataConnector,
+		BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual ExecutionOrder<Bond> & GetData(string key);
+	virtual ExecutionOrder<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(ExecutionOrder<Bond> &data);
@@ -47,17 +52,30 @@ public:
 	// Get all listeners on the Service.
 	virtual const vector< ServiceListener<ExecutionOrder<Bond>>* >& GetListeners() const;
 
-	// Persist data to a store
+	// Persist data to a store (keyed on the product of the data, persistKey is not used)
 	virtual void PersistData(string persistKey, const ExecutionOrder<Bond>& data);
+
+	// Find the execution orders of a bond persisted to the journal with a time stamp in [from, to] (see ToJournalTimestamp)
+	// (flushes the journal)
+	std::vector<JournalEntry<ExecutionOrderRecord>> QueryExecutionOrders(const Bond &product, std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
 };
 
 // corresponding publish connector
 class BondExecutionHistoricalDataConnector : public Connector<ExecutionOrder<Bond>>
 {
 protected:
-	fstream file;
+	GroupCommitWriter writer; // the output file, written on its own thread
+	TimestampFormatter timestampFormatter; // the time stamp of the output
+	JournalWriter* journal; // the binary journal the records go to instead of the file, if any
 public:
-	BondExecutionHistoricalDataConnector(string _path); // ctor
+	BondExecutionHistoricalDataConnector(string _path, size_t _syncEveryRecords = 0, long _syncEveryMillis = 0); // ctor
+
+	// Get the group commit writer of the output file
+	GroupCommitWriter& GetWriter();
+
+	// Append the records to a binary journal instead of the file (nullptr to go back to the file)
+	void SetJournal(JournalWriter* _journal);
 
 	// Publish data to the Connector
 	virtual void Publish(ExecutionOrder <Bond> &data);
@@ -84,12 +102,13 @@ public:
 };
 
 BondExecutionHistoricalDataService::BondExecutionHistoricalDataService(
-	Connector<ExecutionOrder<Bond>>* _bondExecutionHistoricalDataConnector) :
+	Connector<ExecutionOrder<Bond>>* _bondExecutionHistoricalDataConnector, BondProductService* _bondProductService) :
 	bondExecutionHistoricalDataConnector(_bondExecutionHistoricalDataConnector)
 {
+	orderMap.Bind(_bondProductService);
 }
 
-ExecutionOrder<Bond> & BondExecutionHistoricalDataService::GetData(string key)
+ExecutionOrder<Bond> & BondExecutionHistoricalDataService::GetData(const string &key)
 {
 	return orderMap[key];
 }
@@ -108,13 +127,15 @@ const vector< ServiceListener<ExecutionOrder<Bond>>* >& BondExecutionHistoricalD
 	return listeners;
 }
 
+std::vector<JournalEntry<ExecutionOrderRecord>> BondExecutionHistoricalDataService::QueryExecutionOrders(const Bond &product, std::int64_t from, std::int64_t to)
+{
+	return Query<ExecutionOrderRecord>(EXECUTION_ORDER_RECORD, product.GetHandle(), product.GetProductId(), from, to);
+}
+
 void BondExecutionHistoricalDataService::PersistData(string persistKey, const ExecutionOrder<Bond>& data)
 {
 	// push data into the map
-	if (orderMap.find(persistKey) == orderMap.end()) // if not found this one then create one
-		orderMap.insert(std::make_pair(persistKey, data));
-	else
-		orderMap[persistKey] = data;
+	orderMap[data.GetProduct()] = data;
 
 	// publish the data
 	ExecutionOrder<Bond> temp(data);
@@ -122,25 +143,41 @@ void BondExecutionHistoricalDataService::PersistData(string persistKey, const Ex
 
 }
 
-BondExecutionHistoricalDataConnector::BondExecutionHistoricalDataConnector(string _path):
-	file(_path, std::ios::out | std::ios::trunc)
+BondExecutionHistoricalDataConnector::BondExecutionHistoricalDataConnector(string _path,
+	size_t _syncEveryRecords, long _syncEveryMillis) :
+	writer(_path, "Time,OrderType,OrderID,BondIDType,BondID,Side,VisibleQuantity,HiddenQuantity,"
+		"Price,IsChildOrder,ParentOrderId\n",
+		_syncEveryRecords, _syncEveryMillis), journal(nullptr)
+{ // the output file (and its header) is written at the first text record only
+}
+
+GroupCommitWriter& BondExecutionHistoricalDataConnector::GetWriter()
+{
+	return writer;
+}
+
+void BondExecutionHistoricalDataConnector::SetJournal(JournalWriter* _journal)
 {
-	// set the header of the output file
-	file << "Time,OrderType,OrderID,BondIDType,BondID,Side,VisibleQuantity,HiddenQuantity,"
-		<< "Price,IsChildOrder,ParentOrderId\n";
+	journal = _journal;
 }
 
 void BondExecutionHistoricalDataConnector::Publish(ExecutionOrder <Bond> &data)
 {
+	if (journal != nullptr) // binary journal: no text on the hot path
+	{
+		ExecutionOrderRecord record;
+		MakeJournalRecord(data, record);
+		journal->Append(EXECUTION_ORDER_RECORD, record, GetJournalTimestamp(), data.GetProduct().GetHandle());
+		return;
+	}
+
 	std::stringstream ss;
 
-	if (file.is_open())
+	if (writer.Open())
 	{
 		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		char timestamp[TIMESTAMP_LENGTH + 1]; // current time
+		timestampFormatter.Format(timestamp);
 		OrderType type = data.GetOrderType(); // get the state
 		std::string typeStr; 
 		if (type == FOK) typeStr = "FOK";
@@ -151,15 +188,17 @@ void BondExecutionHistoricalDataConnector::Publish(ExecutionOrder <Bond> &data)
 		Bond bond = data.GetProduct(); // get the product
 		std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
 		std::string side = (data.GetSide() == BID) ? "BID" : "OFFER";
-		std::string priceStr = PricetoString(data.GetPrice()); // get price
+		char priceStr[32]; // get price
+		data.GetPrice().ToBuffer(priceStr);
 		std::string isChildOrder = (data.IsChildOrder() == true) ? "TRUE" : "FALSE";
 
 		// make the output
-		file << date << " " << timeofDay << "," << typeStr << "," << data.GetOrderId() << "," 
+		ss << timestamp << "," << typeStr << "," << data.GetOrderId() << "," 
 			<< Idtype << "," << bond.GetProductId() << ","
 			<< side << "," << std::to_string(data.GetVisibleQuantity()) << ","
 			<< std::to_string(data.GetHiddenQuantity()) << "," << priceStr << ","
 			<< isChildOrder << "," << data.GetParentOrderId() << "\n";
+		writer.Append(ss.str());
 	}
 	else
 	{
@@ -175,8 +214,7 @@ BondExecutionHistoricalDataListener::BondExecutionHistoricalDataListener(
 
 void BondExecutionHistoricalDataListener::ProcessAdd(ExecutionOrder<Bond> &data)
 {
-	string key = data.GetProduct().GetProductId();
-	bondExecutionHistoricalDataService->PersistData(key, data);
+	bondExecutionHistoricalDataService->PersistData(string(), data); // keyed on the product of the data
 }
 
 void BondExecutionHistoricalDataListener::ProcessRemove(ExecutionOrder<Bond> &data)
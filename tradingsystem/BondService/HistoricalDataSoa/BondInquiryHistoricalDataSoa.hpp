@@ -14,17 +14,19 @@
 #include "BondService/BondInquirySoa.hpp"
 #include "products.hpp"
 #include "utilityfunction.hpp"
+#include "TimestampFormatter.hpp"
+#include "GroupCommitWriter.hpp"
+#include "JournalQuery.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include "soa.hpp"
 #include <unordered_map>
-#include <fstream>
 #include <sstream>
 #include <iostream>
 
 
 // Bond historical data service for position data
-class BondInquiryHistoricalDataService : public HistoricalDataService<Inquiry<Bond>>
+class BondInquiryHistoricalDataService : public HistoricalDataService<Inquiry<Bond>>, public JournaledHistoricalData
 {
 protected:
 	std::vector<ServiceListener<Inquiry<Bond>>*> listeners;
@@ -35,7 +37,7 @@ public:
 	BondInquiryHistoricalDataService(Connector<Inquiry<Bond>>* _bondInquiryHistoricalDataConnector); // Ctor
 
 	// Get data on our service given a key
-	virtual Inquiry<Bond> & GetData(string key);
+	virtual Inquiry<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Inquiry<Bond> &data);
@@ -49,15 +51,28 @@ public:
 
 	// Persist data to a store
 	virtual void PersistData(string persistKey, const Inquiry<Bond>& data);
+
+	// Find the inquiries on a bond persisted to the journal with a time stamp in [from, to] (see ToJournalTimestamp)
+	// (flushes the journal)
+	std::vector<JournalEntry<InquiryRecord>> QueryInquiries(const Bond &product, std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
 };
 
 // corresponding publish connector
 class BondInquiryHistoricalDataConnector : public Connector<Inquiry<Bond>>
 {
 protected:
-	fstream file;
+	GroupCommitWriter writer; // the output file, written on its own thread
+	TimestampFormatter timestampFormatter; // the time stamp of the output
+	JournalWriter* journal; // the binary journal the records go to instead of the file, if any
 public:
-	BondInquiryHistoricalDataConnector(string _path); // ctor
+	BondInquiryHistoricalDataConnector(string _path, size_t _syncEveryRecords = 0, long _syncEveryMillis = 0); // ctor
+
+	// Get the group commit writer of the output file
+	GroupCommitWriter& GetWriter();
+
+	// Append the records to a binary journal instead of the file (nullptr to go back to the file)
+	void SetJournal(JournalWriter* _journal);
 
 	// Publish data to the Connector
 	virtual void Publish(Inquiry <Bond> &data);
@@ -90,7 +105,7 @@ BondInquiryHistoricalDataService::BondInquiryHistoricalDataService(Connector<Inq
 }
 
 
-Inquiry<Bond> & BondInquiryHistoricalDataService::GetData(string key)
+Inquiry<Bond> & BondInquiryHistoricalDataService::GetData(const string &key)
 {
 	return inquiryMap[key];
 }
@@ -109,6 +124,11 @@ const vector< ServiceListener<Inquiry<Bond>>* >& BondInquiryHistoricalDataServic
 	return listeners;
 }
 
+std::vector<JournalEntry<InquiryRecord>> BondInquiryHistoricalDataService::QueryInquiries(const Bond &product, std::int64_t from, std::int64_t to)
+{
+	return Query<InquiryRecord>(INQUIRY_RECORD, product.GetHandle(), product.GetProductId(), from, to);
+}
+
 void BondInquiryHistoricalDataService::PersistData(string persistKey, const Inquiry<Bond>& data)
 {
 	// push data into the map
@@ -123,28 +143,45 @@ void BondInquiryHistoricalDataService::PersistData(string persistKey, const Inqu
 
 }
 
-BondInquiryHistoricalDataConnector::BondInquiryHistoricalDataConnector(string _path) : 
-	file(_path, std::ios::out | std::ios::trunc)
+BondInquiryHistoricalDataConnector::BondInquiryHistoricalDataConnector(string _path,
+	size_t _syncEveryRecords, long _syncEveryMillis) :
+	writer(_path, "Time,InquiryID,BondIDType,BondID,Side,Quantity,Price,State\n",
+		_syncEveryRecords, _syncEveryMillis), journal(nullptr)
+{ // the output file (and its header) is written at the first text record only
+}
+
+GroupCommitWriter& BondInquiryHistoricalDataConnector::GetWriter()
+{
+	return writer;
+}
+
+void BondInquiryHistoricalDataConnector::SetJournal(JournalWriter* _journal)
 {
-	// set the header of the output file
-	file << "Time,InquiryID,BondIDType,BondID,Side,Quantity,Price,State\n";
+	journal = _journal;
 }
 
 void BondInquiryHistoricalDataConnector::Publish(Inquiry <Bond> &data)
 {
+	if (journal != nullptr) // binary journal: no text on the hot path
+	{
+		InquiryRecord record;
+		MakeJournalRecord(data, record);
+		journal->Append(INQUIRY_RECORD, record, GetJournalTimestamp(), data.GetProduct().GetHandle());
+		return;
+	}
+
 	std::stringstream ss;
 
-	if (file.is_open())
+	if (writer.Open())
 	{
 		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		char timestamp[TIMESTAMP_LENGTH + 1]; // current time
+		timestampFormatter.Format(timestamp);
 		Bond bond = data.GetProduct(); // get the product
 		std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
 		std::string side = (data.GetSide() == BUY) ? "BUY" : "SELL";
-		std::string priceStr = PricetoString(data.GetPrice()); // get price
+		char priceStr[32]; // get price
+		PricetoBuffer(data.GetPrice(), priceStr);
 		InquiryState state = data.GetState(); // get the state
 		std::string stateStr = "RECEIVED";
 		if (state == QUOTED) stateStr = "QUOTED";
@@ -153,9 +190,10 @@ void BondInquiryHistoricalDataConnector::Publish(Inquiry <Bond> &data)
 		else if (state == CUSTOMER_REJECTED) stateStr = "CUSTOMER_REJECTED";
 
 		// make the output
-		file << date << " " << timeofDay << "," << data.GetInquiryId() << "," << Idtype << "," 
+		ss << timestamp << "," << data.GetInquiryId() << "," << Idtype << "," 
 			<< bond.GetProductId() << "," << bond.GetTicker() << ","
 			<< std::to_string(data.GetQuantity()) << "," << priceStr << "," << stateStr << "\n";
+		writer.Append(ss.str());
 	}
 	else
 	{
@@ -14,28 +14,33 @@
 #include "BondService/BondPositionSoa.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include "utilityfunction.hpp"
+#include "TimestampFormatter.hpp"
+#include "GroupCommitWriter.hpp"
+#include "JournalQuery.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include <unordered_map>
 #include <sstream>
-#include <fstream>
 #include <iostream>
 
 
 // Bond historical data service for position data
-class BondPositionHistoricalDataService : public HistoricalDataService<Position<Bond>>
+class BondPositionHistoricalDataService : public HistoricalDataService<Position<Bond>>, public JournaledHistoricalData
 {
 protected:
 	std::vector<ServiceListener<Position<Bond>>*> listeners;
 	Connector<Position<Bond>>* bondPositionHistoricalDataConnector;
-	std::unordered_map<string, Position<Bond>> positionMap; // key on product indentifier
+	ProductHandleMap<Position<Bond>> positionMap; // key on product handle
 
 public:
-	BondPositionHistoricalDataService(Connector<Position<Bond>>* _bondPositionHistoricalDataConnector); // ctor
+	BondPositionHistoricalDataService(Connector<Position<Bond>>* _bondPositionHistoricalDataConnector,
+		BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual Position<Bond> & GetData(string key);
+	virtual Position<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Position<Bond> &data);
@@ -47,17 +52,30 @@ public:
 	// Get all listeners on the Service.
 	virtual const vector< ServiceListener<Position<Bond>>* >& GetListeners() const;
 
-	// Persist data to a store
+	// Persist data to a store (keyed on the product of the data, persistKey is not used)
 	virtual void PersistData(string persistKey, const Position<Bond>& data);
+
+	// Find the positions of a bond persisted to the journal with a time stamp in [from, to] (see ToJournalTimestamp)
+	// (flushes the journal)
+	std::vector<JournalEntry<PositionRecord>> QueryPositions(const Bond &product, std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
 };
 
 // corresponding publish connector
 class BondPositionHistoricalDataConnector : public Connector<Position<Bond>>
 {
 protected:
-	fstream file;
+	GroupCommitWriter writer; // the output file, written on its own thread
+	TimestampFormatter timestampFormatter; // the time stamp of the output
+	JournalWriter* journal; // the binary journal the records go to instead of the file, if any
 public:
-	BondPositionHistoricalDataConnector(string _path); // ctor
+	BondPositionHistoricalDataConnector(string _path, size_t _syncEveryRecords = 0, long _syncEveryMillis = 0); // ctor
+
+	// Get the group commit writer of the output file
+	GroupCommitWriter& GetWriter();
+
+	// Append the records to a binary journal instead of the file (nullptr to go back to the file)
+	void SetJournal(JournalWriter* _journal);
 
 	// Publish data to the Connector
 	virtual void Publish(Position <Bond> &data);
@@ -84,13 +102,14 @@ public:
 };
 
 BondPositionHistoricalDataService::BondPositionHistoricalDataService(Connector<Position<Bond>>*
-	_bondPositionHistoricalDataConnector) :
+	_bondPositionHistoricalDataConnector, BondProductService* _bondProductService) :
 	bondPositionHistoricalDataConnector(_bondPositionHistoricalDataConnector)
 {
+	positionMap.Bind(_bondProductService);
 }
 
 
-Position<Bond> & BondPositionHistoricalDataService::GetData(string key)
+Position<Bond> & BondPositionHistoricalDataService::GetData(const string &key)
 {
 	return positionMap[key];
 }
@@ -109,13 +128,15 @@ const vector< ServiceListener<Position<Bond>>* >& BondPositionHistoricalDataServ
 	return listeners;
 }
 
+std::vector<JournalEntry<PositionRecord>> BondPositionHistoricalDataService::QueryPositions(const Bond &product, std::int64_t from, std::int64_t to)
+{
+	return Query<PositionRecord>(POSITION_RECORD, product.GetHandle(), product.GetProductId(), from, to);
+}
+
 void BondPositionHistoricalDataService::PersistData(string persistKey, const Position<Bond>& data)
 {
 	// push data into the map
-	if (positionMap.find(persistKey) == positionMap.end()) // if not found this one then create one
-		positionMap.insert(std::make_pair(persistKey, data));
-	else
-		positionMap[persistKey] = data;
+	positionMap[data.GetProduct()] = data;
 
 	// publish the data
 	Position<Bond> temp(data);
@@ -123,15 +144,33 @@ void BondPositionHistoricalDataService::PersistData(string persistKey, const Pos
 
 }
 
-BondPositionHistoricalDataConnector::BondPositionHistoricalDataConnector(string _path) : 
-	file(_path, std::ios::out | std::ios::trunc)
+BondPositionHistoricalDataConnector::BondPositionHistoricalDataConnector(string _path,
+	size_t _syncEveryRecords, long _syncEveryMillis) :
+	writer(_path, "Time,BondIDType,BondID,BookId,Positions\n",
+		_syncEveryRecords, _syncEveryMillis), journal(nullptr)
+{ // the output file (and its header) is written at the first text record only
+}
+
+GroupCommitWriter& BondPositionHistoricalDataConnector::GetWriter()
+{
+	return writer;
+}
+
+void BondPositionHistoricalDataConnector::SetJournal(JournalWriter* _journal)
 {
-	// set the header of the output file
-	file << "Time,BondIDType,BondID,BookId,Positions\n";
+	journal = _journal;
 }
 
 void BondPositionHistoricalDataConnector::Publish(Position <Bond> &data)
 {
+	if (journal != nullptr) // binary journal: no text on the hot path
+	{
+		PositionRecord record;
+		MakeJournalRecord(data, record);
+		journal->Append(POSITION_RECORD, record, GetJournalTimestamp(), data.GetProduct().GetHandle());
+		return;
+	}
+
 	std::stringstream ss;
 	// hard-coded the book id
 	std::string book1 = "TRSY1";
@@ -139,24 +178,23 @@ void BondPositionHistoricalDataConnector::Publish(Position <Bond> &data)
 	std::string book3 = "TRSY3";
 
 
-	if (file.is_open())
+	if (writer.Open())
 	{
 		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		char timestamp[TIMESTAMP_LENGTH + 1]; // current time
+		timestampFormatter.Format(timestamp);
 		Bond bond = data.GetProduct(); // get the product
 		std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
-		// make the output
-		file << date << " " << timeofDay << "," << Idtype << "," << bond.GetProductId() << ","
+		// make the output (the four lines of a position as one record)
+		ss << timestamp << "," << Idtype << "," << bond.GetProductId() << ","
 			<< book1 << "," << std::to_string(data.GetPosition(book1)) << "\n";
-		file << date << " " << timeofDay << "," << Idtype << "," << bond.GetProductId() << ","
+		ss << timestamp << "," << Idtype << "," << bond.GetProductId() << ","
 			<< book2 << "," << std::to_string(data.GetPosition(book2)) << "\n";
-		file << date << " " << timeofDay << "," << Idtype << "," << bond.GetProductId() << ","
+		ss << timestamp << "," << Idtype << "," << bond.GetProductId() << ","
 			<< book3 << "," << std::to_string(data.GetPosition(book3)) << "\n";
-		file << date << " " << timeofDay << "," << Idtype << "," << bond.GetProductId() << ","
+		ss << timestamp << "," << Idtype << "," << bond.GetProductId() << ","
 			<< "AGGREGATED" << "," << std::to_string(data.GetAggregatePosition()) << "\n";
+		writer.Append(ss.str());
 	}
 	else
 	{
@@ -179,8 +217,7 @@ void BondPositionHistoricalDataListener::ProcessRemove(Position<Bond> &data)
 
 void BondPositionHistoricalDataListener::ProcessUpdate(Position<Bond> &data)
 {
-	string key = data.GetProduct().GetProductId();
-	bondPositionHistoricalDataService->PersistData(key, data);
+	bondPositionHistoricalDataService->PersistData(string(), data); // keyed on the product of the data
 }
 
 #endif // !BondPositionHistoricalDataSoa_hpp
@@ -14,30 +14,35 @@
 #include "BondService/BondRiskSoa.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include "utilityfunction.hpp"
+#include "TimestampFormatter.hpp"
+#include "GroupCommitWriter.hpp"
+#include "JournalQuery.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include <unordered_map>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 
 class BondRiskHistoricalDataConnector;// : public Connector<PV01<Bond>>;
 
 // Bond historical data service for position data
-class BondRiskHistoricalDataService : public HistoricalDataService<PV01<Bond>>
+class BondRiskHistoricalDataService : public HistoricalDataService<PV01<Bond>>, public JournaledHistoricalData
 {
 protected:
 	std::vector<ServiceListener<PV01<Bond>>*> listeners;
 	BondRiskHistoricalDataConnector* bondRiskHistoricalDataConnector;
-	std::unordered_map<string, PV01<Bond>> pv01Map; // key on product indentifier
+	ProductHandleMap<PV01<Bond>> pv01Map; // key on product handle
 	std::unordered_map<string, PV01<BucketedSector<Bond>>> bucketpv01Map; // key on sector name
 
 public:
-	BondRiskHistoricalDataService(BondRiskHistoricalDataConnector* _bondRiskHistoricalDataConnector); // ctor
+	BondRiskHistoricalDataService(BondRiskHistoricalDataConnector* _bondRiskHistoricalDataConnector,
+		BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key : for a single bond
-	virtual PV01<Bond> & GetData(string key);
+	virtual PV01<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(PV01<Bond> &data);
@@ -49,21 +54,39 @@ public:
 	// Get all listeners on the Service.
 	virtual const vector< ServiceListener<PV01<Bond>>* >& GetListeners() const;
 
-	// Persist data to a store: for a sigle bond
+	// Persist data to a store: for a sigle bond (keyed on the bond, persistKey is not used)
 	virtual void PersistData(string persistKey, const PV01<Bond>& data);
 
 	// Persist data to a store: for bucket sector
 	virtual void PersistData(string persistKey, const PV01<BucketedSector<Bond>>& data);
+
+	// Find the PV01s of a bond persisted to the journal with a time stamp in [from, to] (see ToJournalTimestamp)
+	// (flushes the journal)
+	std::vector<JournalEntry<PV01Record>> QueryRisk(const Bond &product, std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
+
+	// Find the PV01s of a bucketed sector persisted to the journal with a time stamp in [from, to] (see ToJournalTimestamp)
+	// (flushes the journal)
+	std::vector<JournalEntry<PV01Record>> QueryBucketedRisk(const string &sectorName, std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
 };
 
 // corresponding publish connector
 class BondRiskHistoricalDataConnector : public Connector<PV01<Bond>>
 {
 protected:
-	fstream file;
+	GroupCommitWriter writer; // the output file, written on its own thread
+	TimestampFormatter timestampFormatter; // the time stamp of the output
+	JournalWriter* journal; // the binary journal the records go to instead of the file, if any
 
 public:
-	BondRiskHistoricalDataConnector(string _path); // ctor
+	BondRiskHistoricalDataConnector(string _path, size_t _syncEveryRecords = 0, long _syncEveryMillis = 0); // ctor
+
+	// Get the group commit writer of the output file
+	GroupCommitWriter& GetWriter();
+
+	// Append the records to a binary journal instead of the file (nullptr to go back to the file)
+	void SetJournal(JournalWriter* _journal);
 
 	// Publish data to the Connector: for single bond
 	virtual void Publish(PV01 <Bond> &data);
@@ -98,11 +121,13 @@ public:
 };
 
 BondRiskHistoricalDataService::BondRiskHistoricalDataService(BondRiskHistoricalDataConnector*
-	_bondRiskHistoricalDataConnector) : bondRiskHistoricalDataConnector(_bondRiskHistoricalDataConnector)
+	_bondRiskHistoricalDataConnector, BondProductService* _bondProductService) :
+	bondRiskHistoricalDataConnector(_bondRiskHistoricalDataConnector)
 {
+	pv01Map.Bind(_bondProductService);
 }
 
-PV01<Bond> & BondRiskHistoricalDataService::GetData(string key)
+PV01<Bond> & BondRiskHistoricalDataService::GetData(const string &key)
 {
 	return pv01Map[key];
 }
@@ -121,13 +146,20 @@ const vector< ServiceListener<PV01<Bond>>* >& BondRiskHistoricalDataService::Get
 	return listeners;
 }
 
+std::vector<JournalEntry<PV01Record>> BondRiskHistoricalDataService::QueryRisk(const Bond &product, std::int64_t from, std::int64_t to)
+{
+	return Query<PV01Record>(PV01_RECORD, product.GetHandle(), product.GetProductId(), from, to);
+}
+
+std::vector<JournalEntry<PV01Record>> BondRiskHistoricalDataService::QueryBucketedRisk(const string &sectorName, std::int64_t from, std::int64_t to)
+{
+	return Query<PV01Record>(BUCKETED_PV01_RECORD, NO_PRODUCT_HANDLE, sectorName, from, to);
+}
+
 void BondRiskHistoricalDataService::PersistData(string persistKey, const PV01<Bond>& data)
 {
 	// push data into the map
-	if (pv01Map.find(persistKey) == pv01Map.end()) // if not found this one then create one
-		pv01Map.insert(std::make_pair(persistKey, data));
-	else
-		pv01Map[persistKey] = data;
+	pv01Map[data.GetProduct()] = data;
 
 	// publish the data
 	PV01<Bond> temp(data);
@@ -148,29 +180,46 @@ void BondRiskHistoricalDataService::PersistData(string persistKey, const PV01<Bu
 	bondRiskHistoricalDataConnector->Publish(temp);
 }
 
-BondRiskHistoricalDataConnector::BondRiskHistoricalDataConnector(string _path) :
-	file(_path, std::ios::out | std::ios::trunc)
+BondRiskHistoricalDataConnector::BondRiskHistoricalDataConnector(string _path,
+	size_t _syncEveryRecords, long _syncEveryMillis) :
+	writer(_path, "Time,ProductIDType,ProductID,PV01,Quantity\n",
+		_syncEveryRecords, _syncEveryMillis), journal(nullptr)
+{ // the output file (and its header) is written at the first text record only
+}
+
+GroupCommitWriter& BondRiskHistoricalDataConnector::GetWriter()
 {
-	// set the header of the output file
-	file << "Time,ProductIDType,ProductID,PV01,Quantity\n";
+	return writer;
+}
+
+void BondRiskHistoricalDataConnector::SetJournal(JournalWriter* _journal)
+{
+	journal = _journal;
 }
 
 void BondRiskHistoricalDataConnector::Publish(PV01 <Bond> &data)
 {
+	if (journal != nullptr) // binary journal: no text on the hot path
+	{
+		PV01Record record;
+		MakeJournalRecord(data, record);
+		journal->Append(PV01_RECORD, record, GetJournalTimestamp(), data.GetProduct().GetHandle());
+		return;
+	}
+
 	std::stringstream ss;
-	if (file.is_open())
+	if (writer.Open())
 	{
 		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		char timestamp[TIMESTAMP_LENGTH + 1]; // current time
+		timestampFormatter.Format(timestamp);
 		Bond bond = data.GetProduct(); // get the product
 		std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
 
 		// make the output
-		file << date << " " << timeofDay << "," << Idtype << "," << bond.GetProductId() << ","
+		ss << timestamp << "," << Idtype << "," << bond.GetProductId() << ","
 			<< std::to_string(data.GetPV01()) << "," << std::to_string(data.GetQuantity()) << "\n";
+		writer.Append(ss.str());
 	}
 	else
 	{
@@ -180,18 +229,26 @@ void BondRiskHistoricalDataConnector::Publish(PV01 <Bond> &data)
 
 void BondRiskHistoricalDataConnector::Publish(PV01 <BucketedSector<Bond>> &data)
 {
-	if (file.is_open())
+	if (journal != nullptr) // binary journal: no text on the hot path
+	{
+		PV01Record record;
+		MakeJournalRecord(data, record);
+		journal->Append(BUCKETED_PV01_RECORD, record, GetJournalTimestamp());
+		return;
+	}
+
+	std::stringstream ss;
+	if (writer.Open())
 	{
 		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
+		char timestamp[TIMESTAMP_LENGTH + 1]; // current time
+		timestampFormatter.Format(timestamp);
 		std::string Idtype = "Bucketed Sector"; // special id type
 
 		// make the output
-		file << date << " " << timeofDay << "," << Idtype << "," << data.GetProduct().GetName() << ","
+		ss << timestamp << "," << Idtype << "," << data.GetProduct().GetName() << ","
 			<< std::to_string(data.GetPV01()) << "," << std::to_string(data.GetQuantity()) << "\n";
+		writer.Append(ss.str());
 	}
 	else
 	{
@@ -209,7 +266,13 @@ BondRiskHistoricalDataListener::BondRiskHistoricalDataListener(BondProductServic
 	{
 		std::vector<Bond> bonds;
 		for (auto iter2 = iter->second.begin(); iter2 != iter->second.end(); iter2++)
-			bonds.push_back(bondProductService->GetData(*iter2));
+		{
+			const Bond* bond = bondProductService->GetTable().Find(*iter2);
+			if (bond == nullptr)
+				std::cout << "Oh no! No bond " << *iter2 << " in the bucketed sector " << iter->first << "!\n";
+			else
+				bonds.push_back(*bond);
+		}
 		buckets.push_back(BucketedSector<Bond>(bonds, iter->first));
 	}
 }
@@ -225,8 +288,7 @@ void BondRiskHistoricalDataListener::ProcessRemove(PV01<Bond> &data)
 void BondRiskHistoricalDataListener::ProcessUpdate(PV01<Bond> &data)
 { 
 	// persist data for the single product
-	string key = data.GetProduct().GetProductId();
-	bondRiskHistoricalDataService->PersistData(key, data);
+	bondRiskHistoricalDataService->PersistData(string(), data); // keyed on the product of the data
 
 	// find the bucketed sector the product is in
 	std::vector<Bond> products;
@@ -239,7 +301,7 @@ void BondRiskHistoricalDataListener::ProcessUpdate(PV01<Bond> &data)
 		products = buckets[i].GetProducts();
 		for (auto iter2 = products.begin(); iter2 != products.end(); iter2++)
 		{
-			if (iter2->GetProductId() == key) // if found
+			if (iter2->GetProductId() == data.GetProduct().GetProductId()) // if found
 			{
 				index = i;
 				status = true;
@@ -14,28 +14,33 @@
 #include "BondService/BondStreamingSoa.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "ProductHandleMap.hpp"
+#include "productservice.hpp"
 #include "utilityfunction.hpp"
+#include "TimestampFormatter.hpp"
+#include "GroupCommitWriter.hpp"
+#include "JournalQuery.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include <unordered_map>
 #include <sstream>
-#include <fstream>
 #include <iostream>
 
 
 // Bond historical data service for position data
-class BondStreamingHistoricalDataService : public HistoricalDataService<PriceStream<Bond>>
+class BondStreamingHistoricalDataService : public HistoricalDataService<PriceStream<Bond>>, public JournaledHistoricalData
 {
 protected:
 	std::vector<ServiceListener<PriceStream<Bond>>*> listeners;
 	Connector<PriceStream<Bond>>* bondStreamingHistoricalDataConnector;
-	std::unordered_map<string, PriceStream<Bond>> streamMap; // key on product indentifier
+	ProductHandleMap<PriceStream<Bond>> streamMap; // key on product handle
 
 public:
-	BondStreamingHistoricalDataService(Connector<PriceStream<Bond>>* _bondStreamingHistoricalDataConnector); // ctor
+	BondStreamingHistoricalDataService(Connector<PriceStream<Bond>>* _bondStreamingHistoricalDataConnector,
+		BondProductService* _bondProductService = nullptr); // ctor, a slot for each product of the product service (if any)
 
 	// Get data on our service given a key
-	virtual PriceStream<Bond> & GetData(string key);
+	virtual PriceStream<Bond> & GetData(const string &key);
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(PriceStream<Bond> &data);
@@ -47,21 +52,45 @@ public:
 	// Get all listeners on the Service.
 	virtual const vector< ServiceListener<PriceStream<Bond>>* >& GetListeners() const;
 
-	// Persist data to a store
+	// Persist data to a store (keyed on the product of the data, persistKey is not used)
 	virtual void PersistData(string persistKey, const PriceStream<Bond>& data);
+
+	// Persist a batch of data to a store (keyed on the product identifier)
+	virtual void PersistDataBatch(PriceStream<Bond>* data, size_t size);
+
+	// Find the price streams of a bond persisted to the journal with a time stamp in [from, to] (see ToJournalTimestamp)
+	// (flushes the journal)
+	std::vector<JournalEntry<PriceStreamRecord>> QueryPriceStreams(const Bond &product, std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
 };
 
 // corresponding publish connector
 class BondStreamingHistoricalDataConnector : public Connector<PriceStream<Bond>>
 {
 protected:
-	fstream file;
+	GroupCommitWriter writer; // the output file, written on its own thread
+	TimestampFormatter timestampFormatter; // the time stamp of the output
+	JournalWriter* journal; // the binary journal the records go to instead of the file, if any
+	std::string buffer; // re-used output buffer
+
+	// Append one line of output to the buffer
+	void AppendRecord(const char *timestamp, const PriceStream<Bond> &data);
+
 public:
-	BondStreamingHistoricalDataConnector(string path); // ctor
+	BondStreamingHistoricalDataConnector(string _path, size_t _syncEveryRecords = 0, long _syncEveryMillis = 0); // ctor
+
+	// Get the group commit writer of the output file
+	GroupCommitWriter& GetWriter();
+
+	// Append the records to a binary journal instead of the file (nullptr to go back to the file)
+	void SetJournal(JournalWriter* _journal);
 
 	// Publish data to the Connector
 	virtual void Publish(PriceStream <Bond> &data);
 
+	// Publish a batch of data to the Connector (one record per price stream, written together by the writer)
+	virtual void PublishBatch(PriceStream <Bond> *data, size_t size);
+
 };
 
 // corresponding service listener
@@ -81,15 +110,38 @@ public:
 
 	// Listener callback to process an update event to the Service
 	virtual void ProcessUpdate(PriceStream<Bond> &data);
+
+	// Listener callback to process a batch of add events to the Service
+	virtual void ProcessAddBatch(PriceStream<Bond> *data, size_t size);
+};
+
+// Bond streaming historical data stage of a static pipeline (see StaticPipeline.hpp)
+// takes the price streams in place of the bond streaming historical data listener
+class BondStreamingHistoricalDataStage
+{
+protected:
+	BondStreamingHistoricalDataService* bondStreamingHistoricalDataService;
+
+public:
+	BondStreamingHistoricalDataStage(BondStreamingHistoricalDataService* _bondStreamingHistoricalDataService); // ctor
+
+	// Persist the price stream and hand it to the next stage
+	template <typename Next>
+	void Process(PriceStream<Bond> &data, Next &next);
+
+	// Persist a batch of price streams and hand them to the next stage
+	template <typename Next>
+	void ProcessBatch(PriceStream<Bond> *data, size_t size, Next &next);
 };
 
 BondStreamingHistoricalDataService::BondStreamingHistoricalDataService(
-	Connector<PriceStream<Bond>>* _bondStreamingHistoricalDataConnector) :
+	Connector<PriceStream<Bond>>* _bondStreamingHistoricalDataConnector, BondProductService* _bondProductService) :
 	bondStreamingHistoricalDataConnector(_bondStreamingHistoricalDataConnector)
 {
+	streamMap.Bind(_bondProductService);
 }
 
-PriceStream<Bond> & BondStreamingHistoricalDataService::GetData(string key)
+PriceStream<Bond> & BondStreamingHistoricalDataService::GetData(const string &key)
 {
 	return streamMap[key];
 }
@@ -108,13 +160,15 @@ const vector< ServiceListener<PriceStream<Bond>>* >& BondStreamingHistoricalData
 	return listeners;
 }
 
+std::vector<JournalEntry<PriceStreamRecord>> BondStreamingHistoricalDataService::QueryPriceStreams(const Bond &product, std::int64_t from, std::int64_t to)
+{
+	return Query<PriceStreamRecord>(PRICE_STREAM_RECORD, product.GetHandle(), product.GetProductId(), from, to);
+}
+
 void BondStreamingHistoricalDataService::PersistData(string persistKey, const PriceStream<Bond>& data)
 {
 	// push data into the map
-	if (streamMap.find(persistKey) == streamMap.end()) // if not found this one then create one
-		streamMap.insert(std::make_pair(persistKey, data));
-	else
-		streamMap[persistKey] = data;
+	streamMap[data.GetProduct()] = data;
 
 	// publish the data
 	PriceStream<Bond> temp(data);
@@ -122,36 +176,80 @@ void BondStreamingHistoricalDataService::PersistData(string persistKey, const Pr
 
 }
 
-BondStreamingHistoricalDataConnector::BondStreamingHistoricalDataConnector(string _path): 
-	file(_path, std::ios::out | std::ios::trunc)
+void BondStreamingHistoricalDataService::PersistDataBatch(PriceStream<Bond>* data, size_t size)
+{
+	// push data into the map
+	for (size_t i = 0; i < size; i++)
+		streamMap[data[i].GetProduct()] = data[i];
+
+	// publish the whole batch
+	bondStreamingHistoricalDataConnector->PublishBatch(data, size);
+}
+
+BondStreamingHistoricalDataConnector::BondStreamingHistoricalDataConnector(string _path,
+	size_t _syncEveryRecords, long _syncEveryMillis) :
+	writer(_path, "Time,BondIDType,BondID,BidPrice,BidVisibleQuantity,BidHiddenQuantity,"
+		"OfferPrice,OfferVisibleQuantity,OfferHiddenQuantity\n",
+		_syncEveryRecords, _syncEveryMillis), journal(nullptr)
+{ // the output file (and its header) is written at the first text record only
+}
+
+GroupCommitWriter& BondStreamingHistoricalDataConnector::GetWriter()
 {
-	// set the header of the output file
-	file << "Time,BondIDType,BondID,BidPrice,BidVisibleQuantity,BidHiddenQuantity," 
-		<< "OfferPrice,OfferVisibleQuantity,OfferHiddenQuantity\n";
+	return writer;
+}
+
+void BondStreamingHistoricalDataConnector::SetJournal(JournalWriter* _journal)
+{
+	journal = _journal;
+}
+
+void BondStreamingHistoricalDataConnector::AppendRecord(const char *timestamp, const PriceStream<Bond> &data)
+{
+	// make the ingredent of the outout
+	const Bond &bond = data.GetProduct(); // get the product
+	std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
+	// make the output
+	buffer.append(timestamp, TIMESTAMP_LENGTH);
+	buffer += "," + Idtype + "," + bond.GetProductId() + ","
+		+ std::to_string(data.GetBidOrder().GetPrice().ToDouble()) + ","
+		+ std::to_string(data.GetBidOrder().GetVisibleQuantity()) + ","
+		+ std::to_string(data.GetBidOrder().GetHiddenQuantity()) + ","
+		+ std::to_string(data.GetOfferOrder().GetPrice().ToDouble()) + ","
+		+ std::to_string(data.GetBidOrder().GetVisibleQuantity()) + ","
+		+ std::to_string(data.GetBidOrder().GetHiddenQuantity()) + "\n";
 }
 
 void BondStreamingHistoricalDataConnector::Publish(PriceStream <Bond> &data)
 {
-	std::stringstream ss;
+	PublishBatch(&data, 1);
+}
 
-	if (file.is_open())
+void BondStreamingHistoricalDataConnector::PublishBatch(PriceStream <Bond> *data, size_t size)
+{
+	if (journal != nullptr) // binary journal: no text on the hot path
 	{
-		// make the ingredent of the outout
-		auto time = boost::posix_time::microsec_clock::local_time(); // current time
-		std::string date = DatetoUsString(time.date());
-		std::string timeofDay = boost::posix_time::to_simple_string(time.time_of_day());
-		timeofDay.erase(timeofDay.end() - 3, timeofDay.end());
-		Bond bond = data.GetProduct(); // get the product
-		std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN"; // get the bond id type
-		// make the output
-		file << date << " " << timeofDay << "," << Idtype << "," << bond.GetProductId() << "," 
-			<< std::to_string(data.GetBidOrder().GetPrice()) << ","
-			<< std::to_string(data.GetBidOrder().GetVisibleQuantity()) << "," 
-			<< std::to_string(data.GetBidOrder().GetHiddenQuantity()) << ","
-			<< std::to_string(data.GetOfferOrder().GetPrice()) << "," 
-			<< std::to_string(data.GetBidOrder().GetVisibleQuantity()) << ","
-			<< std::to_string(data.GetBidOrder().GetHiddenQuantity()) << "\n";
+		std::int64_t timestamp = GetJournalTimestamp();
+		PriceStreamRecord record;
+		for (size_t i = 0; i < size; i++)
+		{
+			MakeJournalRecord(data[i], record);
+			journal->Append(PRICE_STREAM_RECORD, record, timestamp, data[i].GetProduct().GetHandle());
+		}
+		return;
+	}
 
+	if (writer.Open())
+	{
+		// the whole batch is published at the same time
+		char timestamp[TIMESTAMP_LENGTH + 1];
+		timestampFormatter.Format(timestamp);
+		for (size_t i = 0; i < size; i++)
+		{
+			buffer.clear();
+			AppendRecord(timestamp, data[i]);
+			writer.Append(buffer);
+		}
 	}
 	else
 	{
@@ -167,8 +265,7 @@ BondStreamingHistoricalDataListener::BondStreamingHistoricalDataListener(
 
 void BondStreamingHistoricalDataListener::ProcessAdd(PriceStream<Bond> &data)
 {
-	string key = data.GetProduct().GetProductId();
-	bondStreamingHistoricalDataService->PersistData(key, data);
+	bondStreamingHistoricalDataService->PersistData(string(), data); // keyed on the product of the data
 }
 
 void BondStreamingHistoricalDataListener::ProcessRemove(PriceStream<Bond> &data)
@@ -179,4 +276,30 @@ void BondStreamingHistoricalDataListener::ProcessUpdate(PriceStream<Bond> &data)
 { // not defined for this service
 }
 
+void BondStreamingHistoricalDataListener::ProcessAddBatch(PriceStream<Bond> *data, size_t size)
+{
+	bondStreamingHistoricalDataService->PersistDataBatch(data, size);
+}
+
+BondStreamingHistoricalDataStage::BondStreamingHistoricalDataStage(
+	BondStreamingHistoricalDataService* _bondStreamingHistoricalDataService) :
+	bondStreamingHistoricalDataService(_bondStreamingHistoricalDataService)
+{
+}
+
+template <typename Next>
+void BondStreamingHistoricalDataStage::Process(PriceStream<Bond> &data, Next &next)
+{
+	// qualified call: the concrete service is known, so no virtual dispatch
+	bondStreamingHistoricalDataService->BondStreamingHistoricalDataService::PersistData(string(), data); // keyed on the product of the data
+	next.Push(data);
+}
+
+template <typename Next>
+void BondStreamingHistoricalDataStage::ProcessBatch(PriceStream<Bond> *data, size_t size, Next &next)
+{
+	bondStreamingHistoricalDataService->BondStreamingHistoricalDataService::PersistDataBatch(data, size);
+	next.PushBatch(data, size);
+}
+
 #endif // !BondStreamingHistoricalDataSoa_hpp
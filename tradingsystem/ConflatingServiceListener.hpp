@@ -0,0 +1,270 @@
+// ConflatingServiceListener.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the conflated dispatch mode of a service listener for slow consumers:
+// only the newest pending event of each product is kept (the older ones are dropped and counted),
+// and the wrapped listener runs on its own worker thread, taking the products in the order they became pending
+
+#ifndef ConflatingServiceListener_hpp
+#define ConflatingServiceListener_hpp
+
+#include "soa.hpp"
+#include "products.hpp"
+#include "AsyncServiceListener.hpp"
+#include "OrderBookUpdate.hpp"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+
+// Conflate a newer event of a product into its pending one (the newest value wins)
+template <typename V>
+void ConflateEvent(V &pending, V &newer)
+{
+	pending = newer;
+}
+
+// Conflate a newer order book delta into the pending one: the newest top of the book wins,
+// and the top of the book has moved if it moved in either (the levels of the pending delta are dropped)
+template <typename T>
+void ConflateEvent(OrderBookDelta<T> &pending, OrderBookDelta<T> &newer)
+{
+	bool topOfBookChanged = pending.IsTopOfBookChanged() || newer.IsTopOfBookChanged();
+	pending = newer;
+	pending.SetTopOfBookChanged(topOfBookChanged);
+}
+
+// Conflating service listener
+// registered on the upstream service in place of the wrapped listener;
+// a burst of events on a few products occupies one slot each, so it cannot starve the other products,
+// and the worker hands the pending add/update events over as one batch
+// Type V is the data type of the service (with a GetProduct() function)
+template <typename V>
+class ConflatingServiceListener : public ServiceListener<V>
+{
+protected:
+	// the pending event of a product
+	struct Slot
+	{
+		V data;
+		ServiceEventType type;
+		bool pending = false;
+	};
+
+	ServiceListener<V>* listener; // the wrapped listener, called on the worker thread
+	std::deque<Slot> slots; // slot i for the product with handle i (grown at the back, so the slots do not move)
+	std::unordered_map<std::string, Slot> unregistered; // the slots of the products without a handle, key on product id
+	std::deque<Slot*> ready; // the slots with a pending event, in the order they became pending
+	std::mutex mutex; // guards the slots and the ready queue
+	std::condition_variable condition;
+	bool running;
+	std::atomic<long> enqueued; // # of events kept (a new pending product)
+	std::atomic<long> dropped; // # of events conflated into a pending one
+	std::atomic<long> processed; // # of events handed over to the wrapped listener
+	std::size_t maxBatch; // maximum # of events handed over at once
+	std::thread worker;
+
+	// Keep an event as the pending one of its product
+	void Enqueue(ServiceEventType type, V &data);
+
+	// Hand a batch of events of the same type over to the wrapped listener
+	void Dispatch(ServiceEventType type, std::vector<V> &batch);
+
+	// Worker thread loop
+	void Run();
+
+public:
+	ConflatingServiceListener(ServiceListener<V>* _listener, std::size_t _maxBatch = 1024); // ctor
+	~ConflatingServiceListener(); // dtor, drains the pending events and joins the worker
+
+	// Listener callback to process an add event to the Service
+	virtual void ProcessAdd(V &data);
+
+	// Listener callback to process a remove event to the Service
+	virtual void ProcessRemove(V &data);
+
+	// Listener callback to process an update event to the Service
+	virtual void ProcessUpdate(V &data);
+
+	// Wait until all the pending events have been processed by the wrapped listener
+	void Flush();
+
+	// Drain the pending events and stop the worker thread
+	void Stop();
+
+	// Get the current number of products with a pending event
+	std::size_t GetQueueDepth();
+
+	// Get the number of events dropped by the conflation
+	long GetDroppedCount() const;
+
+	// Get the number of events handed over to the wrapped listener
+	long GetProcessedCount() const;
+};
+
+template <typename V>
+ConflatingServiceListener<V>::ConflatingServiceListener(ServiceListener<V>* _listener, std::size_t _maxBatch) :
+	listener(_listener), running(true), enqueued(0), dropped(0), processed(0),
+	maxBatch(_maxBatch > 0 ? _maxBatch : 1)
+{
+	worker = std::thread(&ConflatingServiceListener<V>::Run, this);
+}
+
+template <typename V>
+ConflatingServiceListener<V>::~ConflatingServiceListener()
+{
+	Stop();
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::Enqueue(ServiceEventType type, V &data)
+{
+	ProductHandle handle = data.GetProduct().GetHandle();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Slot* found;
+		if (handle < 0) // kept apart by product id, never conflated with another product
+			found = &unregistered[std::string(data.GetProduct().GetProductId())];
+		else
+		{
+			if (static_cast<std::size_t>(handle) >= slots.size())
+				slots.resize(static_cast<std::size_t>(handle) + 1);
+			found = &slots[handle];
+		}
+		Slot &slot = *found;
+		if (slot.pending) // conflate into the pending event (a pending add stays an add)
+		{
+			ConflateEvent(slot.data, data);
+			if (!(slot.type == ADD_EVENT && type == UPDATE_EVENT))
+				slot.type = type;
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		slot.data = data;
+		slot.type = type;
+		slot.pending = true;
+		ready.push_back(&slot);
+		enqueued.fetch_add(1, std::memory_order_release);
+	}
+	condition.notify_one();
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::Dispatch(ServiceEventType type, std::vector<V> &batch)
+{
+	if (type == ADD_EVENT)
+		listener->ProcessAddBatch(batch.data(), batch.size());
+	else if (type == UPDATE_EVENT)
+		listener->ProcessUpdateBatch(batch.data(), batch.size());
+	else
+	{
+		for (auto &data : batch)
+			listener->ProcessRemove(data);
+	}
+	processed.fetch_add(batch.size(), std::memory_order_release);
+	batch.clear();
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::Run()
+{
+	std::vector<V> events; // the events taken out of the slots
+	std::vector<ServiceEventType> types;
+	std::vector<V> batch; // consecutive events of the same type
+	events.reserve(maxBatch);
+	types.reserve(maxBatch);
+	batch.reserve(maxBatch);
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return !ready.empty() || !running; });
+			if (ready.empty()) // stopped and drained
+				break;
+			while (!ready.empty() && events.size() < maxBatch)
+			{
+				Slot &slot = *ready.front();
+				ready.pop_front();
+				events.push_back(std::move(slot.data));
+				types.push_back(slot.type);
+				slot.pending = false;
+			}
+		}
+
+		// hand the runs of events of the same type over, out of the lock
+		for (std::size_t i = 0; i < events.size(); i++)
+		{
+			if (!batch.empty() && types[i] != types[i - 1])
+				Dispatch(types[i - 1], batch);
+			batch.push_back(std::move(events[i]));
+		}
+		if (!batch.empty())
+			Dispatch(types.back(), batch);
+		events.clear();
+		types.clear();
+	}
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::ProcessAdd(V &data)
+{
+	Enqueue(ADD_EVENT, data);
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::ProcessRemove(V &data)
+{
+	Enqueue(REMOVE_EVENT, data);
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::ProcessUpdate(V &data)
+{
+	Enqueue(UPDATE_EVENT, data);
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::Flush()
+{
+	while (processed.load(std::memory_order_acquire) < enqueued.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+template <typename V>
+void ConflatingServiceListener<V>::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_one();
+	if (worker.joinable())
+		worker.join();
+}
+
+template <typename V>
+std::size_t ConflatingServiceListener<V>::GetQueueDepth()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return ready.size();
+}
+
+template <typename V>
+long ConflatingServiceListener<V>::GetDroppedCount() const
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+template <typename V>
+long ConflatingServiceListener<V>::GetProcessedCount() const
+{
+	return processed.load(std::memory_order_relaxed);
+}
+
+#endif // !ConflatingServiceListener_hpp
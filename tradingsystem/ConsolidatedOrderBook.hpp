@@ -0,0 +1,192 @@
+// ConsolidatedOrderBook.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the order book consolidated across the venues (BROKERTEC, ESPEED and CME):
+// each price level keeps the total quantity and the quantity of each venue, so the top of the book
+// carries its venue attribution; the venue books are merged one changed level at a time
+
+#ifndef ConsolidatedOrderBook_hpp
+#define ConsolidatedOrderBook_hpp
+
+#include "marketdataservice.hpp"
+#include "executionservice.hpp"
+#include "TickPrice.hpp"
+#include <vector>
+
+// # of venues in the Market enum
+const int NUM_MARKETS = 3;
+
+// Get the venue name
+inline const char* MarkettoString(Market market)
+{
+	switch (market)
+	{
+	case BROKERTEC: return "BROKERTEC";
+	case ESPEED: return "ESPEED";
+	default: return "CME";
+	}
+}
+
+// Consolidated order book
+// DEPTH is the maximum number of price levels per side (the venue depth times the number of venues
+// holds the union of full venue books, so no level is ever dropped)
+template <int DEPTH = 5 * NUM_MARKETS>
+class ConsolidatedOrderBook
+{
+protected:
+	TickPrice prices[2][DEPTH]; // prices[side][level], bids descending and offers ascending
+	long quantities[2][DEPTH]; // total quantity of the level
+	long venueQuantities[2][DEPTH][NUM_MARKETS]; // quantity of each venue at the level
+	int depth[2]; // # of levels on each side
+
+	// Whether price a is better than price b on a side
+	static bool IsBetter(PricingSide side, TickPrice a, TickPrice b);
+
+public:
+	ConsolidatedOrderBook(); // empty ctor
+
+	// Remove all the levels
+	void Clear();
+
+	// Merge a change of quantity of a venue at a price level (positive when added, negative when removed),
+	// the level is created when absent and removed when its total quantity drops to zero
+	// return the level changed, or -1 if nothing changed (or the book is full)
+	int ApplyVenueChange(PricingSide side, Market venue, TickPrice price, long quantityChange);
+
+	// Get the number of levels on a side
+	int GetDepth(PricingSide side) const;
+
+	// Get the price of a level on a side (level 0 is the best)
+	TickPrice GetPrice(PricingSide side, int level) const;
+
+	// Get the total quantity of a level on a side (level 0 is the best)
+	long GetQuantity(PricingSide side, int level) const;
+
+	// Get the quantity of a venue at a level on a side (level 0 is the best)
+	long GetVenueQuantity(PricingSide side, int level, Market venue) const;
+
+	// Get the best bid/offer pair in O(1) (an empty side gives a zero order)
+	BidOffer GetBestBidOffer() const;
+
+	// Convert to an order book of the given product with one order per level, from the best price
+	template <typename T>
+	OrderBook<T> ToOrderBook(const T &product) const;
+};
+
+template <int DEPTH>
+ConsolidatedOrderBook<DEPTH>::ConsolidatedOrderBook()
+{
+	depth[BID] = 0;
+	depth[OFFER] = 0;
+}
+
+template <int DEPTH>
+bool ConsolidatedOrderBook<DEPTH>::IsBetter(PricingSide side, TickPrice a, TickPrice b)
+{
+	return (side == BID) ? a > b : a < b;
+}
+
+template <int DEPTH>
+void ConsolidatedOrderBook<DEPTH>::Clear()
+{
+	depth[BID] = 0;
+	depth[OFFER] = 0;
+}
+
+template <int DEPTH>
+int ConsolidatedOrderBook<DEPTH>::ApplyVenueChange(PricingSide side, Market venue, TickPrice price, long quantityChange)
+{
+	if (quantityChange == 0)
+		return -1;
+
+	// find the first level not better than the price
+	int level = 0;
+	while (level < depth[side] && IsBetter(side, prices[side][level], price))
+		level++;
+
+	if (level < depth[side] && prices[side][level] == price) // the level exists
+	{
+		venueQuantities[side][level][venue] += quantityChange;
+		quantities[side][level] += quantityChange;
+		if (quantities[side][level] <= 0) // the level is gone from all the venues
+		{
+			for (int i = level + 1; i < depth[side]; i++)
+			{
+				prices[side][i - 1] = prices[side][i];
+				quantities[side][i - 1] = quantities[side][i];
+				for (int k = 0; k < NUM_MARKETS; k++)
+					venueQuantities[side][i - 1][k] = venueQuantities[side][i][k];
+			}
+			depth[side]--;
+		}
+		return level;
+	}
+	if (quantityChange < 0 || depth[side] == DEPTH) // nothing to remove, or no room
+		return -1;
+
+	// insert the level, shifting the worse levels down
+	for (int i = depth[side]; i > level; i--)
+	{
+		prices[side][i] = prices[side][i - 1];
+		quantities[side][i] = quantities[side][i - 1];
+		for (int k = 0; k < NUM_MARKETS; k++)
+			venueQuantities[side][i][k] = venueQuantities[side][i - 1][k];
+	}
+	prices[side][level] = price;
+	quantities[side][level] = quantityChange;
+	for (int k = 0; k < NUM_MARKETS; k++)
+		venueQuantities[side][level][k] = 0;
+	venueQuantities[side][level][venue] = quantityChange;
+	depth[side]++;
+	return level;
+}
+
+template <int DEPTH>
+int ConsolidatedOrderBook<DEPTH>::GetDepth(PricingSide side) const
+{
+	return depth[side];
+}
+
+template <int DEPTH>
+TickPrice ConsolidatedOrderBook<DEPTH>::GetPrice(PricingSide side, int level) const
+{
+	return prices[side][level];
+}
+
+template <int DEPTH>
+long ConsolidatedOrderBook<DEPTH>::GetQuantity(PricingSide side, int level) const
+{
+	return quantities[side][level];
+}
+
+template <int DEPTH>
+long ConsolidatedOrderBook<DEPTH>::GetVenueQuantity(PricingSide side, int level, Market venue) const
+{
+	return venueQuantities[side][level][venue];
+}
+
+template <int DEPTH>
+BidOffer ConsolidatedOrderBook<DEPTH>::GetBestBidOffer() const
+{
+	Order bid = (depth[BID] > 0) ? Order(prices[BID][0], quantities[BID][0], BID) : Order(TickPrice(), 0, BID);
+	Order offer = (depth[OFFER] > 0) ? Order(prices[OFFER][0], quantities[OFFER][0], OFFER) : Order(TickPrice(), 0, OFFER);
+	return BidOffer(bid, offer);
+}
+
+template <int DEPTH>
+template <typename T>
+OrderBook<T> ConsolidatedOrderBook<DEPTH>::ToOrderBook(const T &product) const
+{
+	std::vector<Order> bidStack;
+	std::vector<Order> offerStack;
+	bidStack.reserve(depth[BID]);
+	offerStack.reserve(depth[OFFER]);
+	for (int i = 0; i < depth[BID]; i++)
+		bidStack.push_back(Order(prices[BID][i], quantities[BID][i], BID));
+	for (int i = 0; i < depth[OFFER]; i++)
+		offerStack.push_back(Order(prices[OFFER][i], quantities[OFFER][i], OFFER));
+	return OrderBook<T>(product, bidStack, offerStack);
+}
+
+#endif // !ConsolidatedOrderBook_hpp
@@ -0,0 +1,263 @@
+// CsvReader.hpp
+//
+// Author: Yuchen Liu
+//
+// A zero-copy reader of the input csv files shared by the subscribe connectors:
+// the file is memory-mapped and each row is tokenized in place into string views,
+// so that no memory is allocated per row or per field
+// (a reader can also tokenize a range of rows of a file mapped elsewhere, see ParallelCsvReader.hpp)
+
+#ifndef CsvReader_hpp
+#define CsvReader_hpp
+
+#include "StopWatch.hpp"
+#include "utilityfunction.hpp"
+#include "TickPrice.hpp"
+#include "boost/utility/string_view.hpp"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h> // the following are Unix only
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Memory-mapped csv reader
+// The fields of the current row are views into the mapped file and are
+// only valid until the next call of NextRow() (or the destruction of the reader)
+class CsvReader
+{
+protected:
+	int fd; // file descriptor (-1 if the file cannot be opened, or for a range of a file mapped elsewhere)
+	const char* begin; // the mapped file
+	const char* end;
+	const char* cursor; // beginning of the next row
+	std::size_t size; // size of the file in bytes
+	char separator;
+	std::vector<boost::string_view> fields; // fields of the current row (re-used)
+	long rows = 0; // # of rows read (header excluded)
+	StopWatch sw;
+	bool finished = false;
+
+	// Trim the spaces and the carriage return on both sides of a field
+	static boost::string_view Trim(const char* first, const char* last);
+
+public:
+	CsvReader(const std::string &path, bool skipHeader = true, char _separator = ','); // ctor, discards the header if skipHeader
+	CsvReader(const char* first, const char* last, char _separator = ','); // ctor, reads the rows of a range of a mapped file
+	~CsvReader(); // dtor, unmaps the file
+
+	// Whether the file is open
+	bool IsOpen() const;
+
+	// Move to the next non-empty row, return false at the end of the file
+	bool NextRow();
+
+	// Get the number of fields in the current row
+	std::size_t GetFieldCount() const;
+
+	// Get the i-th (trimmed) field of the current row
+	const boost::string_view& GetField(std::size_t i) const;
+
+	// Get the i-th field of the current row as an integer
+	long GetLong(std::size_t i) const;
+
+	// Get the i-th field of the current row as a price in the 99-xyz notation (NaN if malformed)
+	double GetPrice(std::size_t i) const;
+
+	// Get the i-th field of the current row as a tick price in the 99-xyz notation, return false if malformed
+	bool GetTickPrice(std::size_t i, TickPrice &price) const;
+
+	// Get the fields [i, i + n) of the current row as numbers of ticks in the 99-xyz notation,
+	// return false if any of them is malformed
+	bool GetTicks(std::size_t i, std::size_t n, long* ticks) const;
+
+	// Copy the i-th field of the current row into a string (re-using its capacity)
+	void GetString(std::size_t i, std::string &output) const;
+
+	// Get the number of rows read (header excluded)
+	long GetRowCount() const;
+
+	// Get the size of the file in bytes
+	std::size_t GetBytes() const;
+
+	// Get the part of the file not read yet
+	void GetRemaining(const char* &first, const char* &last) const;
+
+	// Print the read throughput (MB/s and rows/s) from the opening of the file to its end
+	void Report(std::ostream &out, const std::string &name) const;
+
+private:
+	CsvReader(const CsvReader &); // not copyable, owns the mapping
+	CsvReader & operator=(const CsvReader &);
+};
+
+CsvReader::CsvReader(const std::string &path, bool skipHeader, char _separator) :
+	fd(-1), begin(nullptr), end(nullptr), cursor(nullptr), size(0), separator(_separator)
+{
+	sw.Reset();
+	sw.StartStopWatch();
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat info;
+	if (::fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		size = static_cast<std::size_t>(info.st_size);
+		void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			::close(fd);
+			fd = -1;
+			size = 0;
+			return;
+		}
+		::madvise(mapped, size, MADV_SEQUENTIAL); // read once, front to back
+		begin = static_cast<const char*>(mapped);
+		end = begin + size;
+		cursor = begin;
+	}
+
+	if (skipHeader && cursor != end) // discard header
+	{
+		const char* eol = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+		cursor = (eol == nullptr) ? end : eol + 1;
+	}
+}
+
+CsvReader::CsvReader(const char* first, const char* last, char _separator) :
+	fd(-1), begin(first), end(last), cursor(first), size(last - first), separator(_separator)
+{
+	sw.Reset();
+	sw.StartStopWatch();
+}
+
+CsvReader::~CsvReader()
+{
+	if (begin != nullptr && fd >= 0) // not for a range of a file mapped elsewhere
+		::munmap(const_cast<char*>(begin), size);
+	if (fd >= 0)
+		::close(fd);
+}
+
+boost::string_view CsvReader::Trim(const char* first, const char* last)
+{
+	while (first != last && (*first == ' ' || *first == '\t' || *first == '\r'))
+		first++;
+	while (last != first && (*(last - 1) == ' ' || *(last - 1) == '\t' || *(last - 1) == '\r'))
+		last--;
+	return boost::string_view(first, last - first);
+}
+
+bool CsvReader::IsOpen() const
+{
+	return fd >= 0 || begin != nullptr;
+}
+
+bool CsvReader::NextRow()
+{
+	fields.clear();
+	while (cursor != end && cursor != nullptr)
+	{
+		// find the end of the row
+		const char* eol = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+		const char* rowEnd = (eol == nullptr) ? end : eol;
+		const char* first = cursor;
+		cursor = (eol == nullptr) ? end : eol + 1;
+
+		if (Trim(first, rowEnd).empty()) // skip the empty rows
+			continue;
+
+		// split the row on the separator
+		for (const char* p = first; p != rowEnd; p++)
+		{
+			if (*p == separator)
+			{
+				fields.push_back(Trim(first, p));
+				first = p + 1;
+			}
+		}
+		fields.push_back(Trim(first, rowEnd));
+		rows++;
+		return true;
+	}
+	if (!finished)
+	{
+		sw.StopStopWatch();
+		finished = true;
+	}
+	return false;
+}
+
+std::size_t CsvReader::GetFieldCount() const
+{
+	return fields.size();
+}
+
+const boost::string_view& CsvReader::GetField(std::size_t i) const
+{
+	return fields[i];
+}
+
+long CsvReader::GetLong(std::size_t i) const
+{
+	const boost::string_view &field = fields[i];
+	std::size_t k = 0;
+	bool negative = false;
+	if (k < field.size() && (field[k] == '-' || field[k] == '+'))
+		negative = (field[k++] == '-');
+	long output = 0;
+	for (; k < field.size() && field[k] >= '0' && field[k] <= '9'; k++)
+		output = output * 10 + (field[k] - '0');
+	return negative ? -output : output;
+}
+
+double CsvReader::GetPrice(std::size_t i) const
+{
+	return BuffertoPrice(fields[i].data(), fields[i].size());
+}
+
+bool CsvReader::GetTickPrice(std::size_t i, TickPrice &price) const
+{
+	return TickPrice::FromBuffer(fields[i].data(), fields[i].size(), price);
+}
+
+bool CsvReader::GetTicks(std::size_t i, std::size_t n, long* ticks) const
+{
+	return BuffertoTicksBatch(&fields[i], n, ticks);
+}
+
+void CsvReader::GetString(std::size_t i, std::string &output) const
+{
+	output.assign(fields[i].data(), fields[i].size());
+}
+
+long CsvReader::GetRowCount() const
+{
+	return rows;
+}
+
+std::size_t CsvReader::GetBytes() const
+{
+	return size;
+}
+
+void CsvReader::GetRemaining(const char* &first, const char* &last) const
+{
+	first = cursor;
+	last = end;
+}
+
+void CsvReader::Report(std::ostream &out, const std::string &name) const
+{
+	double seconds = sw.GetTime();
+	double megabytes = size / (1024.0 * 1024.0);
+	out << name << ": parsed " << rows << " rows (" << megabytes << " MB) in " << seconds << " seconds ("
+		<< ((seconds > 0) ? megabytes / seconds : 0.0) << " MB/s, "
+		<< static_cast<long>((seconds > 0) ? rows / seconds : 0.0) << " rows/s)\n";
+}
+
+#endif // !CsvReader_hpp
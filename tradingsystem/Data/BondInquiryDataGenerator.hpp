@@ -22,7 +22,7 @@ void bond_inquiry_generator(std::string path, BondProductService* bondProductSer
 {
 	std::fstream file(path, std::ios::out | std::ios::trunc); // open the file
 	std::stringstream ss;
-	std::vector<Bond> bondVec = bondProductService->GetBonds(ticker);
+	BondView bondVec = bondProductService->GetBonds(ticker);
 
 	// random engine to be used
 	std::random_device rd;
@@ -55,7 +55,8 @@ void bond_inquiry_generator(std::string path, BondProductService* bondProductSer
 			long quantity = 1000000 * std::ceil(dis(eng) * 6);
 			// price (uniform-randomly decide)
 			double price = 99.0 + std::ceil(dis(eng) * 512) / 256.0; // between 99 and 101
-			std::string priceStr = PricetoString(price);
+			char priceStr[32];
+			PricetoBuffer(price, priceStr);
 			// state(always "receive")
 			std::string stateStr = "RECEIVED";
 
@@ -3,6 +3,7 @@
 // Author: Yuchen Liu
 // 
 // Simulate the market data (orderbook) with some instructions
+// The rows are formatted from pre-formatted fields into large buffers, one chunk per thread (see ParallelFileGenerator.hpp)
 
 #ifndef BondMarketDataGenerator_hpp
 #define BondMarketDataGenerator_hpp
@@ -10,59 +11,85 @@
 #include "productservice.hpp"
 #include "products.hpp"
 #include "utilityfunction.hpp"
+#include "ParallelFileGenerator.hpp"
+#include "BondPriceDataGenerator.hpp"
+#include "RecordPipe.hpp"
+#include "BondService/BondMarketDataSoa.hpp"
 #include <string>
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <sstream>
 
+// the levels of the orderbook of a product at a step of its path, in ticks:
+// the mid price of the price data (see bond_price_mid), the top spread (ocsillate from 1/128 to 1/32 to 1/128 
+// by 1/128 for each product) and the following spreads (by increments of 1/128), with the sizes
+void bond_market_data_levels(long step, long ticks[6], long quantities[5])
+{
+	long temp2 = step % 6;
+	ticks[0] = bond_price_mid(step).GetTicks();
+	for (int level = 0; level < 5; level++)
+	{
+		ticks[1 + level] = TickPrice::TICKS_PER_UNIT / 128 * (1 + ((temp2 < 3) ? temp2 : 6 - temp2) + level);
+		quantities[level] = 10000000L * (level + 1);
+	}
+}
+
 // generate the market data (orderbook) and write it to the file specified by path
-void bond_market_data_generator(std::string path, BondProductService* bondProductService, std::string ticker)
+// rowsPerProduct rows for each of the first productCount bonds of the ticker (0 for all of them), 
+// formatted on threads threads (0 for one per core)
+void bond_market_data_generator(std::string path, BondProductService* bondProductService, std::string ticker,
+	long rowsPerProduct = 1000000, std::size_t productCount = 0, std::size_t threads = 0)
 {
-	std::fstream file(path, std::ios::out | std::ios::trunc); // open the file
-	std::vector<Bond> bondVec = bondProductService->GetBonds(ticker);
+	BondView bondVec = bondProductService->GetBonds(ticker);
+	if (productCount > 0)
+		bondVec = bondVec.First(productCount);
+	int n = bondVec.size(); // # of bonds
 
-	if (file.is_open())
+	// bond id type and bond id of each product
+	std::vector<std::string> idStrs;
+	for (const Bond &bond : bondVec)
+		idStrs.push_back(std::string((bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN") + "," + bond.GetProductId() + ",");
+	// price of each step of the path
+	std::vector<std::string> priceStrs;
+	char buffer[32];
+	for (int step = 0; step < 1024; step++)
 	{
-		std::cout << "Market data: Simulating the market data...\n";
-		// header
-		file << "BondIDType,BondID,Price,Spread1,Spread2,Spread3,Spread4,Spread5," 
-			<< "Size1,Size2,Size3,Size4,Size5\n";
-
-		int n = bondVec.size(); // # of bonds
-		int bondIndex;
-		// each product has 1000000 data
-		for (long i = 0; i < n * 1000000; i++)
+		PricetoBuffer(bond_price_mid(step).ToDouble(), buffer);
+		priceStrs.push_back(std::string(buffer) + ",");
+	}
+	// spreads and sizes of each step of the path
+	std::vector<std::string> spreadStrs;
+	long ticks[6], quantities[5];
+	for (int step = 0; step < 6; step++)
+	{
+		bond_market_data_levels(step, ticks, quantities);
+		std::string spreads, sizes;
+		for (int level = 0; level < 5; level++)
 		{
-			bondIndex = i % n;
-			Bond bond = bondVec[bondIndex];
-			// bond id type
-			std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN";
-			// price (ocsillate from 99 to 101 to 99 with 1/256 as increments/decrements for each product)
-			int temp = (i / n) % 1024;
-			double price = 99.0 + ((temp < 512) ? temp / 256.0 : (1024 - temp) / 256.0);
-			std::string priceStr = PricetoString(price);
-			// top spread (alternate between 1/128 and 1/64 for each product)
-			int temp2 = (i / n) % 6;
-			double spread1 = 1 / 128.0 + ((temp2 < 3) ? temp2 / 128.0 : (6 - temp2) / 128.0);
-			std::string spreadStr1 = PricetoString(spread1);
-			// following spread (by increments of 1/128)
-			double spread2 = spread1 + 1 / 128.0;
-			double spread3 = spread1 + 2 / 128.0;
-			double spread4 = spread1 + 3 / 128.0;
-			double spread5 = spread1 + 4 / 128.0;
-			std::string spreadStr2 = PricetoString(spread2);
-			std::string spreadStr3 = PricetoString(spread3);
-			std::string spreadStr4 = PricetoString(spread4);
-			std::string spreadStr5 = PricetoString(spread5);
-			// make the output
-			file << Idtype << "," << bond.GetProductId()  << ","<< priceStr << "," 
-				<< spreadStr1 << "," << spreadStr2 << "," << spreadStr3 << "," << spreadStr4 << "," 
-				<< spreadStr5 << "," << std::to_string(10000000) << "," << std::to_string(20000000) << "," 
-				<< std::to_string(30000000) << "," << std::to_string(40000000) << "," << std::to_string(50000000) 
-				<< "\n";
+			PricetoBuffer(TickPrice::FromTicks(ticks[1 + level]).ToDouble(), buffer);
+			spreads = spreads + buffer + ",";
+			sizes = sizes + std::to_string(quantities[level]) + ((level < 4) ? "," : "\n");
+		}
+		spreadStrs.push_back(spreads + sizes);
+	}
 
+	// the rows [first, last): row i is for the product i % n, at the step i / n of its path
+	auto format = [&](long first, long last, std::string &output) {
+		output.reserve(output.size() + (last - first) * 96);
+		for (long i = first; i < last; i++)
+		{
+			long step = i / n;
+			output += idStrs[i % n];
+			output += priceStrs[step % 1024];
+			output += spreadStrs[step % 6];
 		}
+	};
+
+	std::cout << "Market data: Simulating the market data...\n";
+	if (generate_file_in_parallel(path, "BondIDType,BondID,Price,Spread1,Spread2,Spread3,Spread4,Spread5,"
+		"Size1,Size2,Size3,Size4,Size5\n", n * rowsPerProduct, format, threads))
+	{
 		std::cout << "Market data: Simulation finished!\n";
 	}
 	else
@@ -72,5 +99,42 @@ void bond_market_data_generator(std::string path, BondProductService* bondProduc
 
 }
 
+// generate the same market data as typed rows and hand them over to the pipe (no file), 
+// then close the pipe; called on the thread feeding the market data connector
+// (stops early if the connector closes the pipe)
+void bond_market_data_generator(RecordPipe<BondMarketDataRow>* pipe, BondProductService* bondProductService, 
+	std::string ticker, long rowsPerProduct = 1000000, std::size_t productCount = 0)
+{
+	BondView bondVec = bondProductService->GetBonds(ticker);
+	if (productCount > 0)
+		bondVec = bondVec.First(productCount);
+	long n = bondVec.size(); // # of bonds
+
+	// the rows point to the bonds of the reference data table, which outlive the connector
+	std::vector<const Bond*> bonds;
+	for (const Bond &bond : bondVec)
+		bonds.push_back(&bond);
+
+	// same path as the file
+	std::vector<BondMarketDataRow> chunk;
+	chunk.reserve(pipe->GetChunkSize());
+	BondMarketDataRow row;
+	row.venue = BROKERTEC;
+	for (long i = 0; i < n * rowsPerProduct; i++)
+	{
+		row.product = bonds[i % n];
+		bond_market_data_levels(i / n, row.ticks, row.quantities);
+		chunk.push_back(row);
+		if (chunk.size() == pipe->GetChunkSize())
+		{
+			if (!pipe->Push(chunk))
+				return;
+			chunk.reserve(pipe->GetChunkSize());
+		}
+	}
+	pipe->Push(chunk);
+	pipe->Close();
+}
+
 
 #endif // !BondMarketDataGenerator_hpp
@@ -3,6 +3,7 @@
 // Author: Yuchen Liu
 // 
 // Simulate the trade data with some instructions
+// The rows are formatted from pre-formatted fields into large buffers, one chunk per thread (see ParallelFileGenerator.hpp)
 
 #ifndef BondPriceDataGenerator_hpp
 #define BondPriceDataGenerator_hpp
@@ -10,47 +11,73 @@
 #include "productservice.hpp"
 #include "products.hpp"
 #include "utilityfunction.hpp"
+#include "ParallelFileGenerator.hpp"
+#include "RecordPipe.hpp"
+#include "pricingservice.hpp"
 #include <string>
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <sstream>
 
+// the mid price of a product at a step of its path (ocsillate from 99 to 101 to 99 by a tick for each product)
+TickPrice bond_price_mid(long step)
+{
+	long temp = step % 1024;
+	return TickPrice::FromTicks(99 * TickPrice::TICKS_PER_UNIT + ((temp < 512) ? temp : 1024 - temp));
+}
+
+// the spread of a product at a step of its path (alternate between 1/64 and 1/128 for each product)
+TickPrice bond_price_spread(long step)
+{
+	return TickPrice::FromTicks(TickPrice::TICKS_PER_UNIT / ((step % 2 == 0) ? 64 : 128));
+}
+
 // generate the price data and write it to the file specified by path
-void bond_price_generator(std::string path, BondProductService* bondProductService, std::string ticker)
+// rowsPerProduct rows for each of the first productCount bonds of the ticker (0 for all of them), 
+// formatted on threads threads (0 for one per core)
+void bond_price_generator(std::string path, BondProductService* bondProductService, std::string ticker,
+	long rowsPerProduct = 1000000, std::size_t productCount = 0, std::size_t threads = 0)
 {
-	std::fstream file(path, std::ios::out | std::ios::trunc); // open the file
-	std::vector<Bond> bondVec = bondProductService->GetBonds(ticker);
+	BondView bondVec = bondProductService->GetBonds(ticker);
+	if (productCount > 0)
+		bondVec = bondVec.First(productCount);
+	int n = bondVec.size(); // # of bonds
 
-	if (file.is_open())
+	// bond id type and bond id of each product
+	std::vector<std::string> idStrs;
+	for (const Bond &bond : bondVec)
+		idStrs.push_back(std::string((bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN") + "," + bond.GetProductId() + ",");
+	// price and spread of each step of the path
+	std::vector<std::string> priceStrs;
+	char buffer[32];
+	for (int step = 0; step < 1024; step++)
 	{
-		std::cout << "Price: Simulating the price data...\n";
-		// header
-		file << "BondIDType,BondID,Price,Spread\n";
+		PricetoBuffer(bond_price_mid(step).ToDouble(), buffer);
+		priceStrs.push_back(std::string(buffer) + ",");
+	}
+	std::string spreadStrs[2];
+	for (int step = 0; step < 2; step++)
+	{
+		PricetoBuffer(bond_price_spread(step).ToDouble(), buffer);
+		spreadStrs[step] = std::string(buffer) + "\n";
+	}
 
-		int n = bondVec.size(); // # of bonds
-		int bondIndex;
-		// each product has 1000000 data
-		for (long i = 0; i < n * 1000000; i++)
+	// the rows [first, last): row i is for the product i % n, at the step i / n of its path
+	auto format = [&](long first, long last, std::string &output) {
+		output.reserve(output.size() + (last - first) * 32);
+		for (long i = first; i < last; i++)
 		{
-			bondIndex = i % n;
-			Bond bond = bondVec[bondIndex];
-			// bond id type
-			std::string Idtype = (bond.GetBondIdType() == CUSIP) ? "CUSIP" : "ISIN";
-			// price (ocsillate from 99 to 101 to 99 with 1/256 as increments/decrements for each product)
-			int temp = (i / n) % 1024;
-			double price = 99.0 + ((temp < 512) ? temp / 256.0 : (1024 - temp) / 256.0);
-			std::string priceStr = PricetoString(price);
-			// spread (alternate between 1/128 and 1/64 for each product)
-			double spread = ((i / n) % 2 == 0) ? 1.0/64 : 1.0/128;
-			std::string spreadStr = PricetoString(spread);
-
-			// make the output
-			file << Idtype << "," << bond.GetProductId() << "," 
-				<< priceStr << "," << spreadStr << "\n";
-
-
+			long step = i / n;
+			output += idStrs[i % n];
+			output += priceStrs[step % 1024];
+			output += spreadStrs[step % 2];
 		}
+	};
+
+	std::cout << "Price: Simulating the price data...\n";
+	if (generate_file_in_parallel(path, "BondIDType,BondID,Price,Spread\n", n * rowsPerProduct, format, threads))
+	{
 		std::cout << "Price: Simulation finished!\n";
 	}
 	else
@@ -60,5 +87,34 @@ void bond_price_generator(std::string path, BondProductService* bondProductServi
 
 }
 
+// generate the same price data as typed prices and hand them over to the pipe (no file), 
+// then close the pipe; called on the thread feeding the pricing connector
+// (stops early if the connector closes the pipe)
+void bond_price_generator(RecordPipe<Price<Bond>>* pipe, BondProductService* bondProductService, std::string ticker,
+	long rowsPerProduct = 1000000, std::size_t productCount = 0)
+{
+	BondView bondVec = bondProductService->GetBonds(ticker);
+	if (productCount > 0)
+		bondVec = bondVec.First(productCount);
+	long n = bondVec.size(); // # of bonds
+
+	// same path as the file
+	std::vector<Price<Bond>> chunk;
+	chunk.reserve(pipe->GetChunkSize());
+	for (long i = 0; i < n * rowsPerProduct; i++)
+	{
+		long step = i / n;
+		chunk.push_back(Price<Bond>(bondVec[i % n], bond_price_mid(step), bond_price_spread(step)));
+		if (chunk.size() == pipe->GetChunkSize())
+		{
+			if (!pipe->Push(chunk))
+				return;
+			chunk.reserve(pipe->GetChunkSize());
+		}
+	}
+	pipe->Push(chunk);
+	pipe->Close();
+}
+
 
 #endif // !BondPriceDataGenerator_hpp
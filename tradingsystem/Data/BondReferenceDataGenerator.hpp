@@ -0,0 +1,54 @@
+// BondReferenceDataGenerator.hpp
+//
+// Author: Yuchen Liu
+//
+// Write the default securities master (the reference data of the bonds, see SecuritiesMaster.hpp):
+// the on-the-run treasuries with their PV01s and bucketed sectors, and optionally a synthetic universe of bonds
+
+#ifndef BondReferenceDataGenerator_hpp
+#define BondReferenceDataGenerator_hpp
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+// generate the securities master and write it to the file specified by path
+// the 6 treasuries (ticker T), followed by syntheticBonds synthetic bonds (ticker SYN, without a bucketed sector)
+void bond_reference_generator(std::string path, long syntheticBonds = 0)
+{
+	std::fstream file(path, std::ios::out | std::ios::trunc); // open the file
+	if (!file.is_open())
+	{
+		std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+		return;
+	}
+
+	std::cout << "Reference data: Writing the securities master...\n";
+	// header
+	file << "BondID,BondIDType,Ticker,Coupon,Maturity,PV01,Bucket\n";
+
+	// the treasuries (latest data)
+	file << "9128283H1,CUSIP,T,1.750,11/30/2019,0.0185,FrontEnd\n"; // 2Y bond
+	file << "9128283G3,CUSIP,T,1.750,11/15/2020,0.01034,FrontEnd\n"; // 3Y bond
+	file << "912828M80,CUSIP,T,2.000,11/30/2022,0.0176,Belly\n"; // 5Y bond
+	file << "9128283J7,CUSIP,T,2.125,11/30/2024,0.02215,Belly\n"; // 7Y bond
+	file << "9128283F5,CUSIP,T,2.25,11/15/2027,0.0202,Belly\n"; // 10Y bond
+	file << "912810RZ3,CUSIP,T,2.75,11/15/2047,0.0275,LongEnd\n"; // 30Y bond
+
+	// the synthetic bonds: coupons by 1/8 up to 6, monthly maturities over 30 years, PV01 growing with the maturity
+	std::stringstream ss;
+	for (long i = 0; i < syntheticBonds; i++)
+	{
+		long months = 1 + i % 360;
+		ss << "S" << std::setfill('0') << std::setw(8) << i << ",CUSIP,SYN," << 0.125 * (i % 49) << ","
+			<< std::setw(2) << 1 + (10 + months) % 12 << "/15/" << 2017 + (10 + months) / 12 << ","
+			<< 0.0008 * months / 12 << ",\n";
+	}
+	file << ss.str();
+	std::cout << "Reference data: " << 6 + syntheticBonds << " bonds written!\n";
+}
+
+
+#endif // !BondReferenceDataGenerator_hpp
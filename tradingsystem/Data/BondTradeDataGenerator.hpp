@@ -21,7 +21,7 @@ void bond_trade_generator(std::string path, BondProductService* bondProductServi
 {
 	std::fstream file(path, std::ios::out | std::ios::trunc); // open the file
 	std::stringstream ss;
-	std::vector<Bond> bondVec = bondProductService->GetBonds(ticker);
+	BondView bondVec = bondProductService->GetBonds(ticker);
 
 
 	if (file.is_open())
@@ -50,7 +50,8 @@ void bond_trade_generator(std::string path, BondProductService* bondProductServi
 			long quantity = 1000000 * ((i / n) % 5 + 1);
 			// price (99 for buy, 100 for sell)
 			double price = (side == "BUY")? 99.0: 100.0; 
-			std::string priceStr = PricetoString(price);
+			char priceStr[32];
+			PricetoBuffer(price, priceStr);
 			// book id (alternate between three books for each product)
 			std::string bookId = "TRSY1";
 			if ((i / n) % 3 == 1) bookId = "TRSY2";
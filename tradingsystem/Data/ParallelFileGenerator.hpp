@@ -0,0 +1,47 @@
+// ParallelFileGenerator.hpp
+//
+// Author: Yuchen Liu
+//
+// Write a large simulated data file in parallel: the rows are split into chunks,
+// each chunk is formatted into its own buffer on a pool of threads (see OrderedChunkPool.hpp),
+// and the buffers are written to the file in order, so the file is the same whatever the # of threads
+
+#ifndef ParallelFileGenerator_hpp
+#define ParallelFileGenerator_hpp
+
+#include "OrderedChunkPool.hpp"
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Format the rows [first, last) of a file, appending them to the buffer
+typedef std::function<void(long first, long last, std::string &buffer)> RowFormatter;
+
+// Write the header and the rows [0, rows) of a file formatted by format, chunkRows rows at once on threads threads
+// (0 for one per core; at most twice as many chunks as threads are formatted ahead of the writes)
+// return false if the file cannot be opened
+bool generate_file_in_parallel(const std::string &path, const std::string &header, long rows,
+	const RowFormatter &format, std::size_t threads = 0, long chunkRows = 1 << 16)
+{
+	std::fstream file(path, std::ios::out | std::ios::trunc | std::ios::binary); // open the file
+	if (!file.is_open())
+		return false;
+	file << header;
+
+	if (chunkRows <= 0)
+		chunkRows = 1;
+	long chunks = (rows > 0) ? (rows + chunkRows - 1) / chunkRows : 0;
+
+	// format the chunks on the pool, write them in order
+	OrderedChunkPool<std::string> pool(threads);
+	pool.Run(chunks, [&](std::size_t chunk, std::string &buffer) {
+		long first = static_cast<long>(chunk) * chunkRows;
+		format(first, std::min(first + chunkRows, rows), buffer);
+	}, [&](std::string &buffer) { file.write(buffer.data(), buffer.size()); });
+	return true;
+}
+
+
+#endif // !ParallelFileGenerator_hpp
@@ -0,0 +1,257 @@
+// FixedDepthOrderBook.hpp
+//
+// Author: Yuchen Liu
+//
+// Define an order book of a fixed depth with the price levels stored inline:
+// the prices and the quantities of each side are kept in two arrays (structure of arrays)
+// sorted from the best price, so the top of the book is always level 0 and no update allocates
+
+#ifndef FixedDepthOrderBook_hpp
+#define FixedDepthOrderBook_hpp
+
+#include "marketdataservice.hpp"
+#include "TickPrice.hpp"
+#include <vector>
+
+// Fixed-depth aggregated order book
+// Each price level aggregates the quantity of all the orders at its price;
+// the levels beyond the depth are dropped (the worst level falls off when a better one is added)
+// Type T is the product type, DEPTH is the maximum number of price levels per side
+template <typename T, int DEPTH = 5>
+class FixedDepthOrderBook
+{
+protected:
+	const T* product; // the product (owned by the product service, not copied)
+	TickPrice prices[2][DEPTH]; // prices[side][level], bids descending and offers ascending
+	long quantities[2][DEPTH]; // quantities[side][level]
+	int depth[2]; // # of levels on each side
+
+	// Whether price a is better than price b on a side
+	static bool IsBetter(PricingSide side, TickPrice a, TickPrice b);
+
+	// Remove a level on a side, shifting the worse levels up
+	void RemoveLevel(PricingSide side, int level);
+
+public:
+	static const int MAX_DEPTH = DEPTH;
+
+	FixedDepthOrderBook(); // empty ctor
+	FixedDepthOrderBook(const T* _product); // ctor
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Set the product
+	void SetProduct(const T* _product);
+
+	// Remove all the levels
+	void Clear();
+
+	// Replace the levels by the aggregated orders of a full order book (the product is kept)
+	void Assign(const OrderBook<T> &orderBook);
+
+	// Add quantity at a price level, creating the level if absent
+	// return the level updated, or -1 if the price is beyond the depth
+	int AddLevel(PricingSide side, TickPrice price, long quantity);
+
+	// Set the quantity at an existing price level (a non-positive quantity deletes the level)
+	// return the level updated, or -1 if the price is not in the book
+	int ModifyLevel(PricingSide side, TickPrice price, long quantity);
+
+	// Delete a price level
+	// return the level deleted, or -1 if the price is not in the book
+	int DeleteLevel(PricingSide side, TickPrice price);
+
+	// Find the level of a price on a side, -1 if absent
+	int FindLevel(PricingSide side, TickPrice price) const;
+
+	// Get the number of levels on a side
+	int GetDepth(PricingSide side) const;
+
+	// Get the price of a level on a side (level 0 is the best)
+	TickPrice GetPrice(PricingSide side, int level) const;
+
+	// Get the quantity of a level on a side (level 0 is the best)
+	long GetQuantity(PricingSide side, int level) const;
+
+	// Get the best bid/offer pair in O(1) (an empty side gives a zero order)
+	BidOffer GetBestBidOffer() const;
+
+	// Convert to an order book with one order per level, from the best price
+	OrderBook<T> ToOrderBook() const;
+
+	// Convert to an order book of the given product with one order per level, from the best price
+	OrderBook<T> ToOrderBook(const T &_product) const;
+};
+
+template <typename T, int DEPTH>
+FixedDepthOrderBook<T, DEPTH>::FixedDepthOrderBook() : product(nullptr)
+{
+	depth[BID] = 0;
+	depth[OFFER] = 0;
+}
+
+template <typename T, int DEPTH>
+FixedDepthOrderBook<T, DEPTH>::FixedDepthOrderBook(const T* _product) : product(_product)
+{
+	depth[BID] = 0;
+	depth[OFFER] = 0;
+}
+
+template <typename T, int DEPTH>
+bool FixedDepthOrderBook<T, DEPTH>::IsBetter(PricingSide side, TickPrice a, TickPrice b)
+{
+	return (side == BID) ? a > b : a < b;
+}
+
+template <typename T, int DEPTH>
+int FixedDepthOrderBook<T, DEPTH>::FindLevel(PricingSide side, TickPrice price) const
+{
+	for (int i = 0; i < depth[side]; i++)
+	{
+		if (prices[side][i] == price)
+			return i;
+	}
+	return -1;
+}
+
+template <typename T, int DEPTH>
+void FixedDepthOrderBook<T, DEPTH>::RemoveLevel(PricingSide side, int level)
+{
+	for (int i = level + 1; i < depth[side]; i++)
+	{
+		prices[side][i - 1] = prices[side][i];
+		quantities[side][i - 1] = quantities[side][i];
+	}
+	depth[side]--;
+}
+
+template <typename T, int DEPTH>
+const T& FixedDepthOrderBook<T, DEPTH>::GetProduct() const
+{
+	return *product;
+}
+
+template <typename T, int DEPTH>
+void FixedDepthOrderBook<T, DEPTH>::SetProduct(const T* _product)
+{
+	product = _product;
+}
+
+template <typename T, int DEPTH>
+void FixedDepthOrderBook<T, DEPTH>::Clear()
+{
+	depth[BID] = 0;
+	depth[OFFER] = 0;
+}
+
+template <typename T, int DEPTH>
+void FixedDepthOrderBook<T, DEPTH>::Assign(const OrderBook<T> &orderBook)
+{
+	Clear();
+	const std::vector<Order> &bidStack = orderBook.GetBidStack();
+	for (auto iter = bidStack.begin(); iter != bidStack.end(); iter++)
+		AddLevel(BID, iter->GetPrice(), iter->GetQuantity());
+	const std::vector<Order> &offerStack = orderBook.GetOfferStack();
+	for (auto iter = offerStack.begin(); iter != offerStack.end(); iter++)
+		AddLevel(OFFER, iter->GetPrice(), iter->GetQuantity());
+}
+
+template <typename T, int DEPTH>
+int FixedDepthOrderBook<T, DEPTH>::AddLevel(PricingSide side, TickPrice price, long quantity)
+{
+	// find the first level worse than the price, from the worst one (snapshots usually come best first)
+	int level = depth[side];
+	while (level > 0 && IsBetter(side, price, prices[side][level - 1]))
+		level--;
+
+	if (level > 0 && prices[side][level - 1] == price) // the level exists
+	{
+		quantities[side][level - 1] += quantity;
+		return level - 1;
+	}
+	if (level == DEPTH) // worse than a full book
+		return -1;
+
+	// shift the worse levels down (the worst one falls off a full book)
+	int last = (depth[side] < DEPTH) ? depth[side] : DEPTH - 1;
+	for (int i = last; i > level; i--)
+	{
+		prices[side][i] = prices[side][i - 1];
+		quantities[side][i] = quantities[side][i - 1];
+	}
+	prices[side][level] = price;
+	quantities[side][level] = quantity;
+	if (depth[side] < DEPTH) depth[side]++;
+	return level;
+}
+
+template <typename T, int DEPTH>
+int FixedDepthOrderBook<T, DEPTH>::ModifyLevel(PricingSide side, TickPrice price, long quantity)
+{
+	int level = FindLevel(side, price);
+	if (level < 0)
+		return -1;
+	if (quantity <= 0)
+		RemoveLevel(side, level);
+	else
+		quantities[side][level] = quantity;
+	return level;
+}
+
+template <typename T, int DEPTH>
+int FixedDepthOrderBook<T, DEPTH>::DeleteLevel(PricingSide side, TickPrice price)
+{
+	int level = FindLevel(side, price);
+	if (level >= 0)
+		RemoveLevel(side, level);
+	return level;
+}
+
+template <typename T, int DEPTH>
+int FixedDepthOrderBook<T, DEPTH>::GetDepth(PricingSide side) const
+{
+	return depth[side];
+}
+
+template <typename T, int DEPTH>
+TickPrice FixedDepthOrderBook<T, DEPTH>::GetPrice(PricingSide side, int level) const
+{
+	return prices[side][level];
+}
+
+template <typename T, int DEPTH>
+long FixedDepthOrderBook<T, DEPTH>::GetQuantity(PricingSide side, int level) const
+{
+	return quantities[side][level];
+}
+
+template <typename T, int DEPTH>
+BidOffer FixedDepthOrderBook<T, DEPTH>::GetBestBidOffer() const
+{
+	Order bid = (depth[BID] > 0) ? Order(prices[BID][0], quantities[BID][0], BID) : Order(TickPrice(), 0, BID);
+	Order offer = (depth[OFFER] > 0) ? Order(prices[OFFER][0], quantities[OFFER][0], OFFER) : Order(TickPrice(), 0, OFFER);
+	return BidOffer(bid, offer);
+}
+
+template <typename T, int DEPTH>
+OrderBook<T> FixedDepthOrderBook<T, DEPTH>::ToOrderBook() const
+{
+	return ToOrderBook(*product);
+}
+
+template <typename T, int DEPTH>
+OrderBook<T> FixedDepthOrderBook<T, DEPTH>::ToOrderBook(const T &_product) const
+{
+	std::vector<Order> bidStack;
+	std::vector<Order> offerStack;
+	bidStack.reserve(depth[BID]);
+	offerStack.reserve(depth[OFFER]);
+	for (int i = 0; i < depth[BID]; i++)
+		bidStack.push_back(Order(prices[BID][i], quantities[BID][i], BID));
+	for (int i = 0; i < depth[OFFER]; i++)
+		offerStack.push_back(Order(prices[OFFER][i], quantities[OFFER][i], OFFER));
+	return OrderBook<T>(_product, bidStack, offerStack);
+}
+
+#endif // !FixedDepthOrderBook_hpp
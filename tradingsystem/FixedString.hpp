@@ -0,0 +1,174 @@
+// FixedString.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the short string stored inline in a fixed-width character array (e.g. a 12-character CUSIP/ISIN),
+// so the products holding them stay trivially copyable: copying a product is a memcpy, with no allocation
+// It converts to std::string and boost::string_view, and compares and prints like a string
+
+#ifndef FixedString_hpp
+#define FixedString_hpp
+
+#include "boost/utility/string_view.hpp"
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <ostream>
+
+// String of at most N characters stored inline (zero padded)
+template <std::size_t N>
+class FixedString
+{
+protected:
+	char characters[N + 1]; // zero padded, so always terminated
+	unsigned char length;
+
+public:
+	FixedString(); // empty string
+	FixedString(const boost::string_view &value); // ctor, keeps the first N characters
+	FixedString(const std::string &value);
+	FixedString(const char* value);
+
+	// Get the maximum # of characters
+	static std::size_t GetCapacity();
+
+	// Whether a string fits (is not longer than N characters)
+	static bool Fits(const boost::string_view &value);
+
+	std::size_t size() const;
+	bool empty() const;
+	const char* data() const;
+	const char* c_str() const;
+
+	// Get the string as a view of the inline characters (valid as long as the FixedString)
+	boost::string_view View() const;
+
+	operator boost::string_view() const;
+	operator std::string() const;
+};
+
+template <std::size_t N>
+FixedString<N>::FixedString() :
+	length(0)
+{
+	static_assert(N < 256, "the length of a FixedString is stored in a byte");
+	std::memset(characters, 0, sizeof(characters));
+}
+
+template <std::size_t N>
+FixedString<N>::FixedString(const boost::string_view &value)
+{
+	length = static_cast<unsigned char>((value.size() < N) ? value.size() : N);
+	std::memcpy(characters, value.data(), length);
+	std::memset(characters + length, 0, sizeof(characters) - length);
+}
+
+template <std::size_t N>
+FixedString<N>::FixedString(const std::string &value) :
+	FixedString(boost::string_view(value))
+{
+}
+
+template <std::size_t N>
+FixedString<N>::FixedString(const char* value) :
+	FixedString(boost::string_view(value))
+{
+}
+
+template <std::size_t N>
+std::size_t FixedString<N>::GetCapacity()
+{
+	return N;
+}
+
+template <std::size_t N>
+bool FixedString<N>::Fits(const boost::string_view &value)
+{
+	return value.size() <= N;
+}
+
+template <std::size_t N>
+std::size_t FixedString<N>::size() const
+{
+	return length;
+}
+
+template <std::size_t N>
+bool FixedString<N>::empty() const
+{
+	return length == 0;
+}
+
+template <std::size_t N>
+const char* FixedString<N>::data() const
+{
+	return characters;
+}
+
+template <std::size_t N>
+const char* FixedString<N>::c_str() const
+{
+	return characters;
+}
+
+template <std::size_t N>
+boost::string_view FixedString<N>::View() const
+{
+	return boost::string_view(characters, length);
+}
+
+template <std::size_t N>
+FixedString<N>::operator boost::string_view() const
+{
+	return View();
+}
+
+template <std::size_t N>
+FixedString<N>::operator std::string() const
+{
+	return std::string(characters, length);
+}
+
+// comparisons with the other FixedStrings, the strings, the views and the literals
+template <std::size_t N>
+bool operator==(const FixedString<N> &left, const FixedString<N> &right) { return left.View() == right.View(); }
+template <std::size_t N>
+bool operator!=(const FixedString<N> &left, const FixedString<N> &right) { return left.View() != right.View(); }
+template <std::size_t N>
+bool operator<(const FixedString<N> &left, const FixedString<N> &right) { return left.View() < right.View(); }
+template <std::size_t N>
+bool operator==(const FixedString<N> &left, const std::string &right) { return left.View() == boost::string_view(right); }
+template <std::size_t N>
+bool operator==(const std::string &left, const FixedString<N> &right) { return right == left; }
+template <std::size_t N>
+bool operator!=(const FixedString<N> &left, const std::string &right) { return !(left == right); }
+template <std::size_t N>
+bool operator!=(const std::string &left, const FixedString<N> &right) { return !(right == left); }
+template <std::size_t N>
+bool operator==(const FixedString<N> &left, const boost::string_view &right) { return left.View() == right; }
+template <std::size_t N>
+bool operator==(const boost::string_view &left, const FixedString<N> &right) { return right.View() == left; }
+template <std::size_t N>
+bool operator!=(const FixedString<N> &left, const boost::string_view &right) { return left.View() != right; }
+template <std::size_t N>
+bool operator!=(const boost::string_view &left, const FixedString<N> &right) { return right.View() != left; }
+template <std::size_t N>
+bool operator==(const FixedString<N> &left, const char* right) { return left.View() == boost::string_view(right); }
+template <std::size_t N>
+bool operator!=(const FixedString<N> &left, const char* right) { return left.View() != boost::string_view(right); }
+
+// concatenation with the strings
+template <std::size_t N>
+std::string operator+(const std::string &left, const FixedString<N> &right) { return left + std::string(right); }
+template <std::size_t N>
+std::string operator+(const FixedString<N> &left, const std::string &right) { return std::string(left) + right; }
+template <std::size_t N>
+std::string operator+(const FixedString<N> &left, const char* right) { return std::string(left) + right; }
+
+template <std::size_t N>
+std::ostream& operator<<(std::ostream &output, const FixedString<N> &value)
+{
+	return output.write(value.data(), value.size());
+}
+
+#endif // !FixedString_hpp
@@ -0,0 +1,299 @@
+// GroupCommitWriter.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the asynchronous group commit writer of the historical data connectors:
+// the connectors hand their preformatted (text or binary) records over through a lock-free ring,
+// and a background thread writes everything pending with one system call and makes it durable
+// every N records and/or every few milliseconds
+// A writer with a header opens its file at the first record only, so a run that sends its records elsewhere
+// (e.g. to a binary journal) leaves the file of the previous run untouched
+
+#ifndef GroupCommitWriter_hpp
+#define GroupCommitWriter_hpp
+
+#include "SpscRingBuffer.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Maximum # of bytes of a record slot (a longer record is split over several slots)
+const std::size_t MAX_LOG_RECORD_LENGTH = 240;
+
+// A record slot of the ring, stored inline so that handing it over does not allocate
+struct LogRecord
+{
+	unsigned short length; // # of bytes used
+	bool last; // whether the slot ends a record
+	char data[MAX_LOG_RECORD_LENGTH];
+};
+
+// Group commit writer of an output file
+// At most one thread appends at a time (the connector of a service line), the writes happen on the worker thread
+class GroupCommitWriter
+{
+protected:
+	std::string path;
+	std::string header; // written first, once the file is opened
+	bool opened; // whether the file is opened and the worker started
+	int fd; // the output file, -1 if it cannot be opened
+	std::size_t syncEveryRecords; // fsync after this # of records (0: not on a record count)
+	long syncEveryMillis; // fsync when the oldest unsynced write is this old (0: not on a timer)
+	std::size_t batchBytes; // write as soon as this # of bytes is pending
+	SpscRingBuffer<LogRecord> queue;
+	std::atomic<bool> running;
+	std::atomic<long> appended; // # of records handed over
+	std::atomic<long> written; // # of records written to the file
+	std::atomic<long> bytes; // # of bytes written to the file
+	std::atomic<long> writes; // # of write calls
+	std::atomic<long> syncs; // # of fsync calls
+	std::atomic<std::size_t> maxQueueDepth; // deepest queue observed by the worker
+	std::atomic<double> seconds; // time from the first record taken to the last write
+	std::thread worker;
+
+	// Write the pending bytes with one call (and fsync if a durability point is reached)
+	void Commit(std::vector<char> &batch, long &unsynced, long &batchRecords, bool force);
+
+	// Worker thread loop
+	void Run();
+
+public:
+	// ctor, opens (and truncates) the file and starts the worker
+	GroupCommitWriter(const std::string &_path, std::size_t _syncEveryRecords = 0, long _syncEveryMillis = 0,
+		std::size_t _capacity = 8192, std::size_t _batchBytes = 1 << 20);
+	// ctor, opens (and truncates) the file, writes the header and starts the worker at the first record
+	GroupCommitWriter(const std::string &_path, const std::string &_header, std::size_t _syncEveryRecords = 0,
+		long _syncEveryMillis = 0, std::size_t _capacity = 8192, std::size_t _batchBytes = 1 << 20);
+	~GroupCommitWriter(); // dtor, writes the pending records and closes the file
+
+	// Open (and truncate) the file and start the worker, if not done yet, and tell whether the file is open
+	// (called by the appending thread)
+	bool Open();
+
+	// Whether the file is open
+	bool IsOpen() const;
+
+	// Hand a record over to the worker (opening the file if not done yet), spinning while the ring is full
+	void Append(const char *data, std::size_t length);
+
+	// Hand a text record over to the worker
+	void Append(const std::string &record);
+
+	// Wait until all the records handed over are written to the file
+	void Flush();
+
+	// Write the pending records, make them durable and stop the worker
+	void Stop();
+
+	// Get the current # of record slots waiting in the ring
+	std::size_t GetQueueDepth() const;
+
+	// Get the # of records written to the file
+	long GetWrittenCount() const;
+
+	// Print the records written, the throughput of the worker and the queue depth
+	void Report(std::ostream &out) const;
+};
+
+GroupCommitWriter::GroupCommitWriter(const std::string &_path, std::size_t _syncEveryRecords, long _syncEveryMillis,
+	std::size_t _capacity, std::size_t _batchBytes) :
+	path(_path), opened(false), fd(-1), syncEveryRecords(_syncEveryRecords), syncEveryMillis(_syncEveryMillis),
+	batchBytes(_batchBytes > 0 ? _batchBytes : 1), queue(_capacity), running(true), appended(0), written(0),
+	bytes(0), writes(0), syncs(0), maxQueueDepth(0), seconds(0.0)
+{
+	Open();
+}
+
+GroupCommitWriter::GroupCommitWriter(const std::string &_path, const std::string &_header, std::size_t _syncEveryRecords,
+	long _syncEveryMillis, std::size_t _capacity, std::size_t _batchBytes) :
+	path(_path), header(_header), opened(false), fd(-1), syncEveryRecords(_syncEveryRecords),
+	syncEveryMillis(_syncEveryMillis), batchBytes(_batchBytes > 0 ? _batchBytes : 1), queue(_capacity), running(true),
+	appended(0), written(0), bytes(0), writes(0), syncs(0), maxQueueDepth(0), seconds(0.0)
+{
+}
+
+bool GroupCommitWriter::Open()
+{
+	if (!opened)
+	{
+		opened = true;
+		fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		worker = std::thread(&GroupCommitWriter::Run, this);
+		if (!header.empty())
+			Append(header);
+	}
+	return fd >= 0;
+}
+
+GroupCommitWriter::~GroupCommitWriter()
+{
+	Stop();
+}
+
+bool GroupCommitWriter::IsOpen() const
+{
+	return fd >= 0;
+}
+
+void GroupCommitWriter::Append(const char *data, std::size_t length)
+{
+	if (!opened)
+		Open();
+	LogRecord record;
+	do
+	{
+		std::size_t n = (length < MAX_LOG_RECORD_LENGTH) ? length : MAX_LOG_RECORD_LENGTH;
+		std::memcpy(record.data, data, n);
+		record.length = static_cast<unsigned short>(n);
+		data += n;
+		length -= n;
+		record.last = (length == 0);
+		queue.Push(record);
+	} while (length > 0);
+	appended.fetch_add(1, std::memory_order_release);
+}
+
+void GroupCommitWriter::Append(const std::string &record)
+{
+	Append(record.data(), record.size());
+}
+
+void GroupCommitWriter::Commit(std::vector<char> &batch, long &unsynced, long &batchRecords, bool force)
+{
+	if (!batch.empty())
+	{
+		std::size_t offset = 0;
+		while (offset < batch.size())
+		{
+			ssize_t n = ::write(fd, batch.data() + offset, batch.size() - offset);
+			if (n < 0)
+			{
+				std::cout << "Oh no! Cannot write to " << path << "!\n";
+				break;
+			}
+			offset += n;
+		}
+		bytes.fetch_add(batch.size(), std::memory_order_relaxed);
+		writes.fetch_add(1, std::memory_order_relaxed);
+		unsynced += batchRecords;
+		batch.clear();
+	}
+	if (unsynced > 0 && (force || (syncEveryRecords > 0 && unsynced >= static_cast<long>(syncEveryRecords))))
+	{
+		::fsync(fd);
+		syncs.fetch_add(1, std::memory_order_relaxed);
+		unsynced = 0;
+	}
+	written.fetch_add(batchRecords, std::memory_order_release);
+	batchRecords = 0;
+}
+
+void GroupCommitWriter::Run()
+{
+	std::vector<char> batch; // the bytes of the records taken out of the ring
+	batch.reserve(batchBytes + MAX_LOG_RECORD_LENGTH);
+	long batchRecords = 0; // # of records in the batch
+	long unsynced = 0; // # of records written since the last fsync
+	bool started = false;
+	auto start = std::chrono::steady_clock::now();
+	auto lastSync = start;
+	LogRecord record;
+	int idle = 0; // # of consecutive empty polls
+	while (running.load(std::memory_order_acquire) || !queue.Empty())
+	{
+		std::size_t depth = queue.Size();
+		if (depth > maxQueueDepth.load(std::memory_order_relaxed))
+			maxQueueDepth.store(depth, std::memory_order_relaxed);
+
+		// take everything pending (up to a batch)
+		while (batch.size() < batchBytes && queue.TryPop(record))
+		{
+			if (!started)
+			{
+				start = std::chrono::steady_clock::now();
+				lastSync = start;
+				started = true;
+			}
+			batch.insert(batch.end(), record.data, record.data + record.length);
+			if (record.last) batchRecords++;
+		}
+
+		// the time-based durability point, also reached while the connectors are quiet
+		auto now = std::chrono::steady_clock::now();
+		bool due = syncEveryMillis > 0 && (unsynced > 0 || !batch.empty())
+			&& std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSync).count() >= syncEveryMillis;
+
+		if (!batch.empty() || due)
+		{
+			long syncsBefore = syncs.load(std::memory_order_relaxed);
+			if (fd >= 0)
+				Commit(batch, unsynced, batchRecords, due);
+			else
+			{
+				written.fetch_add(batchRecords, std::memory_order_release);
+				batch.clear();
+				batchRecords = 0;
+			}
+			if (syncs.load(std::memory_order_relaxed) != syncsBefore)
+				lastSync = std::chrono::steady_clock::now();
+			seconds.store(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+				std::memory_order_relaxed);
+			idle = 0;
+		}
+		else if (++idle < 1000)
+			std::this_thread::yield();
+		else // back off when the connectors are quiet
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	// the last durability point
+	if (fd >= 0 && (syncEveryRecords > 0 || syncEveryMillis > 0))
+		Commit(batch, unsynced, batchRecords, true);
+}
+
+void GroupCommitWriter::Flush()
+{
+	while (written.load(std::memory_order_acquire) < appended.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+void GroupCommitWriter::Stop()
+{
+	running.store(false, std::memory_order_release);
+	if (worker.joinable())
+		worker.join();
+	if (fd >= 0)
+	{
+		::close(fd);
+		fd = -1;
+	}
+}
+
+std::size_t GroupCommitWriter::GetQueueDepth() const
+{
+	return queue.Size();
+}
+
+long GroupCommitWriter::GetWrittenCount() const
+{
+	return written.load(std::memory_order_relaxed);
+}
+
+void GroupCommitWriter::Report(std::ostream &out) const
+{
+	long records = written.load(std::memory_order_acquire);
+	double elapsed = seconds.load(std::memory_order_relaxed);
+	out << path << ": " << records << " records (" << bytes.load(std::memory_order_relaxed) << " bytes) in "
+		<< writes.load(std::memory_order_relaxed) << " writes and " << syncs.load(std::memory_order_relaxed)
+		<< " syncs, " << static_cast<long>((elapsed > 0) ? records / elapsed : 0.0) << " records/s, queue depth "
+		<< GetQueueDepth() << " (max " << maxQueueDepth.load(std::memory_order_relaxed) << ")\n";
+}
+
+#endif // !GroupCommitWriter_hpp
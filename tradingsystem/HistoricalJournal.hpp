@@ -0,0 +1,769 @@
+// HistoricalJournal.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the binary append-only journal of the historical data:
+// each entity (position, PV01, price stream, execution order, inquiry) is stored as a fixed-layout record
+// behind a small header (type, length and time stamp), in segment files of a bounded size,
+// so the connectors never format text (see JournalDecoder.hpp for the conversion back to csv);
+// a sparse index of each segment (time range and products of each block of records) is built while writing
+// and saved next to the segment, for the queries of JournalQuery.hpp
+
+#ifndef HistoricalJournal_hpp
+#define HistoricalJournal_hpp
+
+#include "GroupCommitWriter.hpp"
+#include "products.hpp"
+#include "positionservice.hpp"
+#include "riskservice.hpp"
+#include "streamingservice.hpp"
+#include "executionservice.hpp"
+#include "inquiryservice.hpp"
+#include "boost/utility/string_view.hpp"
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <iostream>
+#include <fcntl.h> // the following are Unix only
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "BJNL", the first bytes of each segment
+const std::uint32_t JOURNAL_MAGIC = 0x4C4E4A42;
+const std::uint16_t JOURNAL_VERSION = 2;
+
+// "BIDX", the first bytes of the index of each segment
+const std::uint32_t JOURNAL_INDEX_MAGIC = 0x58444942;
+
+// # of bytes of records covered by an index entry (a block is closed at the first record boundary past it)
+const std::size_t JOURNAL_INDEX_BLOCK_BYTES = 64 << 10;
+
+// # of product handles kept in the product mask of an index entry
+const int JOURNAL_INDEX_MASK_PRODUCTS = 64;
+
+// # of bytes of the identifier fields (zero-padded, longer identifiers are truncated)
+const std::size_t JOURNAL_PRODUCT_ID_LENGTH = 16; // CUSIP/ISIN, or the name of a bucketed sector
+const std::size_t JOURNAL_ORDER_ID_LENGTH = 24; // order and inquiry identifiers
+const std::size_t JOURNAL_TICKER_LENGTH = 8;
+
+// Type of a journal record
+enum JournalRecordType { POSITION_RECORD = 1, PV01_RECORD, BUCKETED_PV01_RECORD, PRICE_STREAM_RECORD,
+	EXECUTION_ORDER_RECORD, INQUIRY_RECORD };
+
+// Header of a segment file
+struct JournalSegmentHeader
+{
+	std::uint32_t magic;
+	std::uint16_t version;
+	std::uint16_t reserved;
+	std::uint32_t segment; // index of the segment in the journal
+	std::uint32_t padding;
+	std::int64_t runId; // run that wrote the journal (the time stamp it was started at), the same in all its segments
+};
+
+// Header of a record, followed by length bytes of payload
+struct JournalRecordHeader
+{
+	std::uint16_t type; // a JournalRecordType
+	std::uint16_t length; // # of bytes of the payload
+	std::uint32_t reserved;
+	std::int64_t timestamp; // microseconds since the epoch
+};
+
+// Index entry of a block of records of a segment
+struct JournalIndexEntry
+{
+	std::uint64_t offset; // offset of the first record in the segment
+	std::uint64_t length; // # of bytes of the records
+	std::int64_t firstTimestamp; // earliest time stamp of the records
+	std::int64_t lastTimestamp; // latest time stamp of the records
+	std::uint64_t productMask; // bit h is set if a record of the product with handle h is in the block
+	std::uint32_t records; // # of records
+	std::uint32_t otherProducts; // 1 if a record without a handle below JOURNAL_INDEX_MASK_PRODUCTS is in the block
+};
+
+// Header of the index file of a segment, followed by the entries
+struct JournalIndexHeader
+{
+	std::uint32_t magic;
+	std::uint16_t version;
+	std::uint16_t reserved;
+	std::uint32_t segment;
+	std::uint32_t entries; // # of entries
+};
+
+// Position of a bond in the books TRSY1, TRSY2 and TRSY3
+struct PositionRecord
+{
+	char productId[JOURNAL_PRODUCT_ID_LENGTH];
+	std::uint8_t idType; // a BondIdType
+	std::uint8_t padding[7];
+	std::int64_t positions[3];
+	std::int64_t aggregatePosition;
+};
+
+// PV01 of a bond (PV01_RECORD), or of a bucketed sector named by productId (BUCKETED_PV01_RECORD)
+struct PV01Record
+{
+	char productId[JOURNAL_PRODUCT_ID_LENGTH];
+	std::uint8_t idType; // a BondIdType
+	std::uint8_t padding[7];
+	double pv01;
+	std::int64_t quantity;
+};
+
+// Two-way price stream of a bond, the prices in ticks
+struct PriceStreamRecord
+{
+	char productId[JOURNAL_PRODUCT_ID_LENGTH];
+	std::uint8_t idType; // a BondIdType
+	std::uint8_t padding[7];
+	std::int64_t bidTicks;
+	std::int64_t bidVisibleQuantity;
+	std::int64_t bidHiddenQuantity;
+	std::int64_t offerTicks;
+	std::int64_t offerVisibleQuantity;
+	std::int64_t offerHiddenQuantity;
+};
+
+// Execution order of a bond, the price in ticks
+struct ExecutionOrderRecord
+{
+	char orderId[JOURNAL_ORDER_ID_LENGTH];
+	char parentOrderId[JOURNAL_ORDER_ID_LENGTH];
+	char productId[JOURNAL_PRODUCT_ID_LENGTH];
+	std::uint8_t idType; // a BondIdType
+	std::uint8_t orderType; // an OrderType
+	std::uint8_t side; // a PricingSide
+	std::uint8_t isChildOrder;
+	std::uint8_t padding[4];
+	std::int64_t priceTicks;
+	std::int64_t visibleQuantity;
+	std::int64_t hiddenQuantity;
+};
+
+// Inquiry on a bond
+struct InquiryRecord
+{
+	char inquiryId[JOURNAL_ORDER_ID_LENGTH];
+	char productId[JOURNAL_PRODUCT_ID_LENGTH];
+	char ticker[JOURNAL_TICKER_LENGTH];
+	std::uint8_t idType; // a BondIdType
+	std::uint8_t side; // a Side
+	std::uint8_t state; // an InquiryState
+	std::uint8_t padding[5];
+	double price;
+	std::int64_t quantity;
+};
+
+// Copy an identifier into a fixed field (zero-padded, truncated if longer)
+void CopyJournalField(char *field, std::size_t length, const boost::string_view &value);
+
+// Get an identifier from a fixed field
+std::string GetJournalField(const char *field, std::size_t length);
+
+// Fill the record of a position (the books are TRSY1, TRSY2 and TRSY3 as in the position output)
+void MakeJournalRecord(Position<Bond> &data, PositionRecord &record);
+
+// Fill the record of the PV01 of a bond
+void MakeJournalRecord(const PV01<Bond> &data, PV01Record &record);
+
+// Fill the record of the PV01 of a bucketed sector
+void MakeJournalRecord(const PV01<BucketedSector<Bond>> &data, PV01Record &record);
+
+// Fill the record of a price stream
+void MakeJournalRecord(const PriceStream<Bond> &data, PriceStreamRecord &record);
+
+// Fill the record of an execution order
+void MakeJournalRecord(const ExecutionOrder<Bond> &data, ExecutionOrderRecord &record);
+
+// Fill the record of an inquiry
+void MakeJournalRecord(const Inquiry<Bond> &data, InquiryRecord &record);
+
+// Get the current time as the time stamp of a record
+std::int64_t GetJournalTimestamp();
+
+// Writer of a journal: the records are appended to the current segment through a group commit writer,
+// and a new segment is started once the current one would exceed its size
+// The segments of a previous run with the same base path are removed when the journal is started
+// The index of a segment is saved when the segment is closed (off the appending thread) and on each Flush()
+// At most one thread appends at a time (the connector of a service line), another one may flush (e.g. for a query)
+class JournalWriter
+{
+protected:
+	std::string basePath; // the segments are basePath.000000.jnl, basePath.000001.jnl, ...
+	std::size_t segmentBytes; // maximum size of a segment
+	std::size_t syncEveryRecords;
+	long syncEveryMillis;
+	std::unique_ptr<GroupCommitWriter> writer; // writer of the current segment
+	std::uint32_t segment; // index of the current segment
+	std::size_t bytesInSegment;
+	long records; // # of records appended
+	std::vector<JournalIndexEntry> index; // index of the current segment, the last entry is the open block
+	std::thread closer; // closes the previous segment
+	std::int64_t runId; // identifier of the run, written in the header of each segment
+	mutable std::mutex journalMutex; // guards the current segment and its index between Append() and Flush()
+
+	// Start the next segment (the first one if none), and close the current one on the closer thread
+	void OpenSegment();
+
+	// Wait until the previous segment is closed
+	void WaitForClose();
+
+	// Add a record to the index of the current segment
+	void IndexRecord(ProductHandle handle, std::int64_t timestamp, std::size_t offset, std::size_t length);
+
+	// Save the index of the current segment
+	void SaveIndex() const;
+
+	// Save the index of a segment of a journal
+	static void SaveIndex(const std::string &basePath, std::uint32_t segment, const std::vector<JournalIndexEntry> &index);
+
+	// Write the pending records of a segment, close it and save its index (on the closer thread)
+	static void CloseSegment(std::string basePath, std::uint32_t segment, GroupCommitWriter* writer,
+		std::vector<JournalIndexEntry> index);
+
+public:
+	JournalWriter(const std::string &_basePath, std::size_t _segmentBytes = 64 << 20,
+		std::size_t _syncEveryRecords = 0, long _syncEveryMillis = 0); // ctor, removes the old segments and starts the first one
+	~JournalWriter(); // dtor, closes the current segment and saves its index
+
+	// Whether the current segment is open
+	bool IsOpen() const;
+
+	// Append a record of the given type and time stamp, indexed on the handle of its product (if any)
+	template <typename R>
+	void Append(JournalRecordType type, const R &record, std::int64_t timestamp,
+		ProductHandle handle = NO_PRODUCT_HANDLE);
+
+	// Wait until all the records appended are written, and save the index of the current segment
+	void Flush();
+
+	// Get the base path of the segments
+	const std::string& GetBasePath() const;
+
+	// Get the identifier of the run that writes the journal
+	std::int64_t GetRunId() const;
+
+	// Get the # of records appended
+	long GetRecordCount() const;
+
+	// Get the # of segments started
+	std::uint32_t GetSegmentCount() const;
+
+	// Get the path of a segment of a journal
+	static std::string GetSegmentPath(const std::string &basePath, std::uint32_t segment);
+
+	// Get the path of the index of a segment of a journal
+	static std::string GetIndexPath(const std::string &basePath, std::uint32_t segment);
+
+	// Remove the segments and their indexes of a journal (basePath.NNNNNN.jnl and basePath.NNNNNN.idx)
+	static void RemoveSegments(const std::string &basePath);
+
+	// Print the records and the segments written, and the group commit of the current segment
+	void Report(std::ostream &out) const;
+};
+
+// Sequential reader of a journal, one memory-mapped segment at a time
+// The current record is only valid until the next call of NextRecord() (or the destruction of the reader)
+class JournalReader
+{
+protected:
+	std::string basePath;
+	std::uint32_t segment; // index of the mapped segment
+	int fd; // the mapped segment (-1 if none)
+	const char* begin;
+	const char* end;
+	const char* cursor; // beginning of the next record
+	std::size_t size;
+	const JournalRecordHeader* header; // the current record
+	long records; // # of records read
+	std::int64_t runId; // run that wrote the first segment (0 if none)
+
+	// Unmap the current segment
+	void CloseSegment();
+
+	// Map a segment, return false if it does not exist or is not a segment of the journal (of the same run)
+	bool OpenSegment(std::uint32_t _segment);
+
+public:
+	JournalReader(const std::string &_basePath); // ctor, maps the first segment
+	~JournalReader(); // dtor, unmaps the segment
+
+	// Whether a segment is mapped
+	bool IsOpen() const;
+
+	// Move to the next record (through the following segments), return false at the end of the journal
+	bool NextRecord();
+
+	// Get the header of the current record
+	const JournalRecordHeader& GetHeader() const;
+
+	// Get the payload of the current record as a record of type R
+	template <typename R>
+	const R& GetRecord() const;
+
+	// Get the # of records read
+	long GetRecordCount() const;
+
+	// Get the identifier of the run that wrote the journal, 0 if there is no journal
+	std::int64_t GetRunId() const;
+
+private:
+	JournalReader(const JournalReader &); // not copyable, owns the mapping
+	JournalReader & operator=(const JournalReader &);
+};
+
+void CopyJournalField(char *field, std::size_t length, const boost::string_view &value)
+{
+	std::size_t n = (value.size() < length) ? value.size() : length;
+	std::memcpy(field, value.data(), n);
+	std::memset(field + n, 0, length - n);
+}
+
+std::string GetJournalField(const char *field, std::size_t length)
+{
+	const char* last = static_cast<const char*>(std::memchr(field, '\0', length));
+	return std::string(field, (last == nullptr) ? length : last - field);
+}
+
+void MakeJournalRecord(Position<Bond> &data, PositionRecord &record)
+{
+	// hard-coded the book id
+	std::string books[3] = { "TRSY1", "TRSY2", "TRSY3" };
+	const Bond &bond = data.GetProduct();
+	CopyJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH, bond.GetProductId());
+	record.idType = static_cast<std::uint8_t>(bond.GetBondIdType());
+	std::memset(record.padding, 0, sizeof(record.padding));
+	for (int i = 0; i < 3; i++)
+		record.positions[i] = data.GetPosition(books[i]);
+	record.aggregatePosition = data.GetAggregatePosition();
+}
+
+void MakeJournalRecord(const PV01<Bond> &data, PV01Record &record)
+{
+	const Bond &bond = data.GetProduct();
+	CopyJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH, bond.GetProductId());
+	record.idType = static_cast<std::uint8_t>(bond.GetBondIdType());
+	std::memset(record.padding, 0, sizeof(record.padding));
+	record.pv01 = data.GetPV01();
+	record.quantity = data.GetQuantity();
+}
+
+void MakeJournalRecord(const PV01<BucketedSector<Bond>> &data, PV01Record &record)
+{
+	CopyJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH, data.GetProduct().GetName());
+	record.idType = 0;
+	std::memset(record.padding, 0, sizeof(record.padding));
+	record.pv01 = data.GetPV01();
+	record.quantity = data.GetQuantity();
+}
+
+void MakeJournalRecord(const PriceStream<Bond> &data, PriceStreamRecord &record)
+{
+	const Bond &bond = data.GetProduct();
+	CopyJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH, bond.GetProductId());
+	record.idType = static_cast<std::uint8_t>(bond.GetBondIdType());
+	std::memset(record.padding, 0, sizeof(record.padding));
+	const PriceStreamOrder &bid = data.GetBidOrder();
+	const PriceStreamOrder &offer = data.GetOfferOrder();
+	record.bidTicks = bid.GetPrice().GetTicks();
+	record.bidVisibleQuantity = bid.GetVisibleQuantity();
+	record.bidHiddenQuantity = bid.GetHiddenQuantity();
+	record.offerTicks = offer.GetPrice().GetTicks();
+	record.offerVisibleQuantity = offer.GetVisibleQuantity();
+	record.offerHiddenQuantity = offer.GetHiddenQuantity();
+}
+
+void MakeJournalRecord(const ExecutionOrder<Bond> &data, ExecutionOrderRecord &record)
+{
+	const Bond &bond = data.GetProduct();
+	CopyJournalField(record.orderId, JOURNAL_ORDER_ID_LENGTH, data.GetOrderId());
+	CopyJournalField(record.parentOrderId, JOURNAL_ORDER_ID_LENGTH, data.GetParentOrderId());
+	CopyJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH, bond.GetProductId());
+	record.idType = static_cast<std::uint8_t>(bond.GetBondIdType());
+	record.orderType = static_cast<std::uint8_t>(data.GetOrderType());
+	record.side = static_cast<std::uint8_t>(data.GetSide());
+	record.isChildOrder = data.IsChildOrder() ? 1 : 0;
+	std::memset(record.padding, 0, sizeof(record.padding));
+	record.priceTicks = data.GetPrice().GetTicks();
+	record.visibleQuantity = data.GetVisibleQuantity();
+	record.hiddenQuantity = data.GetHiddenQuantity();
+}
+
+void MakeJournalRecord(const Inquiry<Bond> &data, InquiryRecord &record)
+{
+	const Bond &bond = data.GetProduct();
+	CopyJournalField(record.inquiryId, JOURNAL_ORDER_ID_LENGTH, data.GetInquiryId());
+	CopyJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH, bond.GetProductId());
+	CopyJournalField(record.ticker, JOURNAL_TICKER_LENGTH, bond.GetTicker());
+	record.idType = static_cast<std::uint8_t>(bond.GetBondIdType());
+	record.side = static_cast<std::uint8_t>(data.GetSide());
+	record.state = static_cast<std::uint8_t>(data.GetState());
+	std::memset(record.padding, 0, sizeof(record.padding));
+	record.price = data.GetPrice();
+	record.quantity = data.GetQuantity();
+}
+
+std::int64_t GetJournalTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+JournalWriter::JournalWriter(const std::string &_basePath, std::size_t _segmentBytes,
+	std::size_t _syncEveryRecords, long _syncEveryMillis) :
+	basePath(_basePath), segmentBytes(_segmentBytes), syncEveryRecords(_syncEveryRecords),
+	syncEveryMillis(_syncEveryMillis), segment(0), bytesInSegment(0), records(0), runId(GetJournalTimestamp())
+{
+	RemoveSegments(basePath); // a longer previous run would leave segments read as part of this one
+	OpenSegment();
+}
+
+void JournalWriter::OpenSegment()
+{
+	std::uint32_t next = writer ? segment + 1 : 0;
+	std::unique_ptr<GroupCommitWriter> nextWriter(new GroupCommitWriter(GetSegmentPath(basePath, next),
+		syncEveryRecords, syncEveryMillis));
+	if (writer)
+	{
+		// joining the writer of the segment (and its fsync) would stall the connector: close it on the closer thread
+		WaitForClose();
+		closer = std::thread(&JournalWriter::CloseSegment, basePath, segment, writer.release(), std::move(index));
+		index.clear();
+	}
+	writer = std::move(nextWriter);
+	segment = next;
+	if (!writer->IsOpen())
+	{
+		std::cout << "Oh no! Cannot open the journal segment " << GetSegmentPath(basePath, segment) << "!\n";
+		return;
+	}
+
+	JournalSegmentHeader header;
+	header.magic = JOURNAL_MAGIC;
+	header.version = JOURNAL_VERSION;
+	header.reserved = 0;
+	header.segment = segment;
+	header.padding = 0;
+	header.runId = runId;
+	writer->Append(reinterpret_cast<const char*>(&header), sizeof(header));
+	bytesInSegment = sizeof(header);
+}
+
+JournalWriter::~JournalWriter()
+{
+	writer.reset();
+	SaveIndex();
+	WaitForClose();
+}
+
+void JournalWriter::WaitForClose()
+{
+	if (closer.joinable())
+		closer.join();
+}
+
+void JournalWriter::CloseSegment(std::string basePath, std::uint32_t segment, GroupCommitWriter* writer,
+	std::vector<JournalIndexEntry> index)
+{
+	delete writer; // writes the pending records and closes the segment
+	SaveIndex(basePath, segment, index);
+}
+
+void JournalWriter::IndexRecord(ProductHandle handle, std::int64_t timestamp, std::size_t offset, std::size_t length)
+{
+	if (index.empty() || index.back().length >= JOURNAL_INDEX_BLOCK_BYTES) // start a block
+	{
+		JournalIndexEntry entry;
+		entry.offset = offset;
+		entry.length = 0;
+		entry.firstTimestamp = timestamp;
+		entry.lastTimestamp = timestamp;
+		entry.productMask = 0;
+		entry.records = 0;
+		entry.otherProducts = 0;
+		index.push_back(entry);
+	}
+	JournalIndexEntry &entry = index.back();
+	entry.length += length;
+	entry.records++;
+	if (timestamp < entry.firstTimestamp) entry.firstTimestamp = timestamp;
+	if (timestamp > entry.lastTimestamp) entry.lastTimestamp = timestamp;
+	if (handle >= 0 && handle < JOURNAL_INDEX_MASK_PRODUCTS)
+		entry.productMask |= (std::uint64_t(1) << handle);
+	else
+		entry.otherProducts = 1;
+}
+
+void JournalWriter::SaveIndex() const
+{
+	SaveIndex(basePath, segment, index);
+}
+
+void JournalWriter::SaveIndex(const std::string &basePath, std::uint32_t segment, const std::vector<JournalIndexEntry> &index)
+{
+	// written aside then renamed over the index, so a query never loads a partly written one
+	std::string path = GetIndexPath(basePath, segment);
+	std::string temporaryPath = path + ".tmp";
+	int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		std::cout << "Oh no! Cannot write the journal index " << path << "!\n";
+		return;
+	}
+	JournalIndexHeader header;
+	header.magic = JOURNAL_INDEX_MAGIC;
+	header.version = JOURNAL_VERSION;
+	header.reserved = 0;
+	header.segment = segment;
+	header.entries = static_cast<std::uint32_t>(index.size());
+	bool written = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+	std::size_t bytes = index.size() * sizeof(JournalIndexEntry);
+	if (written && bytes > 0)
+		written = ::write(fd, index.data(), bytes) == static_cast<ssize_t>(bytes);
+	::close(fd);
+	if (!written || ::rename(temporaryPath.c_str(), path.c_str()) != 0)
+	{
+		std::cout << "Oh no! Cannot write the journal index " << path << "!\n";
+		::unlink(temporaryPath.c_str());
+	}
+}
+
+bool JournalWriter::IsOpen() const
+{
+	return writer->IsOpen();
+}
+
+template <typename R>
+void JournalWriter::Append(JournalRecordType type, const R &record, std::int64_t timestamp, ProductHandle handle)
+{
+	// the header and the payload, handed over as one record
+	char buffer[sizeof(JournalRecordHeader) + sizeof(R)];
+	JournalRecordHeader header;
+	header.type = static_cast<std::uint16_t>(type);
+	header.length = static_cast<std::uint16_t>(sizeof(R));
+	header.reserved = 0;
+	header.timestamp = timestamp;
+	std::memcpy(buffer, &header, sizeof(header));
+	std::memcpy(buffer + sizeof(header), &record, sizeof(R));
+
+	std::lock_guard<std::mutex> lock(journalMutex);
+	if (bytesInSegment + sizeof(buffer) > segmentBytes && bytesInSegment > sizeof(JournalSegmentHeader))
+		OpenSegment();
+	writer->Append(buffer, sizeof(buffer));
+	IndexRecord(handle, timestamp, bytesInSegment, sizeof(buffer));
+	bytesInSegment += sizeof(buffer);
+	records++;
+}
+
+void JournalWriter::Flush()
+{
+	std::lock_guard<std::mutex> lock(journalMutex); // the index is not saved while a record is added to it
+	writer->Flush();
+	WaitForClose(); // the index of the previous segment
+	SaveIndex();
+}
+
+const std::string& JournalWriter::GetBasePath() const
+{
+	return basePath;
+}
+
+std::int64_t JournalWriter::GetRunId() const
+{
+	return runId;
+}
+
+long JournalWriter::GetRecordCount() const
+{
+	return records;
+}
+
+std::uint32_t JournalWriter::GetSegmentCount() const
+{
+	return segment + 1;
+}
+
+std::string JournalWriter::GetSegmentPath(const std::string &basePath, std::uint32_t segment)
+{
+	char suffix[32];
+	std::snprintf(suffix, sizeof(suffix), ".%06u.jnl", static_cast<unsigned>(segment));
+	return basePath + suffix;
+}
+
+std::string JournalWriter::GetIndexPath(const std::string &basePath, std::uint32_t segment)
+{
+	char suffix[32];
+	std::snprintf(suffix, sizeof(suffix), ".%06u.idx", static_cast<unsigned>(segment));
+	return basePath + suffix;
+}
+
+void JournalWriter::RemoveSegments(const std::string &basePath)
+{
+	std::string::size_type slash = basePath.find_last_of('/');
+	std::string directory = (slash == std::string::npos) ? "./" : basePath.substr(0, slash + 1);
+	std::string name = (slash == std::string::npos) ? basePath : basePath.substr(slash + 1);
+	DIR* dir = ::opendir(directory.c_str());
+	if (dir == nullptr)
+		return;
+
+	// name.NNNNNN.jnl and name.NNNNNN.idx
+	std::vector<std::string> paths;
+	while (struct dirent* entry = ::readdir(dir))
+	{
+		std::string file(entry->d_name);
+		if (file.size() != name.size() + 11 || file.compare(0, name.size(), name) != 0 || file[name.size()] != '.')
+			continue;
+		std::string suffix = file.substr(name.size() + 7);
+		if (suffix != ".jnl" && suffix != ".idx")
+			continue;
+		bool digits = true;
+		for (std::size_t i = name.size() + 1; i < name.size() + 7; i++)
+			digits = digits && file[i] >= '0' && file[i] <= '9';
+		if (digits)
+			paths.push_back(directory + file);
+	}
+	::closedir(dir);
+
+	for (const std::string &path : paths)
+	{
+		if (::unlink(path.c_str()) != 0)
+			std::cout << "Oh no! Cannot remove the old journal file " << path << "!\n";
+	}
+}
+
+void JournalWriter::Report(std::ostream &out) const
+{
+	std::lock_guard<std::mutex> lock(journalMutex);
+	out << basePath << ": " << records << " records in " << GetSegmentCount() << " segments, current segment ";
+	writer->Report(out);
+}
+
+JournalReader::JournalReader(const std::string &_basePath) :
+	basePath(_basePath), segment(0), fd(-1), begin(nullptr), end(nullptr), cursor(nullptr), size(0),
+	header(nullptr), records(0), runId(0)
+{
+	OpenSegment(0);
+}
+
+JournalReader::~JournalReader()
+{
+	CloseSegment();
+}
+
+void JournalReader::CloseSegment()
+{
+	if (begin != nullptr)
+		::munmap(const_cast<char*>(begin), size);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+	begin = end = cursor = nullptr;
+	size = 0;
+}
+
+bool JournalReader::OpenSegment(std::uint32_t _segment)
+{
+	CloseSegment();
+	segment = _segment;
+	fd = ::open(JournalWriter::GetSegmentPath(basePath, segment).c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(JournalSegmentHeader))
+	{
+		CloseSegment();
+		return false;
+	}
+	size = static_cast<std::size_t>(info.st_size);
+	void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		::close(fd);
+		fd = -1;
+		size = 0;
+		return false;
+	}
+	::madvise(mapped, size, MADV_SEQUENTIAL); // read once, front to back
+	begin = static_cast<const char*>(mapped);
+	end = begin + size;
+
+	const JournalSegmentHeader* segmentHeader = reinterpret_cast<const JournalSegmentHeader*>(begin);
+	if (segmentHeader->magic != JOURNAL_MAGIC || segmentHeader->version != JOURNAL_VERSION)
+	{
+		std::cout << "Oh no! " << JournalWriter::GetSegmentPath(basePath, segment) << " is not a journal segment!\n";
+		CloseSegment();
+		return false;
+	}
+	if (segment == 0)
+		runId = segmentHeader->runId;
+	else if (segmentHeader->runId != runId) // left by another run
+	{
+		std::cout << "Oh no! " << JournalWriter::GetSegmentPath(basePath, segment) << " was written by another run!\n";
+		CloseSegment();
+		return false;
+	}
+	cursor = begin + sizeof(JournalSegmentHeader);
+	return true;
+}
+
+bool JournalReader::IsOpen() const
+{
+	return begin != nullptr;
+}
+
+bool JournalReader::NextRecord()
+{
+	while (begin != nullptr)
+	{
+		if (static_cast<std::size_t>(end - cursor) >= sizeof(JournalRecordHeader))
+		{
+			const JournalRecordHeader* next = reinterpret_cast<const JournalRecordHeader*>(cursor);
+			if (static_cast<std::size_t>(end - cursor) >= sizeof(JournalRecordHeader) + next->length)
+			{
+				header = next;
+				cursor += sizeof(JournalRecordHeader) + next->length;
+				records++;
+				return true;
+			}
+			std::cout << "Oh no! The last record of " << JournalWriter::GetSegmentPath(basePath, segment)
+				<< " is truncated!\n";
+		}
+		OpenSegment(segment + 1); // the end of the segment
+	}
+	header = nullptr;
+	return false;
+}
+
+const JournalRecordHeader& JournalReader::GetHeader() const
+{
+	return *header;
+}
+
+template <typename R>
+const R& JournalReader::GetRecord() const
+{
+	return *reinterpret_cast<const R*>(reinterpret_cast<const char*>(header) + sizeof(JournalRecordHeader));
+}
+
+long JournalReader::GetRecordCount() const
+{
+	return records;
+}
+
+std::int64_t JournalReader::GetRunId() const
+{
+	return runId;
+}
+
+#endif // !HistoricalJournal_hpp
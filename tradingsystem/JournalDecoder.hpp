@@ -0,0 +1,153 @@
+// JournalDecoder.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the conversion of a binary historical data journal (see HistoricalJournal.hpp)
+// back into the csv output of the historical data connectors, row for row
+
+#ifndef JournalDecoder_hpp
+#define JournalDecoder_hpp
+
+#include "HistoricalJournal.hpp"
+#include "TimestampFormatter.hpp"
+#include "TickPrice.hpp"
+#include "utilityfunction.hpp"
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+// Get the csv header of the output of a record type
+const char* GetJournalCsvHeader(JournalRecordType type);
+
+// Append the csv rows of the current record of a journal to the output
+void AppendJournalCsv(const JournalReader &reader, TimestampFormatter &formatter, std::string &output);
+
+// Decode a whole journal into a csv file, return the number of records decoded (-1 if the file cannot be written)
+long DecodeJournal(const std::string &basePath, const std::string &csvPath);
+
+const char* GetJournalCsvHeader(JournalRecordType type)
+{
+	switch (type)
+	{
+	case POSITION_RECORD: return "Time,BondIDType,BondID,BookId,Positions\n";
+	case PV01_RECORD:
+	case BUCKETED_PV01_RECORD: return "Time,ProductIDType,ProductID,PV01,Quantity\n";
+	case PRICE_STREAM_RECORD: return "Time,BondIDType,BondID,BidPrice,BidVisibleQuantity,BidHiddenQuantity,"
+		"OfferPrice,OfferVisibleQuantity,OfferHiddenQuantity\n";
+	case EXECUTION_ORDER_RECORD: return "Time,OrderType,OrderID,BondIDType,BondID,Side,VisibleQuantity,HiddenQuantity,"
+		"Price,IsChildOrder,ParentOrderId\n";
+	default: return "Time,InquiryID,BondIDType,BondID,Side,Quantity,Price,State\n";
+	}
+}
+
+void AppendJournalCsv(const JournalReader &reader, TimestampFormatter &formatter, std::string &output)
+{
+	const JournalRecordHeader &header = reader.GetHeader();
+	char timestamp[TIMESTAMP_LENGTH + 1];
+	formatter.Format(std::chrono::system_clock::time_point(std::chrono::microseconds(header.timestamp)), timestamp);
+	char priceStr[32];
+
+	switch (header.type)
+	{
+	case POSITION_RECORD:
+	{
+		const PositionRecord &record = reader.GetRecord<PositionRecord>();
+		std::string prefix = std::string(timestamp) + "," + (record.idType == CUSIP ? "CUSIP" : "ISIN") + ","
+			+ GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH) + ",";
+		const char* books[3] = { "TRSY1", "TRSY2", "TRSY3" };
+		for (int i = 0; i < 3; i++)
+			output += prefix + books[i] + "," + std::to_string(record.positions[i]) + "\n";
+		output += prefix + "AGGREGATED," + std::to_string(record.aggregatePosition) + "\n";
+		break;
+	}
+	case PV01_RECORD:
+	case BUCKETED_PV01_RECORD:
+	{
+		const PV01Record &record = reader.GetRecord<PV01Record>();
+		std::string Idtype = (header.type == BUCKETED_PV01_RECORD) ? "Bucketed Sector"
+			: (record.idType == CUSIP ? "CUSIP" : "ISIN");
+		output += std::string(timestamp) + "," + Idtype + "," + GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH)
+			+ "," + std::to_string(record.pv01) + "," + std::to_string(record.quantity) + "\n";
+		break;
+	}
+	case PRICE_STREAM_RECORD:
+	{
+		// the offer quantities are written as the bid ones, as in the streaming output
+		const PriceStreamRecord &record = reader.GetRecord<PriceStreamRecord>();
+		output += std::string(timestamp) + "," + (record.idType == CUSIP ? "CUSIP" : "ISIN") + ","
+			+ GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH) + ","
+			+ std::to_string(TickPrice::FromTicks(record.bidTicks).ToDouble()) + ","
+			+ std::to_string(record.bidVisibleQuantity) + "," + std::to_string(record.bidHiddenQuantity) + ","
+			+ std::to_string(TickPrice::FromTicks(record.offerTicks).ToDouble()) + ","
+			+ std::to_string(record.bidVisibleQuantity) + "," + std::to_string(record.bidHiddenQuantity) + "\n";
+		break;
+	}
+	case EXECUTION_ORDER_RECORD:
+	{
+		const ExecutionOrderRecord &record = reader.GetRecord<ExecutionOrderRecord>();
+		const char* typeStrs[5] = { "FOK", "IOC", "MARKET", "LIMIT", "STOP" };
+		TickPrice::FromTicks(record.priceTicks).ToBuffer(priceStr);
+		output += std::string(timestamp) + "," + (record.orderType < 5 ? typeStrs[record.orderType] : "") + ","
+			+ GetJournalField(record.orderId, JOURNAL_ORDER_ID_LENGTH) + "," + (record.idType == CUSIP ? "CUSIP" : "ISIN")
+			+ "," + GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH) + ","
+			+ (record.side == BID ? "BID" : "OFFER") + "," + std::to_string(record.visibleQuantity) + ","
+			+ std::to_string(record.hiddenQuantity) + "," + priceStr + "," + (record.isChildOrder ? "TRUE" : "FALSE")
+			+ "," + GetJournalField(record.parentOrderId, JOURNAL_ORDER_ID_LENGTH) + "\n";
+		break;
+	}
+	case INQUIRY_RECORD:
+	{
+		// the side column holds the ticker, as in the inquiry output
+		const InquiryRecord &record = reader.GetRecord<InquiryRecord>();
+		const char* stateStrs[5] = { "RECEIVED", "QUOTED", "DONE", "REJECTED", "CUSTOMER_REJECTED" };
+		PricetoBuffer(record.price, priceStr);
+		output += std::string(timestamp) + "," + GetJournalField(record.inquiryId, JOURNAL_ORDER_ID_LENGTH) + ","
+			+ (record.idType == CUSIP ? "CUSIP" : "ISIN") + "," + GetJournalField(record.productId, JOURNAL_PRODUCT_ID_LENGTH)
+			+ "," + GetJournalField(record.ticker, JOURNAL_TICKER_LENGTH) + "," + std::to_string(record.quantity) + ","
+			+ priceStr + "," + (record.state < 5 ? stateStrs[record.state] : "RECEIVED") + "\n";
+		break;
+	}
+	default:
+		std::cout << "Oh no! Unknown journal record type " << header.type << "!\n";
+	}
+}
+
+long DecodeJournal(const std::string &basePath, const std::string &csvPath)
+{
+	JournalReader reader(basePath);
+	if (!reader.IsOpen())
+	{
+		std::cout << "Oh no! Cannot open the journal " << basePath << "! Maybe the path is not right?\n";
+		return 0;
+	}
+	std::fstream file(csvPath, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+		return -1;
+	}
+
+	TimestampFormatter formatter;
+	std::string output; // re-used output buffer, written every 64 KB
+	output.reserve(1 << 17);
+	bool headerWritten = false;
+	while (reader.NextRecord())
+	{
+		if (!headerWritten)
+		{
+			output += GetJournalCsvHeader(JournalRecordType(reader.GetHeader().type));
+			headerWritten = true;
+		}
+		AppendJournalCsv(reader, formatter, output);
+		if (output.size() >= (1 << 16))
+		{
+			file.write(output.data(), output.size());
+			output.clear();
+		}
+	}
+	file.write(output.data(), output.size());
+	return reader.GetRecordCount();
+}
+
+#endif // !JournalDecoder_hpp
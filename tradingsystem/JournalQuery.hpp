@@ -0,0 +1,259 @@
+// JournalQuery.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the time- and product-indexed queries over a binary historical data journal (see HistoricalJournal.hpp):
+// the sparse index of each segment selects the blocks of records that may match,
+// and only those ranges of the segments are memory-mapped and scanned
+
+#ifndef JournalQuery_hpp
+#define JournalQuery_hpp
+
+#include "HistoricalJournal.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <iostream>
+#include <fcntl.h> // the following are Unix only
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A record found by a query, with its time stamp
+template <typename R>
+struct JournalEntry
+{
+	std::int64_t timestamp; // microseconds since the epoch
+	R record;
+};
+
+// Get the time stamp of a journal record from a local time (e.g. 10:00 today)
+std::int64_t ToJournalTimestamp(const boost::posix_time::ptime &localTime);
+
+// Queries over the segments of a journal
+// The indexes are loaded when the query is built: records appended afterwards are not seen
+// (flush the journal writer, then build a new query)
+class JournalQuery
+{
+protected:
+	std::string basePath;
+	std::vector<std::vector<JournalIndexEntry>> indexes; // index of each segment
+	long mappedBytes; // # of bytes mapped by the queries
+	long scannedRecords; // # of records scanned by the queries
+
+	// Load the index of a segment, return false if it does not exist
+	bool LoadIndex(std::uint32_t segment);
+
+	// Whether a block may hold records of a product in a time range
+	static bool IsSelected(const JournalIndexEntry &entry, ProductHandle handle, std::int64_t from, std::int64_t to);
+
+public:
+	JournalQuery(const std::string &_basePath); // ctor, loads the indexes of the segments
+
+	// Get the # of segments indexed
+	std::size_t GetSegmentCount() const;
+
+	// Find the records of a type and a product (identified by its handle and its identifier)
+	// with a time stamp in [from, to], in the order they were written
+	template <typename R>
+	std::vector<JournalEntry<R>> Find(JournalRecordType type, ProductHandle handle, const std::string &productId,
+		std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+		std::int64_t to = std::numeric_limits<std::int64_t>::max());
+
+	// Get the # of bytes mapped by the queries so far
+	long GetMappedBytes() const;
+
+	// Get the # of records scanned by the queries so far
+	long GetScannedRecords() const;
+};
+
+// The binary journal a historical data service persists its records to, and the queries over it
+class JournaledHistoricalData
+{
+protected:
+	JournalWriter* journal; // the binary journal the records are persisted to, if any
+
+	// Find the records of a type and a product persisted to the journal so far with a time stamp in [from, to]
+	// (the journal is flushed first, so they are all indexed)
+	template <typename R>
+	std::vector<JournalEntry<R>> Query(JournalRecordType type, ProductHandle handle, const std::string &productId,
+		std::int64_t from, std::int64_t to) const;
+
+public:
+	JournaledHistoricalData(); // ctor, no journal
+
+	// Set the binary journal the records are persisted to, for the queries
+	void SetJournal(JournalWriter* _journal);
+};
+
+std::int64_t ToJournalTimestamp(const boost::posix_time::ptime &localTime)
+{
+	std::tm local = boost::posix_time::to_tm(localTime);
+	local.tm_isdst = -1; // let the C library find out
+	std::time_t seconds = std::mktime(&local);
+	long long micros = localTime.time_of_day().total_microseconds() % 1000000;
+	return static_cast<std::int64_t>(seconds) * 1000000 + micros;
+}
+
+JournalQuery::JournalQuery(const std::string &_basePath) :
+	basePath(_basePath), mappedBytes(0), scannedRecords(0)
+{
+	for (std::uint32_t segment = 0; LoadIndex(segment); segment++) {}
+}
+
+bool JournalQuery::LoadIndex(std::uint32_t segment)
+{
+	int fd = ::open(JournalWriter::GetIndexPath(basePath, segment).c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	JournalIndexHeader header;
+	bool loaded = ::read(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header))
+		&& header.magic == JOURNAL_INDEX_MAGIC && header.version == JOURNAL_VERSION;
+	std::vector<JournalIndexEntry> entries;
+	if (loaded)
+	{
+		entries.resize(header.entries);
+		std::size_t bytes = entries.size() * sizeof(JournalIndexEntry);
+		loaded = bytes == 0 || ::read(fd, entries.data(), bytes) == static_cast<ssize_t>(bytes);
+	}
+	::close(fd);
+	if (!loaded)
+	{
+		std::cout << "Oh no! " << JournalWriter::GetIndexPath(basePath, segment) << " is not a journal index!\n";
+		return false;
+	}
+	indexes.push_back(entries);
+	return true;
+}
+
+bool JournalQuery::IsSelected(const JournalIndexEntry &entry, ProductHandle handle, std::int64_t from, std::int64_t to)
+{
+	if (entry.lastTimestamp < from || entry.firstTimestamp > to)
+		return false;
+	if (handle >= 0 && handle < JOURNAL_INDEX_MASK_PRODUCTS)
+		return (entry.productMask >> handle) & 1;
+	return entry.otherProducts != 0;
+}
+
+std::size_t JournalQuery::GetSegmentCount() const
+{
+	return indexes.size();
+}
+
+template <typename R>
+std::vector<JournalEntry<R>> JournalQuery::Find(JournalRecordType type, ProductHandle handle,
+	const std::string &productId, std::int64_t from, std::int64_t to)
+{
+	std::vector<JournalEntry<R>> found;
+	char key[JOURNAL_PRODUCT_ID_LENGTH];
+	CopyJournalField(key, JOURNAL_PRODUCT_ID_LENGTH, productId);
+	long pageSize = ::sysconf(_SC_PAGESIZE);
+
+	for (std::uint32_t segment = 0; segment < indexes.size(); segment++)
+	{
+		const std::vector<JournalIndexEntry> &index = indexes[segment];
+		int fd = -1;
+		std::size_t i = 0;
+		while (i < index.size())
+		{
+			if (!IsSelected(index[i], handle, from, to))
+			{
+				i++;
+				continue;
+			}
+
+			// a run of selected blocks, mapped at once (from the page it starts in)
+			std::size_t j = i + 1;
+			while (j < index.size() && IsSelected(index[j], handle, from, to))
+				j++;
+			std::uint64_t begin = index[i].offset;
+			std::uint64_t end = index[j - 1].offset + index[j - 1].length;
+			if (fd < 0)
+				fd = ::open(JournalWriter::GetSegmentPath(basePath, segment).c_str(), O_RDONLY);
+			struct stat info;
+			if (fd < 0 || ::fstat(fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < end)
+			{
+				std::cout << "Oh no! The journal segment " << JournalWriter::GetSegmentPath(basePath, segment)
+					<< " is missing or shorter than its index!\n";
+				break;
+			}
+			std::uint64_t pageBegin = begin - begin % pageSize;
+			std::size_t size = static_cast<std::size_t>(end - pageBegin);
+			void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(pageBegin));
+			if (mapped == MAP_FAILED)
+			{
+				std::cout << "Oh no! Cannot map the journal segment " << JournalWriter::GetSegmentPath(basePath, segment) << "!\n";
+				break;
+			}
+			mappedBytes += static_cast<long>(size);
+
+			// scan the records of the run
+			const char* cursor = static_cast<const char*>(mapped) + (begin - pageBegin);
+			const char* last = static_cast<const char*>(mapped) + size;
+			while (cursor + sizeof(JournalRecordHeader) <= last)
+			{
+				const JournalRecordHeader* header = reinterpret_cast<const JournalRecordHeader*>(cursor);
+				const char* payload = cursor + sizeof(JournalRecordHeader);
+				if (payload + header->length > last) // truncated
+					break;
+				cursor = payload + header->length;
+				scannedRecords++;
+				if (header->type != type || header->length != sizeof(R) || header->timestamp < from || header->timestamp > to)
+					continue;
+				const R* record = reinterpret_cast<const R*>(payload);
+				if (std::memcmp(record->productId, key, JOURNAL_PRODUCT_ID_LENGTH) != 0)
+					continue;
+				JournalEntry<R> entry;
+				entry.timestamp = header->timestamp;
+				entry.record = *record;
+				found.push_back(entry);
+			}
+			::munmap(mapped, size);
+			i = j;
+		}
+		if (fd >= 0)
+			::close(fd);
+	}
+	return found;
+}
+
+long JournalQuery::GetMappedBytes() const
+{
+	return mappedBytes;
+}
+
+long JournalQuery::GetScannedRecords() const
+{
+	return scannedRecords;
+}
+
+JournaledHistoricalData::JournaledHistoricalData() :
+	journal(nullptr)
+{
+}
+
+void JournaledHistoricalData::SetJournal(JournalWriter* _journal)
+{
+	journal = _journal;
+}
+
+template <typename R>
+std::vector<JournalEntry<R>> JournaledHistoricalData::Query(JournalRecordType type, ProductHandle handle,
+	const std::string &productId, std::int64_t from, std::int64_t to) const
+{
+	if (journal == nullptr)
+	{
+		std::cout << "Oh no! No journal to query!\n";
+		return std::vector<JournalEntry<R>>();
+	}
+	journal->Flush(); // the records persisted so far, and their index
+	JournalQuery query(journal->GetBasePath());
+	return query.Find<R>(type, handle, productId, from, to);
+}
+
+#endif // !JournalQuery_hpp
@@ -0,0 +1,314 @@
+// OrderBookUpdate.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the incremental (L2) market data:
+// a market data update carries the add, modify and delete messages of the price levels of one product on one venue,
+// and an order book delta the levels actually changed in the venue book, with whether the top of the
+// consolidated book moved and the venues quoting at its best prices
+
+#ifndef OrderBookUpdate_hpp
+#define OrderBookUpdate_hpp
+
+#include "marketdataservice.hpp"
+#include "FixedDepthOrderBook.hpp"
+#include "ConsolidatedOrderBook.hpp"
+#include "TickPrice.hpp"
+
+// Maximum # of price level messages in one update
+// (enough to replace both sides of a book of depth 5: delete and re-add every level)
+const int MAX_LEVEL_UPDATES = 32;
+
+// Action on a price level
+enum PriceLevelAction { ADD_LEVEL, MODIFY_LEVEL, DELETE_LEVEL };
+
+// A message on one price level
+class PriceLevelUpdate
+{
+private:
+	PriceLevelAction action;
+	PricingSide side;
+	TickPrice price;
+	long quantity; // quantity added (ADD_LEVEL) or new quantity of the level (MODIFY_LEVEL)
+	int level; // level in the book once applied (-1 if not applied yet)
+
+public:
+	PriceLevelUpdate() {} // empty ctor
+	PriceLevelUpdate(PriceLevelAction _action, PricingSide _side, TickPrice _price, long _quantity, int _level = -1); // ctor
+
+	// Get the action on the level
+	PriceLevelAction GetAction() const;
+
+	// Get the side of the level
+	PricingSide GetSide() const;
+
+	// Get the price of the level
+	TickPrice GetPrice() const;
+
+	// Get the quantity of the message
+	long GetQuantity() const;
+
+	// Get the level in the book once applied (0 is the best, -1 if not applied)
+	int GetLevel() const;
+};
+
+// Incremental market data of one product on one venue: a list of price level messages applied at once
+// The messages are stored inline, so the update is copied without allocation
+// Type T is the product type
+template <typename T>
+class MarketDataUpdate
+{
+protected:
+	const T* product; // the product (owned by the product service, not copied)
+	Market venue;
+	PriceLevelUpdate levels[MAX_LEVEL_UPDATES];
+	int size; // # of messages
+
+public:
+	MarketDataUpdate(); // empty ctor
+	MarketDataUpdate(const T* _product, Market _venue = BROKERTEC); // ctor
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the venue
+	Market GetVenue() const;
+
+	// Remove all the messages and set the product and the venue
+	void Reset(const T* _product, Market _venue = BROKERTEC);
+
+	// Append a message, return false if the update is full
+	bool AddLevelUpdate(const PriceLevelUpdate &levelUpdate);
+
+	// Get the # of messages
+	int GetSize() const;
+
+	// Get the i-th message
+	const PriceLevelUpdate& GetLevelUpdate(int i) const;
+};
+
+// Change of an order book after a market data update:
+// the messages actually applied (with their level in the venue book), and the top of the consolidated book afterwards
+// Type T is the product type
+template <typename T>
+class OrderBookDelta : public MarketDataUpdate<T>
+{
+protected:
+	bool topOfBookChanged; // whether the best bid/offer (price or quantity) moved
+	BidOffer bestBidOffer;
+	long bestVenueQuantities[2][NUM_MARKETS]; // quantity of each venue at the best bid/offer
+
+public:
+	OrderBookDelta(); // empty ctor
+
+	// Whether the best bid/offer moved
+	bool IsTopOfBookChanged() const;
+
+	// Set whether the best bid/offer moved
+	void SetTopOfBookChanged(bool _topOfBookChanged);
+
+	// Get the best bid/offer after the update
+	const BidOffer& GetBestBidOffer() const;
+
+	// Set the best bid/offer after the update
+	void SetBestBidOffer(const BidOffer &_bestBidOffer);
+
+	// Get the quantity of a venue at the best price of a side after the update
+	long GetBestVenueQuantity(PricingSide side, Market venue) const;
+
+	// Set the quantity of a venue at the best price of a side after the update
+	void SetBestVenueQuantity(PricingSide side, Market venue, long quantity);
+};
+
+// Append to update the price level messages turning book before into book after
+// (the deletes first, then the modifies and the adds, so that no add falls off a full book)
+// return false if the update is full
+template <typename T, int DEPTH>
+bool MakeLevelUpdates(const FixedDepthOrderBook<T, DEPTH> &before, const FixedDepthOrderBook<T, DEPTH> &after,
+	MarketDataUpdate<T> &update);
+
+// Apply the price level messages of an update to a book, in order (as the market data service does to its venue book)
+template <typename T, int DEPTH>
+void ApplyLevelUpdates(FixedDepthOrderBook<T, DEPTH> &book, const MarketDataUpdate<T> &update);
+
+PriceLevelUpdate::PriceLevelUpdate(PriceLevelAction _action, PricingSide _side, TickPrice _price, long _quantity, int _level) :
+	action(_action), side(_side), price(_price), quantity(_quantity), level(_level)
+{
+}
+
+PriceLevelAction PriceLevelUpdate::GetAction() const
+{
+	return action;
+}
+
+PricingSide PriceLevelUpdate::GetSide() const
+{
+	return side;
+}
+
+TickPrice PriceLevelUpdate::GetPrice() const
+{
+	return price;
+}
+
+long PriceLevelUpdate::GetQuantity() const
+{
+	return quantity;
+}
+
+int PriceLevelUpdate::GetLevel() const
+{
+	return level;
+}
+
+template <typename T>
+MarketDataUpdate<T>::MarketDataUpdate() : product(nullptr), venue(BROKERTEC), size(0)
+{
+}
+
+template <typename T>
+MarketDataUpdate<T>::MarketDataUpdate(const T* _product, Market _venue) : product(_product), venue(_venue), size(0)
+{
+}
+
+template <typename T>
+const T& MarketDataUpdate<T>::GetProduct() const
+{
+	return *product;
+}
+
+template <typename T>
+Market MarketDataUpdate<T>::GetVenue() const
+{
+	return venue;
+}
+
+template <typename T>
+void MarketDataUpdate<T>::Reset(const T* _product, Market _venue)
+{
+	product = _product;
+	venue = _venue;
+	size = 0;
+}
+
+template <typename T>
+bool MarketDataUpdate<T>::AddLevelUpdate(const PriceLevelUpdate &levelUpdate)
+{
+	if (size == MAX_LEVEL_UPDATES)
+		return false;
+	levels[size++] = levelUpdate;
+	return true;
+}
+
+template <typename T>
+int MarketDataUpdate<T>::GetSize() const
+{
+	return size;
+}
+
+template <typename T>
+const PriceLevelUpdate& MarketDataUpdate<T>::GetLevelUpdate(int i) const
+{
+	return levels[i];
+}
+
+template <typename T>
+OrderBookDelta<T>::OrderBookDelta() : topOfBookChanged(false)
+{
+	for (int k = 0; k < NUM_MARKETS; k++)
+	{
+		bestVenueQuantities[BID][k] = 0;
+		bestVenueQuantities[OFFER][k] = 0;
+	}
+}
+
+template <typename T>
+bool OrderBookDelta<T>::IsTopOfBookChanged() const
+{
+	return topOfBookChanged;
+}
+
+template <typename T>
+void OrderBookDelta<T>::SetTopOfBookChanged(bool _topOfBookChanged)
+{
+	topOfBookChanged = _topOfBookChanged;
+}
+
+template <typename T>
+const BidOffer& OrderBookDelta<T>::GetBestBidOffer() const
+{
+	return bestBidOffer;
+}
+
+template <typename T>
+void OrderBookDelta<T>::SetBestBidOffer(const BidOffer &_bestBidOffer)
+{
+	bestBidOffer = _bestBidOffer;
+}
+
+template <typename T>
+long OrderBookDelta<T>::GetBestVenueQuantity(PricingSide side, Market venue) const
+{
+	return bestVenueQuantities[side][venue];
+}
+
+template <typename T>
+void OrderBookDelta<T>::SetBestVenueQuantity(PricingSide side, Market venue, long quantity)
+{
+	bestVenueQuantities[side][venue] = quantity;
+}
+
+template <typename T, int DEPTH>
+bool MakeLevelUpdates(const FixedDepthOrderBook<T, DEPTH> &before, const FixedDepthOrderBook<T, DEPTH> &after,
+	MarketDataUpdate<T> &update)
+{
+	bool full = false;
+	PricingSide sides[2] = { BID, OFFER };
+	for (PricingSide side : sides)
+	{
+		// the levels gone
+		for (int i = 0; i < before.GetDepth(side); i++)
+		{
+			TickPrice price = before.GetPrice(side, i);
+			bool found = false;
+			for (int j = 0; j < after.GetDepth(side) && !found; j++)
+				found = (after.GetPrice(side, j) == price);
+			if (!found)
+				full |= !update.AddLevelUpdate(PriceLevelUpdate(DELETE_LEVEL, side, price, 0));
+		}
+	}
+	for (PricingSide side : sides)
+	{
+		// the levels changed or new
+		for (int j = 0; j < after.GetDepth(side); j++)
+		{
+			TickPrice price = after.GetPrice(side, j);
+			long quantity = after.GetQuantity(side, j);
+			int i = 0;
+			while (i < before.GetDepth(side) && before.GetPrice(side, i) != price)
+				i++;
+			if (i == before.GetDepth(side))
+				full |= !update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, side, price, quantity));
+			else if (before.GetQuantity(side, i) != quantity)
+				full |= !update.AddLevelUpdate(PriceLevelUpdate(MODIFY_LEVEL, side, price, quantity));
+		}
+	}
+	return !full;
+}
+
+template <typename T, int DEPTH>
+void ApplyLevelUpdates(FixedDepthOrderBook<T, DEPTH> &book, const MarketDataUpdate<T> &update)
+{
+	for (int i = 0; i < update.GetSize(); i++)
+	{
+		const PriceLevelUpdate &levelUpdate = update.GetLevelUpdate(i);
+		if (levelUpdate.GetAction() == ADD_LEVEL)
+			book.AddLevel(levelUpdate.GetSide(), levelUpdate.GetPrice(), levelUpdate.GetQuantity());
+		else if (levelUpdate.GetAction() == MODIFY_LEVEL)
+			book.ModifyLevel(levelUpdate.GetSide(), levelUpdate.GetPrice(), levelUpdate.GetQuantity());
+		else if (levelUpdate.GetAction() == DELETE_LEVEL)
+			book.DeleteLevel(levelUpdate.GetSide(), levelUpdate.GetPrice());
+	}
+}
+
+#endif // !OrderBookUpdate_hpp
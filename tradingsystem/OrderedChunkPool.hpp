@@ -0,0 +1,152 @@
+// OrderedChunkPool.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the ordered chunk pool shared by the parallel csv reader and the parallel file generator:
+// the chunks of a job are produced on a pool of threads, at most a window of them ahead of the consumer,
+// and the results are handed over to the consumer on the calling thread in chunk order
+
+#ifndef OrderedChunkPool_hpp
+#define OrderedChunkPool_hpp
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Ordered chunk pool
+// Type T is the result of a chunk (a container, such as the parsed records or the formatted rows, cleared before re-use)
+template <typename T>
+class OrderedChunkPool
+{
+public:
+	// Produce the result of a chunk, called on the threads of the pool
+	typedef std::function<void(std::size_t chunk, T &result)> ChunkProducer;
+
+	// Take the result of a chunk, called on the thread of Run() in chunk order
+	typedef std::function<void(T &result)> ChunkConsumer;
+
+protected:
+	std::size_t threads; // # of threads of the pool
+	std::size_t window; // # of chunks produced ahead of the consumer at most
+
+	// state shared with the pool
+	std::mutex mutex;
+	std::condition_variable producedCondition; // a chunk is produced
+	std::condition_variable consumedCondition; // a chunk is consumed
+	std::vector<T> results; // result of each chunk
+	std::vector<bool> produced; // whether each chunk is produced
+	std::size_t chunks; // # of chunks of the job
+	std::size_t nextChunk; // next chunk to produce
+	std::size_t consumedChunks; // # of chunks consumed
+
+	// Produce the chunks on a thread of the pool
+	void Work(const ChunkProducer &produce);
+
+public:
+	// ctor (0 threads for one per core; at most window chunks are produced ahead, 0 for twice the # of threads)
+	OrderedChunkPool(std::size_t _threads = 0, std::size_t _window = 0);
+
+	// Produce the chunks [0, _chunks) and hand over their results in chunk order
+	// (with one thread or one chunk, each chunk is produced and handed over on the calling thread, re-using one result)
+	void Run(std::size_t _chunks, const ChunkProducer &produce, const ChunkConsumer &consume);
+
+	// Get the number of threads of the pool
+	std::size_t GetThreadCount() const;
+};
+
+template <typename T>
+OrderedChunkPool<T>::OrderedChunkPool(std::size_t _threads, std::size_t _window) :
+	threads(_threads), window(_window), chunks(0), nextChunk(0), consumedChunks(0)
+{
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	if (window == 0)
+		window = 2 * threads;
+}
+
+template <typename T>
+void OrderedChunkPool<T>::Work(const ChunkProducer &produce)
+{
+	while (true)
+	{
+		std::size_t chunk;
+		{
+			// take the next chunk, unless the consumer is too far behind
+			std::unique_lock<std::mutex> lock(mutex);
+			consumedCondition.wait(lock, [this]() { return nextChunk >= chunks || nextChunk < consumedChunks + window; });
+			if (nextChunk >= chunks)
+				return;
+			chunk = nextChunk++;
+		}
+
+		T result;
+		produce(chunk, result);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			results[chunk].swap(result);
+			produced[chunk] = true;
+		}
+		producedCondition.notify_all();
+	}
+}
+
+template <typename T>
+void OrderedChunkPool<T>::Run(std::size_t _chunks, const ChunkProducer &produce, const ChunkConsumer &consume)
+{
+	if (threads <= 1 || _chunks <= 1) // no pool: produce and hand over each chunk in turn
+	{
+		T result; // re-used
+		for (std::size_t chunk = 0; chunk < _chunks; chunk++)
+		{
+			result.clear();
+			produce(chunk, result);
+			consume(result);
+		}
+		return;
+	}
+
+	chunks = _chunks;
+	results.assign(chunks, T());
+	produced.assign(chunks, false);
+	nextChunk = 0;
+	consumedChunks = 0;
+	std::vector<std::thread> pool;
+	for (std::size_t i = 0; i < threads; i++)
+		pool.push_back(std::thread(&OrderedChunkPool<T>::Work, this, std::cref(produce)));
+
+	// re-sequence: hand over the chunks in order as soon as each one is produced
+	for (std::size_t chunk = 0; chunk < chunks; chunk++)
+	{
+		T result;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			producedCondition.wait(lock, [this, chunk]() { return produced[chunk]; });
+			result.swap(results[chunk]);
+		}
+		consume(result);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			consumedChunks++;
+		}
+		consumedCondition.notify_all();
+	}
+
+	for (auto &worker : pool)
+		worker.join();
+	results.clear();
+	produced.clear();
+}
+
+template <typename T>
+std::size_t OrderedChunkPool<T>::GetThreadCount() const
+{
+	return threads;
+}
+
+#endif // !OrderedChunkPool_hpp
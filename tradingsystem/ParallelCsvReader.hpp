@@ -0,0 +1,150 @@
+// ParallelCsvReader.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the parallel reader of the large input csv files of the subscribe connectors:
+// the mapped file is split into newline-aligned chunks, the rows of each chunk are parsed on a pool of threads
+// (see OrderedChunkPool.hpp), and the parsed records are handed over to the connector chunk by chunk in file order,
+// so each product's updates still reach the service in the order of the file
+
+#ifndef ParallelCsvReader_hpp
+#define ParallelCsvReader_hpp
+
+#include "CsvReader.hpp"
+#include "OrderedChunkPool.hpp"
+#include "StopWatch.hpp"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <cstddef>
+#include <cstring>
+
+// Parallel reader of a csv file
+// Type R is the parsed record type
+template <typename R>
+class ParallelCsvReader
+{
+public:
+	// Parse the rows of a chunk (through its own reader) into records, called on the threads of the pool
+	typedef std::function<void(CsvReader &reader, std::vector<R> &records)> ChunkParser;
+
+	// Take the records of a chunk, called on the thread of Run() in file order
+	typedef std::function<void(std::vector<R> &records)> ChunkConsumer;
+
+protected:
+	CsvReader file; // the mapped file
+	std::vector<const char*> chunks; // chunk i is [chunks[i], chunks[i + 1])
+	OrderedChunkPool<std::vector<R>> pool; // parses the chunks
+	std::atomic<long> rows; // # of rows parsed
+	StopWatch sw;
+
+	// Parse a chunk into its results, return the # of rows
+	long ParseChunk(std::size_t chunk, const ChunkParser &parse, std::vector<R> &records);
+
+public:
+	// ctor, maps the file (without its header) and splits it into chunks of about chunkBytes
+	// (0 threads for one per core; at most window chunks are parsed ahead, 0 for twice the # of threads)
+	ParallelCsvReader(const std::string &path, std::size_t _threads = 0, std::size_t chunkBytes = 4 << 20,
+		std::size_t _window = 0);
+
+	// Whether the file is open
+	bool IsOpen() const;
+
+	// Parse all the chunks and hand over their records in file order
+	// (with one thread, each chunk is parsed and handed over on the calling thread)
+	void Run(const ChunkParser &parse, const ChunkConsumer &consume);
+
+	// Get the number of rows parsed (header excluded)
+	long GetRowCount() const;
+
+	// Get the number of chunks of the file
+	std::size_t GetChunkCount() const;
+
+	// Get the number of threads of the pool
+	std::size_t GetThreadCount() const;
+
+	// Print the read throughput (MB/s and rows/s) of Run()
+	void Report(std::ostream &out, const std::string &name) const;
+};
+
+template <typename R>
+ParallelCsvReader<R>::ParallelCsvReader(const std::string &path, std::size_t _threads, std::size_t chunkBytes,
+	std::size_t _window) :
+	file(path), pool(_threads, _window), rows(0)
+{
+	if (chunkBytes == 0)
+		chunkBytes = 1;
+
+	// newline-aligned chunks of the rows after the header
+	const char* first;
+	const char* last;
+	file.GetRemaining(first, last);
+	while (first != nullptr && first != last)
+	{
+		chunks.push_back(first);
+		if (static_cast<std::size_t>(last - first) <= chunkBytes)
+		{
+			first = last;
+			break;
+		}
+		const char* eol = static_cast<const char*>(std::memchr(first + chunkBytes, '\n', last - first - chunkBytes));
+		first = (eol == nullptr) ? last : eol + 1;
+	}
+	chunks.push_back(first);
+}
+
+template <typename R>
+bool ParallelCsvReader<R>::IsOpen() const
+{
+	return file.IsOpen();
+}
+
+template <typename R>
+long ParallelCsvReader<R>::ParseChunk(std::size_t chunk, const ChunkParser &parse, std::vector<R> &records)
+{
+	CsvReader reader(chunks[chunk], chunks[chunk + 1], ',');
+	parse(reader, records);
+	return reader.GetRowCount();
+}
+
+template <typename R>
+void ParallelCsvReader<R>::Run(const ChunkParser &parse, const ChunkConsumer &consume)
+{
+	sw.Reset();
+	sw.StartStopWatch();
+	pool.Run(chunks.size() - 1, [this, &parse](std::size_t chunk, std::vector<R> &records) {
+		rows.fetch_add(ParseChunk(chunk, parse, records), std::memory_order_relaxed); }, consume);
+	sw.StopStopWatch();
+}
+
+template <typename R>
+long ParallelCsvReader<R>::GetRowCount() const
+{
+	return rows.load(std::memory_order_relaxed);
+}
+
+template <typename R>
+std::size_t ParallelCsvReader<R>::GetChunkCount() const
+{
+	return chunks.size() - 1;
+}
+
+template <typename R>
+std::size_t ParallelCsvReader<R>::GetThreadCount() const
+{
+	return pool.GetThreadCount();
+}
+
+template <typename R>
+void ParallelCsvReader<R>::Report(std::ostream &out, const std::string &name) const
+{
+	double seconds = sw.GetTime();
+	double megabytes = file.GetBytes() / (1024.0 * 1024.0);
+	out << name << ": parsed " << rows << " rows (" << megabytes << " MB) in " << chunks.size() - 1 << " chunks on "
+		<< GetThreadCount() << " threads in " << seconds << " seconds (" << ((seconds > 0) ? megabytes / seconds : 0.0)
+		<< " MB/s, " << static_cast<long>((seconds > 0) ? rows / seconds : 0.0) << " rows/s)\n";
+}
+
+#endif // !ParallelCsvReader_hpp
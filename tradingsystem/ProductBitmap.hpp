@@ -0,0 +1,153 @@
+// ProductBitmap.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the bitmap of a selection of products stored densely (bit i for the product at position i),
+// the per-attribute indexes of a product service: a query on several attributes is a bitwise AND/OR of their bitmaps,
+// and the # of products selected is counted by popcount before they are copied out
+
+#ifndef ProductBitmap_hpp
+#define ProductBitmap_hpp
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Bitmap over the positions of the products of a dense array
+// The bits past the size of a bitmap are clear (a bitmap grows as the products are added)
+class ProductBitmap
+{
+protected:
+	std::vector<std::uint64_t> words; // bit i is bit i % 64 of word i / 64
+
+	// Get the # of bits set in a word
+	static int PopCount(std::uint64_t word);
+
+	// Get the position of the lowest bit set in a non-zero word
+	static int LowestBit(std::uint64_t word);
+
+public:
+	ProductBitmap() {} // empty bitmap
+
+	// Set the bit of a position
+	void Set(std::size_t position);
+
+	// Whether the bit of a position is set
+	bool Test(std::size_t position) const;
+
+	// Get the # of bits set
+	std::size_t Count() const;
+
+	// Keep the bits set in both bitmaps
+	ProductBitmap& operator&=(const ProductBitmap &other);
+
+	// Keep the bits set in either bitmap
+	ProductBitmap& operator|=(const ProductBitmap &other);
+
+	// Clear the bits set in the other bitmap
+	ProductBitmap& Subtract(const ProductBitmap &other);
+
+	// Call f(position) for each bit set, in increasing order
+	template <typename F>
+	void ForEach(F f) const;
+};
+
+// Bits set in both bitmaps
+ProductBitmap operator&(ProductBitmap left, const ProductBitmap &right);
+
+// Bits set in either bitmap
+ProductBitmap operator|(ProductBitmap left, const ProductBitmap &right);
+
+int ProductBitmap::PopCount(std::uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+int ProductBitmap::LowestBit(std::uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(word);
+#else
+	return PopCount((word & (~word + 1)) - 1); // the bits below the lowest bit set
+#endif
+}
+
+void ProductBitmap::Set(std::size_t position)
+{
+	if (position / 64 >= words.size())
+		words.resize(position / 64 + 1, 0);
+	words[position / 64] |= std::uint64_t(1) << (position % 64);
+}
+
+bool ProductBitmap::Test(std::size_t position) const
+{
+	return position / 64 < words.size() && ((words[position / 64] >> (position % 64)) & 1);
+}
+
+std::size_t ProductBitmap::Count() const
+{
+	std::size_t count = 0;
+	for (std::uint64_t word : words)
+		count += PopCount(word);
+	return count;
+}
+
+ProductBitmap& ProductBitmap::operator&=(const ProductBitmap &other)
+{
+	if (words.size() > other.words.size())
+		words.resize(other.words.size());
+	for (std::size_t i = 0; i < words.size(); i++)
+		words[i] &= other.words[i];
+	return *this;
+}
+
+ProductBitmap& ProductBitmap::operator|=(const ProductBitmap &other)
+{
+	if (words.size() < other.words.size())
+		words.resize(other.words.size(), 0);
+	for (std::size_t i = 0; i < other.words.size(); i++)
+		words[i] |= other.words[i];
+	return *this;
+}
+
+ProductBitmap& ProductBitmap::Subtract(const ProductBitmap &other)
+{
+	std::size_t n = std::min(words.size(), other.words.size());
+	for (std::size_t i = 0; i < n; i++)
+		words[i] &= ~other.words[i];
+	return *this;
+}
+
+template <typename F>
+void ProductBitmap::ForEach(F f) const
+{
+	for (std::size_t i = 0; i < words.size(); i++)
+	{
+		std::uint64_t word = words[i];
+		while (word != 0)
+		{
+			f(i * 64 + LowestBit(word));
+			word &= word - 1; // clear the lowest bit set
+		}
+	}
+}
+
+ProductBitmap operator&(ProductBitmap left, const ProductBitmap &right)
+{
+	return left &= right;
+}
+
+ProductBitmap operator|(ProductBitmap left, const ProductBitmap &right)
+{
+	return left |= right;
+}
+
+#endif // !ProductBitmap_hpp
@@ -0,0 +1,189 @@
+// ProductHandleMap.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the per-product state store of a service:
+// a flat array indexed by the dense product handle assigned by the product service,
+// with the product identifier only looked up at the edge (GetData() of the services)
+
+#ifndef ProductHandleMap_hpp
+#define ProductHandleMap_hpp
+
+#include "products.hpp"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <stdexcept>
+#include <cstddef>
+
+// Flat map from product handle to the state of the product
+// Products without a handle (not registered in the product service) are kept apart, keyed on their identifier
+// Once bound to the product service (see Bind()), the array holds a slot for each registered product: it does not grow,
+// so the references to the states stay valid, and an identifier is resolved to its handle through the product service
+// An unbound map grows the array at the first access of a new handle (the references returned before are then invalid),
+// and an identifier looked up before its product was first accessed gets a state of its own apart from the array
+// Type V is the state type (default-constructed on first access, as with operator[] of a map)
+template <typename V>
+class ProductHandleMap
+{
+protected:
+	std::vector<V> values; // slot i holds the state of the product with handle i
+	std::vector<bool> present; // whether slot i has been accessed through a product
+	std::unordered_map<std::string, ProductHandle> handles; // product identifier -> handle, for the edge lookups of an unbound map
+	std::unordered_map<std::string, V> unregistered; // product identifier -> state, for the products without a handle
+	std::function<ProductHandle(const std::string&)> resolve; // product identifier -> handle, through the product service once bound
+
+	// Get the state of the product with a handle, creating it if absent
+	V& Access(ProductHandle handle, const std::string &productId);
+
+public:
+	ProductHandleMap() {} // empty ctor
+
+	// Bind the map to a product service (nothing if nullptr): a slot for each product registered so far,
+	// and the identifiers resolved through the handles of the product service
+	// Type S is the product service type (with GetSize() and GetHandle(productId) functions)
+	template <typename S>
+	void Bind(S* productService);
+
+	// Get the state of a product, creating it if absent
+	V& operator[](const Product &product);
+
+	// Get the state of a product by its identifier, creating it if absent
+	V& operator[](const std::string &productId);
+
+	// Get the state of a product, throw std::out_of_range if absent
+	V& At(const Product &product);
+
+	// Get the state of a product by its identifier, throw std::out_of_range if absent
+	V& At(const std::string &productId);
+
+	// Whether the state of a product is present
+	bool Contains(const Product &product) const;
+
+	// Get the number of slots (one past the largest handle seen)
+	std::size_t Size() const;
+
+	// Call f on the state of each product present, in the order of the handles (the products without a handle are not visited)
+	template <typename F>
+	void ForEach(F f);
+};
+
+template <typename V>
+template <typename S>
+void ProductHandleMap<V>::Bind(S* productService)
+{
+	if (productService == nullptr)
+		return;
+	std::size_t size = productService->GetSize();
+	if (values.size() < size)
+	{
+		values.resize(size);
+		present.resize(size, false);
+	}
+	resolve = [productService](const std::string &productId) { return productService->GetHandle(productId); };
+}
+
+template <typename V>
+V& ProductHandleMap<V>::Access(ProductHandle handle, const std::string &productId)
+{
+	std::size_t index = static_cast<std::size_t>(handle);
+	if (index >= values.size()) // a product registered after the binding, or an unbound map
+	{
+		values.resize(index + 1);
+		present.resize(index + 1, false);
+	}
+	if (!present[index])
+	{
+		present[index] = true;
+		if (!resolve)
+			handles[productId] = handle;
+	}
+	return values[index];
+}
+
+template <typename V>
+V& ProductHandleMap<V>::operator[](const Product &product)
+{
+	ProductHandle handle = product.GetHandle();
+	if (handle < 0)
+		return unregistered[product.GetProductId()];
+	if (static_cast<std::size_t>(handle) < values.size() && present[handle]) // the hot path
+		return values[handle];
+	return Access(handle, product.GetProductId());
+}
+
+template <typename V>
+V& ProductHandleMap<V>::operator[](const std::string &productId)
+{
+	if (resolve)
+	{
+		ProductHandle handle = resolve(productId);
+		if (handle >= 0)
+			return Access(handle, productId);
+		return unregistered[productId];
+	}
+	auto iter = handles.find(productId);
+	if (iter == handles.end())
+		return unregistered[productId];
+	return values[iter->second];
+}
+
+template <typename V>
+V& ProductHandleMap<V>::At(const Product &product)
+{
+	if (product.GetHandle() < 0)
+		return At(std::string(product.GetProductId()));
+	if (!Contains(product))
+		throw std::out_of_range("ProductHandleMap::At: " + product.GetProductId());
+	return values[product.GetHandle()];
+}
+
+template <typename V>
+V& ProductHandleMap<V>::At(const std::string &productId)
+{
+	if (resolve)
+	{
+		ProductHandle handle = resolve(productId);
+		if (handle >= 0 && static_cast<std::size_t>(handle) < present.size() && present[handle])
+			return values[handle];
+	}
+	else
+	{
+		auto iter = handles.find(productId);
+		if (iter != handles.end())
+			return values[iter->second];
+	}
+	auto other = unregistered.find(productId);
+	if (other == unregistered.end())
+		throw std::out_of_range("ProductHandleMap::At: " + productId);
+	return other->second;
+}
+
+template <typename V>
+bool ProductHandleMap<V>::Contains(const Product &product) const
+{
+	ProductHandle handle = product.GetHandle();
+	if (handle < 0)
+		return unregistered.find(product.GetProductId()) != unregistered.end();
+	return static_cast<std::size_t>(handle) < present.size() && present[handle];
+}
+
+template <typename V>
+std::size_t ProductHandleMap<V>::Size() const
+{
+	return values.size();
+}
+
+template <typename V>
+template <typename F>
+void ProductHandleMap<V>::ForEach(F f)
+{
+	for (std::size_t i = 0; i < values.size(); i++)
+	{
+		if (present[i])
+			f(values[i]);
+	}
+}
+
+#endif // !ProductHandleMap_hpp
@@ -0,0 +1,135 @@
+// RecordPipe.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the in-memory pipe from a data generator to a subscribe connector:
+// the generator hands over chunks of typed records through a bounded queue and the connector takes them in order,
+// so the service graph can be fed without writing, reading and parsing the input files
+
+#ifndef RecordPipe_hpp
+#define RecordPipe_hpp
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Bounded queue of chunks of records, with one producer and one consumer
+// The producer blocks while the pipe is full and not closed, the consumer while it is empty and not closed
+// The consumer closes the pipe if it stops taking the chunks (see RecordPipeCloser), so the producer never waits for it
+// Type R is the record type
+template <typename R>
+class RecordPipe
+{
+protected:
+	std::deque<std::vector<R>> chunks; // the chunks handed over and not taken yet
+	std::size_t capacity; // # of chunks in the pipe at most
+	std::size_t chunkSize; // # of records of a chunk (suggested to the producer)
+	bool closed; // whether the producer is done, or the consumer stopped
+	long records; // # of records handed over
+	std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+
+public:
+	RecordPipe(std::size_t _chunkSize = 1024, std::size_t _capacity = 64); // ctor
+
+	// Get the # of records of a chunk the producer should hand over at once
+	std::size_t GetChunkSize() const;
+
+	// Hand over a chunk of records (producer only), the chunk is left empty
+	// Return false if the pipe is closed (the chunk is dropped): the producer should stop
+	bool Push(std::vector<R> &chunk);
+
+	// Close the pipe, by the producer once all the chunks are handed over or by the consumer to stop taking them
+	void Close();
+
+	// Take the next chunk of records (consumer only), return false once the pipe is closed and empty
+	bool Pop(std::vector<R> &chunk);
+
+	// Get the # of records handed over
+	long GetRecordCount();
+};
+
+// Closes a pipe when its consumer leaves the scope, even on an early exit
+template <typename R>
+class RecordPipeCloser
+{
+protected:
+	RecordPipe<R>* pipe;
+
+public:
+	explicit RecordPipeCloser(RecordPipe<R>* _pipe) : pipe(_pipe) {} // ctor
+	~RecordPipeCloser() { pipe->Close(); } // dtor, closes the pipe
+};
+
+template <typename R>
+RecordPipe<R>::RecordPipe(std::size_t _chunkSize, std::size_t _capacity) :
+	capacity(_capacity), chunkSize(_chunkSize), closed(false), records(0)
+{
+	if (capacity == 0) capacity = 1;
+	if (chunkSize == 0) chunkSize = 1;
+}
+
+template <typename R>
+std::size_t RecordPipe<R>::GetChunkSize() const
+{
+	return chunkSize;
+}
+
+template <typename R>
+bool RecordPipe<R>::Push(std::vector<R> &chunk)
+{
+	if (chunk.empty())
+		return true;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this]() { return chunks.size() < capacity || closed; });
+		if (closed)
+		{
+			chunk.clear();
+			return false;
+		}
+		records += static_cast<long>(chunk.size());
+		chunks.push_back(std::vector<R>());
+		chunks.back().swap(chunk);
+	}
+	notEmpty.notify_one();
+	return true;
+}
+
+template <typename R>
+void RecordPipe<R>::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+	}
+	notEmpty.notify_one();
+	notFull.notify_one();
+}
+
+template <typename R>
+bool RecordPipe<R>::Pop(std::vector<R> &chunk)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this]() { return !chunks.empty() || closed; });
+		if (chunks.empty())
+			return false;
+		chunk.swap(chunks.front());
+		chunks.pop_front();
+	}
+	notFull.notify_one();
+	return true;
+}
+
+template <typename R>
+long RecordPipe<R>::GetRecordCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return records;
+}
+
+#endif // !RecordPipe_hpp
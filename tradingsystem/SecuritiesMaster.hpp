@@ -0,0 +1,364 @@
+// SecuritiesMaster.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the securities master: the reference data of the bonds (identifier, type, ticker, coupon, maturity)
+// with the PV01 and the bucketed sector of each bond, loaded at start-up from a csv file
+// (BondID,BondIDType,Ticker,Coupon,Maturity,PV01,Bucket with the maturity as mm/dd/yyyy and an empty bucket for none)
+// The file is memory-mapped and parsed in place into fixed-layout records, then cached next to it as a binary image
+// (path + ".bin") which is mapped as is on the next start-up as long as the file is unchanged
+
+#ifndef SecuritiesMaster_hpp
+#define SecuritiesMaster_hpp
+
+#include "CsvReader.hpp"
+#include "StopWatch.hpp"
+#include "products.hpp"
+#include "productservice.hpp"
+#include "boost/utility/string_view.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <iostream>
+#include <fcntl.h> // the following are Unix only
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "BSMI", the first bytes of a binary image of a securities master
+const std::uint32_t SECURITIES_MASTER_MAGIC = 0x494D5342;
+const std::uint16_t SECURITIES_MASTER_VERSION = 2;
+
+// # of bytes of the identifier, the ticker and the bucketed sector of a record (zero padded)
+const std::size_t SECURITIES_MASTER_FIELD_LENGTH = 16;
+
+// Header of a binary image, identifying the csv file it was built from
+struct SecuritiesMasterHeader
+{
+	std::uint32_t magic;
+	std::uint16_t version;
+	std::uint16_t length; // # of bytes of each record
+	std::uint64_t records; // # of records
+	std::int64_t sourceBytes; // size of the csv file
+	std::int64_t sourceModified; // last modification of the csv file (nanoseconds since the epoch)
+};
+
+// Reference data of a bond, as stored in a binary image
+struct SecuritiesMasterRecord
+{
+	char productId[SECURITIES_MASTER_FIELD_LENGTH];
+	char ticker[SECURITIES_MASTER_FIELD_LENGTH];
+	char bucket[SECURITIES_MASTER_FIELD_LENGTH]; // empty if the bond is in no bucketed sector
+	std::int32_t bondIdType; // a BondIdType
+	float coupon;
+	std::int32_t maturity; // day number of the maturity date
+	std::int32_t padding;
+	double pv01;
+};
+
+// Securities master loaded from a csv file or from its binary image
+class SecuritiesMaster
+{
+protected:
+	std::vector<SecuritiesMasterRecord> records;
+	bool fromImage; // whether the records were loaded from the binary image
+	StopWatch sw;
+
+	// Copy a field into a zero-padded fixed-width field, return false if it is too long
+	static bool CopyField(char* output, const boost::string_view &field);
+
+	// Get a fixed-width field as a string
+	static std::string GetField(const char* field);
+
+	// Parse a decimal field (without allocating), return false if malformed
+	static bool ParseDecimal(const boost::string_view &field, double &value);
+
+	// Parse a mm/dd/yyyy date into its day number, return false if malformed
+	static bool ParseDate(const boost::string_view &field, std::int32_t &dayNumber);
+
+	// Parse the csv file into the records, return false if it cannot be opened
+	bool Parse(const std::string &path);
+
+	// Load the binary image of the csv file, return false if there is none or it does not match the file
+	bool LoadImage(const std::string &imagePath, const struct stat &source);
+
+	// Write the binary image of the csv file (to a temporary file renamed over the previous image)
+	void SaveImage(const std::string &imagePath, const struct stat &source) const;
+
+	// Get the last modification of a file in nanoseconds since the epoch
+	static std::int64_t GetModified(const struct stat &info);
+
+public:
+	SecuritiesMaster(); // ctor
+
+	// Load the securities master of a csv file, from its binary image if useImage and it matches the file
+	// (the image is then written if it does not), return false if the file cannot be opened
+	bool Load(const std::string &path, bool useImage = true);
+
+	// Get the # of bonds
+	std::size_t GetSize() const;
+
+	// Get the records of the bonds, in the order of the file
+	const std::vector<SecuritiesMasterRecord>& GetRecords() const;
+
+	// Get the bond of a record
+	static Bond MakeBond(const SecuritiesMasterRecord &record);
+
+	// Register the bonds to a bond product service, in the order of the file
+	void AddBonds(BondProductService &bondProductService) const;
+
+	// Get the PV01 of each bond
+	std::unordered_map<std::string, double> GetPV01s() const;
+
+	// Get the bonds of each bucketed sector, in the order of the file
+	std::unordered_map<std::string, std::vector<std::string>> GetBuckets() const;
+
+	// Print the # of bonds, where they were loaded from and how long it took
+	void Report(std::ostream &out) const;
+};
+
+SecuritiesMaster::SecuritiesMaster() :
+	fromImage(false)
+{
+}
+
+bool SecuritiesMaster::CopyField(char* output, const boost::string_view &field)
+{
+	std::memset(output, 0, SECURITIES_MASTER_FIELD_LENGTH);
+	if (field.size() >= SECURITIES_MASTER_FIELD_LENGTH)
+		return false;
+	std::memcpy(output, field.data(), field.size());
+	return true;
+}
+
+std::string SecuritiesMaster::GetField(const char* field)
+{
+	return std::string(field, strnlen(field, SECURITIES_MASTER_FIELD_LENGTH));
+}
+
+bool SecuritiesMaster::ParseDecimal(const boost::string_view &field, double &value)
+{
+	char buffer[32];
+	if (field.empty() || field.size() >= sizeof(buffer))
+		return false;
+	std::memcpy(buffer, field.data(), field.size());
+	buffer[field.size()] = '\0';
+	char* end;
+	value = std::strtod(buffer, &end);
+	return end == buffer + field.size();
+}
+
+bool SecuritiesMaster::ParseDate(const boost::string_view &field, std::int32_t &dayNumber)
+{
+	int parts[3] = { 0, 0, 0 }; // month, day, year
+	int part = 0;
+	for (char c : field)
+	{
+		if (c == '/' && part < 2)
+			part++;
+		else if (c >= '0' && c <= '9')
+			parts[part] = parts[part] * 10 + (c - '0');
+		else
+			return false;
+	}
+	if (part != 2)
+		return false;
+	try
+	{
+		boost::gregorian::date maturity(parts[2], parts[0], parts[1]);
+		dayNumber = static_cast<std::int32_t>(maturity.day_number());
+	}
+	catch (const std::out_of_range &) // not a valid date
+	{
+		return false;
+	}
+	return true;
+}
+
+std::int64_t SecuritiesMaster::GetModified(const struct stat &info)
+{
+	return static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+bool SecuritiesMaster::Parse(const std::string &path)
+{
+	CsvReader reader(path);
+	if (!reader.IsOpen())
+		return false;
+
+	SecuritiesMasterRecord record;
+	std::memset(&record, 0, sizeof(record));
+	while (reader.NextRow())
+	{
+		if (reader.GetFieldCount() < 6)
+		{
+			std::cout << "Oh no! Reference data: skip a row with missing fields!\n";
+			continue;
+		}
+		double coupon;
+		if (!CopyField(record.productId, reader.GetField(0)) || !CopyField(record.ticker, reader.GetField(2))
+			|| !CopyField(record.bucket, (reader.GetFieldCount() > 6) ? reader.GetField(6) : boost::string_view()))
+		{
+			std::cout << "Oh no! Reference data: skip a row with a field too long!\n";
+			continue;
+		}
+		if (!ProductId::Fits(reader.GetField(0)) || !Ticker::Fits(reader.GetField(2))) // a Bond would truncate them
+		{
+			std::cout << "Oh no! Reference data: skip a row with an identifier longer than " << ProductId::GetCapacity()
+				<< " or a ticker longer than " << Ticker::GetCapacity() << " characters!\n";
+			continue;
+		}
+		if (!ParseDecimal(reader.GetField(3), coupon) || !ParseDecimal(reader.GetField(5), record.pv01)
+			|| !ParseDate(reader.GetField(4), record.maturity))
+		{
+			std::cout << "Oh no! Reference data: skip a row with a malformed coupon, maturity or PV01!\n";
+			continue;
+		}
+		record.coupon = static_cast<float>(coupon);
+		record.bondIdType = (reader.GetField(1) == "ISIN") ? ISIN : CUSIP;
+		records.push_back(record);
+	}
+	return true;
+}
+
+bool SecuritiesMaster::LoadImage(const std::string &imagePath, const struct stat &source)
+{
+	int fd = ::open(imagePath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	bool loaded = false;
+	if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(SecuritiesMasterHeader))
+	{
+		void* mapped = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED)
+		{
+			const SecuritiesMasterHeader* header = static_cast<const SecuritiesMasterHeader*>(mapped);
+			std::size_t bytes = static_cast<std::size_t>(header->records) * sizeof(SecuritiesMasterRecord);
+			loaded = header->magic == SECURITIES_MASTER_MAGIC && header->version == SECURITIES_MASTER_VERSION
+				&& header->length == sizeof(SecuritiesMasterRecord) && header->sourceBytes == source.st_size
+				&& header->sourceModified == GetModified(source) && sizeof(SecuritiesMasterHeader) + bytes ==
+				static_cast<std::size_t>(info.st_size);
+			if (loaded)
+			{
+				records.resize(header->records);
+				if (bytes > 0)
+					std::memcpy(records.data(), static_cast<const char*>(mapped) + sizeof(SecuritiesMasterHeader), bytes);
+			}
+			::munmap(mapped, info.st_size);
+		}
+	}
+	::close(fd);
+	return loaded;
+}
+
+void SecuritiesMaster::SaveImage(const std::string &imagePath, const struct stat &source) const
+{
+	SecuritiesMasterHeader header;
+	header.magic = SECURITIES_MASTER_MAGIC;
+	header.version = SECURITIES_MASTER_VERSION;
+	header.length = static_cast<std::uint16_t>(sizeof(SecuritiesMasterRecord));
+	header.records = records.size();
+	header.sourceBytes = source.st_size;
+	header.sourceModified = GetModified(source);
+
+	std::string temporaryPath = imagePath + ".tmp";
+	int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		std::cout << "Oh no! Cannot write the securities master image " << temporaryPath << "!\n";
+		return;
+	}
+	std::size_t bytes = records.size() * sizeof(SecuritiesMasterRecord);
+	bool written = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+	if (written && bytes > 0)
+		written = ::write(fd, records.data(), bytes) == static_cast<ssize_t>(bytes);
+	::close(fd);
+	if (!written || std::rename(temporaryPath.c_str(), imagePath.c_str()) != 0)
+		std::cout << "Oh no! Cannot write the securities master image " << imagePath << "!\n";
+}
+
+bool SecuritiesMaster::Load(const std::string &path, bool useImage)
+{
+	sw.Reset();
+	sw.StartStopWatch();
+	records.clear();
+	fromImage = false;
+
+	struct stat source;
+	if (::stat(path.c_str(), &source) != 0)
+	{
+		sw.StopStopWatch();
+		return false;
+	}
+	std::string imagePath = path + ".bin";
+	if (useImage && LoadImage(imagePath, source))
+	{
+		fromImage = true;
+		sw.StopStopWatch();
+		return true;
+	}
+	bool parsed = Parse(path);
+	if (parsed && useImage)
+		SaveImage(imagePath, source);
+	sw.StopStopWatch();
+	return parsed;
+}
+
+std::size_t SecuritiesMaster::GetSize() const
+{
+	return records.size();
+}
+
+const std::vector<SecuritiesMasterRecord>& SecuritiesMaster::GetRecords() const
+{
+	return records;
+}
+
+Bond SecuritiesMaster::MakeBond(const SecuritiesMasterRecord &record)
+{
+	boost::gregorian::date maturity(boost::gregorian::gregorian_calendar::from_day_number(record.maturity));
+	return Bond(GetField(record.productId), BondIdType(record.bondIdType), GetField(record.ticker), record.coupon, maturity);
+}
+
+void SecuritiesMaster::AddBonds(BondProductService &bondProductService) const
+{
+	for (const SecuritiesMasterRecord &record : records)
+	{
+		Bond bond = MakeBond(record);
+		bondProductService.Add(bond);
+	}
+}
+
+std::unordered_map<std::string, double> SecuritiesMaster::GetPV01s() const
+{
+	std::unordered_map<std::string, double> pv01s;
+	for (const SecuritiesMasterRecord &record : records)
+		pv01s.insert(std::make_pair(GetField(record.productId), record.pv01));
+	return pv01s;
+}
+
+std::unordered_map<std::string, std::vector<std::string>> SecuritiesMaster::GetBuckets() const
+{
+	std::unordered_map<std::string, std::vector<std::string>> buckets;
+	for (const SecuritiesMasterRecord &record : records)
+	{
+		if (record.bucket[0] != '\0')
+			buckets[GetField(record.bucket)].push_back(GetField(record.productId));
+	}
+	return buckets;
+}
+
+void SecuritiesMaster::Report(std::ostream &out) const
+{
+	out << "Reference data: " << records.size() << " bonds loaded from the " << (fromImage ? "binary image" : "csv file")
+		<< " in " << sw.GetTime() * 1000 << " ms\n";
+}
+
+#endif // !SecuritiesMaster_hpp
@@ -0,0 +1,104 @@
+// ServiceGraphRunner.hpp
+//
+// Author: Yuchen Liu
+//
+// Define a runner of the service graph: each service line (a subscribe connector and
+// the services downstream of it) is started on its own thread, and the per-line and
+// total throughput are reported at the end
+
+#ifndef ServiceGraphRunner_hpp
+#define ServiceGraphRunner_hpp
+
+#include "StopWatch.hpp"
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <iostream>
+
+// A service line of the graph
+struct ServiceLine
+{
+	std::string name;
+	std::function<long()> run; // run the line and return the # of records processed
+	long records = 0;
+	double seconds = 0.0;
+};
+
+// Service graph runner
+class ServiceGraphRunner
+{
+protected:
+	std::vector<ServiceLine> lines;
+	double wallSeconds = 0.0;
+
+	// Run a single line and record its timing
+	static void RunLine(ServiceLine &line);
+
+public:
+	ServiceGraphRunner() {} // empty ctor
+
+	// Add a line to the graph
+	void AddLine(const std::string &name, std::function<long()> run);
+
+	// Run all the lines, each on its own thread if concurrent (otherwise one after the other)
+	void Run(bool concurrent = true);
+
+	// Print the per-line and total throughput
+	void Report(std::ostream &out) const;
+};
+
+void ServiceGraphRunner::RunLine(ServiceLine &line)
+{
+	StopWatch sw;
+	sw.StartStopWatch();
+	line.records = line.run();
+	sw.StopStopWatch();
+	line.seconds = sw.GetTime();
+}
+
+void ServiceGraphRunner::AddLine(const std::string &name, std::function<long()> run)
+{
+	ServiceLine line;
+	line.name = name;
+	line.run = run;
+	lines.push_back(line);
+}
+
+void ServiceGraphRunner::Run(bool concurrent)
+{
+	StopWatch sw;
+	sw.StartStopWatch();
+	if (concurrent)
+	{
+		std::vector<std::thread> threads;
+		for (auto &line : lines)
+			threads.push_back(std::thread(&ServiceGraphRunner::RunLine, std::ref(line)));
+		for (auto &thread : threads)
+			thread.join();
+	}
+	else
+	{
+		for (auto &line : lines)
+			RunLine(line);
+	}
+	sw.StopStopWatch();
+	wallSeconds = sw.GetTime();
+}
+
+void ServiceGraphRunner::Report(std::ostream &out) const
+{
+	long total = 0;
+	for (auto &line : lines)
+	{
+		double rate = (line.seconds > 0) ? line.records / line.seconds : 0.0;
+		out << line.name << ": " << line.records << " records in " << line.seconds << " seconds ("
+			<< static_cast<long>(rate) << " records/sec)\n";
+		total += line.records;
+	}
+	double rate = (wallSeconds > 0) ? total / wallSeconds : 0.0;
+	out << "Total: " << total << " records in " << wallSeconds << " seconds ("
+		<< static_cast<long>(rate) << " records/sec)\n";
+}
+
+#endif // !ServiceGraphRunner_hpp
@@ -0,0 +1,257 @@
+// ServiceSnapshot.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the binary snapshot of the state of a service (e.g. the positions or the PV01s of the bonds):
+// one section per record type, each holding the state of every product as journal records (see HistoricalJournal.hpp)
+// and the # of records of that type already in the journal when it was taken,
+// so a restart loads the snapshot and only replays the journal records that follow
+// (only if the journal on disk is the one attached when the snapshot was taken, identified by its run)
+
+#ifndef ServiceSnapshot_hpp
+#define ServiceSnapshot_hpp
+
+#include "HistoricalJournal.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <iostream>
+#include <fcntl.h> // the following are Unix only
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "BSNP", the first bytes of a snapshot
+const std::uint32_t SNAPSHOT_MAGIC = 0x504E5342;
+const std::uint16_t SNAPSHOT_VERSION = 2;
+
+// Header of a snapshot file
+struct SnapshotHeader
+{
+	std::uint32_t magic;
+	std::uint16_t version;
+	std::uint16_t sections; // # of sections
+	std::int64_t timestamp; // microseconds since the epoch
+	std::int64_t journalRunId; // run of the journal the records are counted in (see JournalWriter), 0 if none
+};
+
+// Header of a section, followed by its records
+struct SnapshotSectionHeader
+{
+	std::uint16_t type; // a JournalRecordType
+	std::uint16_t length; // # of bytes of each record
+	std::uint32_t records; // # of records of the section
+	std::uint64_t journalRecords; // # of records of this type in the journal when the snapshot was taken
+};
+
+// Snapshot being written: the sections are buffered, then committed at once
+// (written to a temporary file, synced, then renamed over the previous snapshot)
+class SnapshotWriter
+{
+protected:
+	std::string path;
+	std::int64_t journalRunId;
+	std::vector<char> buffer; // the sections
+	std::uint16_t sections; // # of sections
+
+public:
+	SnapshotWriter(const std::string &_path, std::int64_t _journalRunId = 0); // ctor, with the run of the journal attached (0 if none)
+
+	// Add a section of records of a type
+	template <typename R>
+	void AddSection(JournalRecordType type, std::uint64_t journalRecords, const std::vector<R> &records);
+
+	// Write the snapshot, return false if it cannot be written (the previous snapshot is then kept)
+	bool Commit() const;
+};
+
+// Commit of the periodic snapshots on a background thread, so the service does not wait for the disk
+// (one at a time: a commit waits for the previous one)
+class SnapshotCommitter
+{
+protected:
+	std::thread worker; // the current commit
+
+public:
+	SnapshotCommitter() {} // empty ctor
+	~SnapshotCommitter(); // dtor, waits for the current commit
+
+	// Commit a snapshot on a background thread
+	void Commit(const SnapshotWriter &writer);
+
+	// Wait for the current commit
+	void Wait();
+
+private:
+	SnapshotCommitter(const SnapshotCommitter &); // not copyable, owns the thread
+	SnapshotCommitter& operator=(const SnapshotCommitter &);
+};
+
+// Snapshot being read: the whole file is loaded by the ctor
+class SnapshotReader
+{
+protected:
+	std::vector<char> buffer; // the file
+	bool loaded; // whether the file is a valid snapshot
+
+public:
+	SnapshotReader(const std::string &path); // ctor, loads the file
+
+	// Whether the snapshot is loaded
+	bool IsOpen() const;
+
+	// Get the time stamp of the snapshot
+	std::int64_t GetTimestamp() const;
+
+	// Get the run of the journal attached when the snapshot was taken, 0 if none
+	std::int64_t GetJournalRunId() const;
+
+	// Get the records of the section of a type and the # of records of that type in the journal when it was taken,
+	// return false if the snapshot has no such section
+	template <typename R>
+	bool GetSection(JournalRecordType type, std::vector<R> &records, std::uint64_t &journalRecords) const;
+};
+
+SnapshotWriter::SnapshotWriter(const std::string &_path, std::int64_t _journalRunId) :
+	path(_path), journalRunId(_journalRunId), sections(0)
+{
+}
+
+template <typename R>
+void SnapshotWriter::AddSection(JournalRecordType type, std::uint64_t journalRecords, const std::vector<R> &records)
+{
+	SnapshotSectionHeader header;
+	header.type = static_cast<std::uint16_t>(type);
+	header.length = static_cast<std::uint16_t>(sizeof(R));
+	header.records = static_cast<std::uint32_t>(records.size());
+	header.journalRecords = journalRecords;
+	const char* headerBytes = reinterpret_cast<const char*>(&header);
+	buffer.insert(buffer.end(), headerBytes, headerBytes + sizeof(header));
+	const char* recordBytes = reinterpret_cast<const char*>(records.data());
+	buffer.insert(buffer.end(), recordBytes, recordBytes + records.size() * sizeof(R));
+	sections++;
+}
+
+bool SnapshotWriter::Commit() const
+{
+	SnapshotHeader header;
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.sections = sections;
+	header.timestamp = GetJournalTimestamp();
+	header.journalRunId = journalRunId;
+
+	std::string temporaryPath = path + ".tmp";
+	int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		std::cout << "Oh no! Cannot write the snapshot " << temporaryPath << "!\n";
+		return false;
+	}
+	bool written = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+	if (written && !buffer.empty())
+		written = ::write(fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size());
+	written = written && ::fsync(fd) == 0;
+	::close(fd);
+	if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+	{
+		std::cout << "Oh no! Cannot write the snapshot " << path << "!\n";
+		return false;
+	}
+
+	// make the rename durable
+	std::string::size_type slash = path.find_last_of('/');
+	std::string directory = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+	int directoryFd = ::open(directory.c_str(), O_RDONLY);
+	if (directoryFd < 0 || ::fsync(directoryFd) != 0)
+		std::cout << "Oh no! Cannot sync the directory of the snapshot " << path << "!\n";
+	if (directoryFd >= 0)
+		::close(directoryFd);
+	return true;
+}
+
+SnapshotCommitter::~SnapshotCommitter()
+{
+	Wait();
+}
+
+void SnapshotCommitter::Commit(const SnapshotWriter &writer)
+{
+	Wait();
+	worker = std::thread([writer]() { writer.Commit(); });
+}
+
+void SnapshotCommitter::Wait()
+{
+	if (worker.joinable())
+		worker.join();
+}
+
+SnapshotReader::SnapshotReader(const std::string &path) : loaded(false)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat info;
+	if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(SnapshotHeader))
+	{
+		buffer.resize(static_cast<std::size_t>(info.st_size));
+		loaded = ::read(fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size());
+	}
+	::close(fd);
+
+	const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(buffer.data());
+	if (loaded && (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION))
+	{
+		std::cout << "Oh no! " << path << " is not a snapshot!\n";
+		loaded = false;
+	}
+}
+
+bool SnapshotReader::IsOpen() const
+{
+	return loaded;
+}
+
+std::int64_t SnapshotReader::GetTimestamp() const
+{
+	return loaded ? reinterpret_cast<const SnapshotHeader*>(buffer.data())->timestamp : 0;
+}
+
+std::int64_t SnapshotReader::GetJournalRunId() const
+{
+	return loaded ? reinterpret_cast<const SnapshotHeader*>(buffer.data())->journalRunId : 0;
+}
+
+template <typename R>
+bool SnapshotReader::GetSection(JournalRecordType type, std::vector<R> &records, std::uint64_t &journalRecords) const
+{
+	if (!loaded)
+		return false;
+	const char* cursor = buffer.data() + sizeof(SnapshotHeader);
+	const char* last = buffer.data() + buffer.size();
+	std::uint16_t sections = reinterpret_cast<const SnapshotHeader*>(buffer.data())->sections;
+	for (std::uint16_t i = 0; i < sections && cursor + sizeof(SnapshotSectionHeader) <= last; i++)
+	{
+		SnapshotSectionHeader header;
+		std::memcpy(&header, cursor, sizeof(header));
+		cursor += sizeof(header);
+		std::size_t bytes = static_cast<std::size_t>(header.records) * header.length;
+		if (cursor + bytes > last) // truncated
+			return false;
+		if (header.type == type && header.length == sizeof(R))
+		{
+			records.resize(header.records);
+			if (bytes > 0)
+				std::memcpy(records.data(), cursor, bytes);
+			journalRecords = header.journalRecords;
+			return true;
+		}
+		cursor += bytes;
+	}
+	return false;
+}
+
+#endif // !ServiceSnapshot_hpp
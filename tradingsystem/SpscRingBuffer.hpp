@@ -0,0 +1,127 @@
+// SpscRingBuffer.hpp
+//
+// Author: Yuchen Liu
+//
+// A bounded lock-free single-producer/single-consumer ring buffer,
+// used to hand data over between services running on different threads
+
+#ifndef SpscRingBuffer_hpp
+#define SpscRingBuffer_hpp
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <cstddef>
+
+// Bounded ring buffer with exactly one producer thread and one consumer thread
+// The capacity is rounded up to a power of two so that indexing is a mask
+// Type T is the element type (slots are pre-allocated and re-used)
+template <typename T>
+class SpscRingBuffer
+{
+private:
+	static const std::size_t cacheLine = 64;
+
+	std::vector<T> buffer;
+	std::size_t mask;
+
+	// consumer side: next slot to read, and the producer index it last observed
+	char pad0[cacheLine];
+	std::atomic<std::size_t> head;
+	std::size_t cachedTail;
+
+	// producer side: next slot to write, and the consumer index it last observed
+	char pad1[cacheLine];
+	std::atomic<std::size_t> tail;
+	std::size_t cachedHead;
+	char pad2[cacheLine];
+
+public:
+	explicit SpscRingBuffer(std::size_t _capacity); // ctor
+
+	// Try to push an item, return false if the ring is full (producer only)
+	bool TryPush(const T &item);
+
+	// Push an item, spinning while the ring is full (producer only)
+	void Push(const T &item);
+
+	// Try to pop an item, return false if the ring is empty (consumer only)
+	bool TryPop(T &item);
+
+	// Approximate number of items in the ring
+	std::size_t Size() const;
+
+	// Whether the ring is (approximately) empty
+	bool Empty() const;
+
+	// Get the capacity of the ring
+	std::size_t GetCapacity() const;
+};
+
+template <typename T>
+SpscRingBuffer<T>::SpscRingBuffer(std::size_t _capacity) :
+	head(0), cachedTail(0), tail(0), cachedHead(0)
+{
+	std::size_t capacity = 2;
+	while (capacity < _capacity) capacity <<= 1;
+	buffer.resize(capacity);
+	mask = capacity - 1;
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::TryPush(const T &item)
+{
+	std::size_t t = tail.load(std::memory_order_relaxed);
+	if (t - cachedHead > mask) // looks full, refresh the consumer index
+	{
+		cachedHead = head.load(std::memory_order_acquire);
+		if (t - cachedHead > mask)
+			return false;
+	}
+	buffer[t & mask] = item;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+void SpscRingBuffer<T>::Push(const T &item)
+{
+	while (!TryPush(item))
+		std::this_thread::yield(); // back-pressure on the producer
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::TryPop(T &item)
+{
+	std::size_t h = head.load(std::memory_order_relaxed);
+	if (h == cachedTail) // looks empty, refresh the producer index
+	{
+		cachedTail = tail.load(std::memory_order_acquire);
+		if (h == cachedTail)
+			return false;
+	}
+	item = buffer[h & mask];
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::Size() const
+{
+	std::size_t h = head.load(std::memory_order_acquire); // read head first so that head <= tail
+	return tail.load(std::memory_order_acquire) - h;
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::Empty() const
+{
+	return Size() == 0;
+}
+
+template <typename T>
+std::size_t SpscRingBuffer<T>::GetCapacity() const
+{
+	return mask + 1;
+}
+
+#endif // !SpscRingBuffer_hpp
@@ -0,0 +1,156 @@
+// StaticPipeline.hpp
+//
+// Author: Yuchen Liu
+//
+// Define a service pipeline wired at compile time:
+// each stage hands its output to the next stage through a template parameter
+// instead of a vector of ServiceListener pointers, so the compiler can inline the whole chain
+
+#ifndef StaticPipeline_hpp
+#define StaticPipeline_hpp
+
+#include "soa.hpp"
+#include <cstddef>
+
+// Static pipeline over a list of stages
+// Each stage provides template <typename Next> void Process(In &data, Next &next)
+// and template <typename Next> void ProcessBatch(In *data, size_t size, Next &next),
+// where next.Push(out) / next.PushBatch(out, size) forwards its output to the rest of the pipeline
+template <typename... Stages>
+class StaticPipeline;
+
+// End of a static pipeline (drops the data)
+template <>
+class StaticPipeline<>
+{
+public:
+	StaticPipeline() {} // empty ctor
+
+	// Push data into the pipeline
+	template <typename V>
+	void Push(V &data);
+
+	// Push a batch of data into the pipeline
+	template <typename V>
+	void PushBatch(V *data, size_t size);
+};
+
+template <typename Stage, typename... Rest>
+class StaticPipeline<Stage, Rest...>
+{
+private:
+	Stage stage;
+	StaticPipeline<Rest...> next;
+
+public:
+	StaticPipeline(Stage _stage, Rest... _rest); // ctor
+
+	// Push data into the pipeline
+	template <typename V>
+	void Push(V &data);
+
+	// Push a batch of data into the pipeline
+	template <typename V>
+	void PushBatch(V *data, size_t size);
+};
+
+// Build a static pipeline from its stages
+template <typename... Stages>
+StaticPipeline<Stages...> MakePipeline(Stages... stages)
+{
+	return StaticPipeline<Stages...>(stages...);
+}
+
+// Listener to plug a static pipeline into a service
+// (the only virtual call left is the one into the head of the pipeline)
+// Type V is the data type of the service, type Pipeline is the static pipeline type
+template <typename V, typename Pipeline>
+class StaticPipelineListener : public ServiceListener<V>
+{
+protected:
+	Pipeline* pipeline;
+
+public:
+	StaticPipelineListener(Pipeline* _pipeline); // ctor
+
+	// Listener callback to process an add event to the Service
+	virtual void ProcessAdd(V &data);
+
+	// Listener callback to process a remove event to the Service
+	virtual void ProcessRemove(V &data);
+
+	// Listener callback to process an update event to the Service
+	virtual void ProcessUpdate(V &data);
+
+	// Listener callback to process a batch of add events to the Service
+	virtual void ProcessAddBatch(V *data, size_t size);
+
+	// Listener callback to process a batch of update events to the Service
+	virtual void ProcessUpdateBatch(V *data, size_t size);
+};
+
+template <typename V>
+void StaticPipeline<>::Push(V &data)
+{ // end of the pipeline
+}
+
+template <typename V>
+void StaticPipeline<>::PushBatch(V *data, size_t size)
+{ // end of the pipeline
+}
+
+template <typename Stage, typename... Rest>
+StaticPipeline<Stage, Rest...>::StaticPipeline(Stage _stage, Rest... _rest) : 
+	stage(_stage), next(_rest...)
+{
+}
+
+template <typename Stage, typename... Rest>
+template <typename V>
+void StaticPipeline<Stage, Rest...>::Push(V &data)
+{
+	stage.Process(data, next);
+}
+
+template <typename Stage, typename... Rest>
+template <typename V>
+void StaticPipeline<Stage, Rest...>::PushBatch(V *data, size_t size)
+{
+	stage.ProcessBatch(data, size, next);
+}
+
+template <typename V, typename Pipeline>
+StaticPipelineListener<V, Pipeline>::StaticPipelineListener(Pipeline* _pipeline) : pipeline(_pipeline)
+{
+}
+
+template <typename V, typename Pipeline>
+void StaticPipelineListener<V, Pipeline>::ProcessAdd(V &data)
+{
+	pipeline->Push(data);
+}
+
+template <typename V, typename Pipeline>
+void StaticPipelineListener<V, Pipeline>::ProcessRemove(V &data)
+{ // not defined for the pipeline
+}
+
+template <typename V, typename Pipeline>
+void StaticPipelineListener<V, Pipeline>::ProcessUpdate(V &data)
+{
+	pipeline->Push(data);
+}
+
+template <typename V, typename Pipeline>
+void StaticPipelineListener<V, Pipeline>::ProcessAddBatch(V *data, size_t size)
+{
+	pipeline->PushBatch(data, size);
+}
+
+template <typename V, typename Pipeline>
+void StaticPipelineListener<V, Pipeline>::ProcessUpdateBatch(V *data, size_t size)
+{
+	pipeline->PushBatch(data, size);
+}
+
+#endif // !StaticPipeline_hpp
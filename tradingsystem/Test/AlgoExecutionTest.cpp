@@ -0,0 +1,71 @@
+// AlgoExecutionTest.cpp
+//
+// Author: Yuchen Liu
+//
+// Check that the algo execution trades only against a two-sided book:
+// once the last bid level of a product is deleted by an incremental update, no execution order is generated
+
+#include "productservice.hpp"
+#include "BondService/BondMarketDataSoa.hpp"
+#include "BondService/BondAlgoExecutionSoa.hpp"
+#include <iostream>
+
+// Count the algo executions generated
+class AlgoExecutionCounter : public ServiceListener<AlgoExecution<Bond>>
+{
+public:
+	long count = 0;
+
+	virtual void ProcessAdd(AlgoExecution<Bond> &data) {}
+	virtual void ProcessRemove(AlgoExecution<Bond> &data) {}
+	virtual void ProcessUpdate(AlgoExecution<Bond> &data) { count++; }
+};
+
+int main()
+{
+	BondProductService bondProductService;
+	Bond treasury("912828M80", CUSIP, "T", 2.0f, date(2022, Nov, 30));
+	bondProductService.Add(treasury);
+	const Bond* bond = &bondProductService.GetData("912828M80");
+
+	BondMarketDataService bondMarketDataService(&bondProductService);
+	BondAlgoExecutionService bondAlgoExecutionService(&bondProductService);
+	BondAlgoExecutionDeltaListener bondAlgoExecutionDeltaListener(&bondAlgoExecutionService);
+	AlgoExecutionCounter counter;
+	bondMarketDataService.AddDeltaListener(&bondAlgoExecutionDeltaListener);
+	bondAlgoExecutionService.AddListener(&counter);
+
+	// a tight two-sided book: one execution order
+	TickPrice bid = TickPrice::FromTicks(99 * TickPrice::TICKS_PER_UNIT);
+	TickPrice offer = bid + TickPrice::FromTicks(1);
+	MarketDataUpdate<Bond> update(bond);
+	update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, BID, bid, 10000000));
+	update.AddLevelUpdate(PriceLevelUpdate(ADD_LEVEL, OFFER, offer, 10000000));
+	bondMarketDataService.OnUpdate(update);
+	if (counter.count != 1)
+	{
+		std::cout << "Oh no! " << counter.count << " execution orders on a two-sided book instead of 1!\n";
+		return 1;
+	}
+
+	// the last bid level is deleted: the top of the book moves, but there is no bid to trade against
+	update.Reset(bond);
+	update.AddLevelUpdate(PriceLevelUpdate(DELETE_LEVEL, BID, bid, 0));
+	bondMarketDataService.OnUpdate(update);
+	if (counter.count != 1)
+	{
+		std::cout << "Oh no! An execution order was generated against an empty bid side!\n";
+		return 1;
+	}
+
+	// the same best bid/offer handed to the algo service directly
+	bondAlgoExecutionService.AddOrder(*bond, bondMarketDataService.GetBestBidOffer("912828M80"));
+	if (counter.count != 1)
+	{
+		std::cout << "Oh no! An execution order was generated from a one-sided best bid/offer!\n";
+		return 1;
+	}
+
+	std::cout << "Algo execution: no order against an empty side\n";
+	return 0;
+}
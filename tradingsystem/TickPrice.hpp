@@ -0,0 +1,148 @@
+// TickPrice.hpp
+//
+// Author: Yuchen Liu
+//
+// Define a fixed-point price counted in 1/256 ticks (the smallest increment of the 99-xyz notation),
+// so that the prices in the order books, the aggregation and the spread checks compare exactly
+
+#ifndef TickPrice_hpp
+#define TickPrice_hpp
+
+#include "utilityfunction.hpp"
+#include <cmath>
+#include <cstddef>
+#include <functional>
+
+// Fixed-point price in 1/256 ticks
+class TickPrice
+{
+private:
+	long ticks;
+
+	explicit TickPrice(long _ticks) : ticks(_ticks) {} // ctor from a number of ticks, see FromTicks()
+
+public:
+	static const long TICKS_PER_UNIT = 256;
+
+	TickPrice() : ticks(0) {} // empty ctor, zero price
+
+	// Make a price from a number of 1/256 ticks
+	static TickPrice FromTicks(long _ticks);
+
+	// Make a price from a double (rounded to the nearest tick)
+	static TickPrice FromDouble(double price);
+
+	// Make a price from the 99-xyz notation in [str, str + size), return false if malformed
+	static bool FromBuffer(const char* str, std::size_t size, TickPrice &price);
+
+	// Get the number of ticks
+	long GetTicks() const;
+
+	// Convert the price to a double (exact)
+	double ToDouble() const;
+
+	// Write the price in the 99-xyz notation into buffer (null-terminated, at least 32 characters)
+	// and return the number of characters written
+	std::size_t ToBuffer(char* buffer) const;
+
+	// Arithmetic (exact)
+	TickPrice operator+(const TickPrice &other) const;
+	TickPrice operator-(const TickPrice &other) const;
+
+	// Comparison (exact)
+	bool operator==(const TickPrice &other) const;
+	bool operator!=(const TickPrice &other) const;
+	bool operator<(const TickPrice &other) const;
+	bool operator<=(const TickPrice &other) const;
+	bool operator>(const TickPrice &other) const;
+	bool operator>=(const TickPrice &other) const;
+};
+
+// hash of a price, to key the unordered containers on it
+namespace std
+{
+	template <>
+	struct hash<TickPrice>
+	{
+		std::size_t operator()(const TickPrice &price) const
+		{
+			return std::hash<long>()(price.GetTicks());
+		}
+	};
+}
+
+TickPrice TickPrice::FromTicks(long _ticks)
+{
+	return TickPrice(_ticks);
+}
+
+TickPrice TickPrice::FromDouble(double price)
+{
+	return TickPrice(std::lround(price * TICKS_PER_UNIT));
+}
+
+bool TickPrice::FromBuffer(const char* str, std::size_t size, TickPrice &price)
+{
+	long _ticks;
+	if (!BuffertoTicks(str, size, _ticks))
+		return false;
+	price = TickPrice(_ticks);
+	return true;
+}
+
+long TickPrice::GetTicks() const
+{
+	return ticks;
+}
+
+double TickPrice::ToDouble() const
+{
+	return static_cast<double>(ticks) / TICKS_PER_UNIT;
+}
+
+std::size_t TickPrice::ToBuffer(char* buffer) const
+{
+	return TickstoBuffer(ticks, buffer);
+}
+
+TickPrice TickPrice::operator+(const TickPrice &other) const
+{
+	return TickPrice(ticks + other.ticks);
+}
+
+TickPrice TickPrice::operator-(const TickPrice &other) const
+{
+	return TickPrice(ticks - other.ticks);
+}
+
+bool TickPrice::operator==(const TickPrice &other) const
+{
+	return ticks == other.ticks;
+}
+
+bool TickPrice::operator!=(const TickPrice &other) const
+{
+	return ticks != other.ticks;
+}
+
+bool TickPrice::operator<(const TickPrice &other) const
+{
+	return ticks < other.ticks;
+}
+
+bool TickPrice::operator<=(const TickPrice &other) const
+{
+	return ticks <= other.ticks;
+}
+
+bool TickPrice::operator>(const TickPrice &other) const
+{
+	return ticks > other.ticks;
+}
+
+bool TickPrice::operator>=(const TickPrice &other) const
+{
+	return ticks >= other.ticks;
+}
+
+#endif // !TickPrice_hpp
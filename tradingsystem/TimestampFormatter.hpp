@@ -0,0 +1,110 @@
+// TimestampFormatter.hpp
+//
+// Author: Yuchen Liu
+//
+// Define the time stamp of the output records (MM/DD/YYYY HH:MM:SS.mmm in local time):
+// the date and the second are formatted once per second and cached,
+// only the milliseconds are rewritten for each record, straight into the output buffer
+
+#ifndef TimestampFormatter_hpp
+#define TimestampFormatter_hpp
+
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <cstddef>
+#include <string>
+
+// # of characters of a time stamp (without the terminating null character)
+const std::size_t TIMESTAMP_LENGTH = 23;
+
+// Cached wall-clock time stamp formatter
+// Not thread-safe: each connector keeps its own
+class TimestampFormatter
+{
+protected:
+	std::time_t cachedSecond; // the second of the cached prefix, -1 if none yet
+	char prefix[TIMESTAMP_LENGTH]; // "MM/DD/YYYY HH:MM:SS." of the cached second
+
+	// Write a number of width digits (with leading zeros)
+	static void WriteDigits(char *buffer, int value, int width);
+
+public:
+	TimestampFormatter(); // ctor
+
+	// Write the current time into the buffer (at least TIMESTAMP_LENGTH + 1 characters, null-terminated)
+	// return the # of characters written (without the null character)
+	std::size_t Format(char *buffer);
+
+	// Write the given time into the buffer (at least TIMESTAMP_LENGTH + 1 characters, null-terminated)
+	// return the # of characters written (without the null character)
+	std::size_t Format(std::chrono::system_clock::time_point time, char *buffer);
+
+	// Append the current time to the buffer
+	void AppendTo(std::string &buffer);
+};
+
+TimestampFormatter::TimestampFormatter() : cachedSecond(-1)
+{
+}
+
+void TimestampFormatter::WriteDigits(char *buffer, int value, int width)
+{
+	for (int i = width - 1; i >= 0; i--)
+	{
+		buffer[i] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+}
+
+std::size_t TimestampFormatter::Format(char *buffer)
+{
+	return Format(std::chrono::system_clock::now(), buffer);
+}
+
+std::size_t TimestampFormatter::Format(std::chrono::system_clock::time_point time, char *buffer)
+{
+	long long micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+	long long seconds = micros / 1000000;
+	int fraction = static_cast<int>(micros % 1000000);
+	if (fraction < 0) // before the epoch
+	{
+		fraction += 1000000;
+		seconds--;
+	}
+
+	// a new second: convert to local time and cache the date and the time of the day
+	std::time_t second = static_cast<std::time_t>(seconds);
+	if (second != cachedSecond)
+	{
+		std::tm local;
+		localtime_r(&second, &local);
+		WriteDigits(prefix, local.tm_mon + 1, 2);
+		prefix[2] = '/';
+		WriteDigits(prefix + 3, local.tm_mday, 2);
+		prefix[5] = '/';
+		WriteDigits(prefix + 6, local.tm_year + 1900, 4);
+		prefix[10] = ' ';
+		WriteDigits(prefix + 11, local.tm_hour, 2);
+		prefix[13] = ':';
+		WriteDigits(prefix + 14, local.tm_min, 2);
+		prefix[16] = ':';
+		WriteDigits(prefix + 17, local.tm_sec, 2);
+		prefix[19] = '.';
+		cachedSecond = second;
+	}
+
+	// the cached prefix and the milliseconds (truncated)
+	std::memcpy(buffer, prefix, 20);
+	WriteDigits(buffer + 20, fraction / 1000, 3);
+	buffer[TIMESTAMP_LENGTH] = '\0';
+	return TIMESTAMP_LENGTH;
+}
+
+void TimestampFormatter::AppendTo(std::string &buffer)
+{
+	char timestamp[TIMESTAMP_LENGTH + 1];
+	buffer.append(timestamp, Format(timestamp));
+}
+
+#endif // !TimestampFormatter_hpp
@@ -0,0 +1,75 @@
+// benchmark.cpp
+// 
+// Author: Yuchen Liu
+// 
+// Benchmarks of the trading system components
+// usage: ./tradingsystem_benchmark [# of messages] [csv file to parse]
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include "products.hpp"
+#include "productservice.hpp"
+#include "Benchmark/PipelineBenchmark.hpp"
+#include "Benchmark/CsvReaderBenchmark.hpp"
+#include "Benchmark/PriceNotationBenchmark.hpp"
+#include "Benchmark/OrderBookBenchmark.hpp"
+#include "Benchmark/ConsolidatedBookBenchmark.hpp"
+#include "Benchmark/TimestampBenchmark.hpp"
+#include "Benchmark/ReferenceDataBenchmark.hpp"
+#include "Benchmark/SwapScreenBenchmark.hpp"
+
+int main(int argc, char* argv[])
+{
+	long nMessages = 1000000;
+	if (argc > 1) nMessages = std::atol(argv[1]);
+	std::string csvPath("./Data/marketdata.txt"); // generated by the main program
+	if (argc > 2) csvPath = argv[2];
+
+	// product information (hard-coded), the treasuries of the default securities master (see Data/BondReferenceDataGenerator.hpp)
+	std::vector<Bond> bonds;
+	bonds.push_back(Bond("9128283H1", CUSIP, "T", 1.750, boost::gregorian::date(2019, Nov, 30))); // 2Y bond
+	bonds.push_back(Bond("9128283G3", CUSIP, "T", 1.750, boost::gregorian::date(2020, Nov, 15))); // 3Y bond
+	bonds.push_back(Bond("912828M80", CUSIP, "T", 2.000, boost::gregorian::date(2022, Nov, 30))); // 5Y bond
+	bonds.push_back(Bond("9128283J7", CUSIP, "T", 2.125, boost::gregorian::date(2024, Nov, 30))); // 7Y bond
+	bonds.push_back(Bond("9128283F5", CUSIP, "T", 2.25, boost::gregorian::date(2027, Nov, 15))); // 10Y bond
+	bonds.push_back(Bond("912810RZ3", CUSIP, "T", 2.75, boost::gregorian::date(2047, Nov, 15))); // 30Y bond
+
+	// register the bonds (sets their product handles)
+	BondProductService bondProductService;
+	for (auto &bond : bonds)
+		bondProductService.Add(bond);
+
+	std::cout << "=================== Pipeline benchmark ========================\n";
+	pipeline_benchmark(bonds, nMessages);
+	std::cout << "===============================================================\n";
+
+	std::cout << "=================== Price notation benchmark ==================\n";
+	price_notation_validate();
+	price_notation_benchmark(nMessages);
+	std::cout << "===============================================================\n";
+
+	std::cout << "=================== Time stamp benchmark ======================\n";
+	timestamp_validate();
+	timestamp_benchmark(nMessages);
+	std::cout << "===============================================================\n";
+
+	std::cout << "=================== Order book benchmark ======================\n";
+	order_book_benchmark(bonds, nMessages);
+	consolidated_book_benchmark(100, nMessages);
+	std::cout << "===============================================================\n";
+
+	std::cout << "=================== Reference data benchmark ==================\n";
+	reference_data_benchmark(20000, nMessages);
+	swap_screen_benchmark(1000000, 10);
+	securities_master_benchmark(50000, "./securities_benchmark.txt");
+	std::cout << "===============================================================\n";
+
+	std::cout << "=================== Csv reader benchmark ======================\n";
+	csv_reader_benchmark(csvPath);
+	std::cout << "===============================================================\n";
+
+	return 0;
+}
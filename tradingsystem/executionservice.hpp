@@ -26,7 +26,7 @@ class ExecutionOrder
 public:
 
   // ctor for an order
-  ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
+  ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, TickPrice _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
   ExecutionOrder() {} 
 
   // Get the product
@@ -39,7 +39,7 @@ public:
   OrderType GetOrderType() const;
 
   // Get the price on this order
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the visible quantity on this order
   long GetVisibleQuantity() const;
@@ -61,7 +61,7 @@ private:
   PricingSide side;
   string orderId;
   OrderType orderType;
-  double price;
+  TickPrice price;
   long visibleQuantity;
   long hiddenQuantity; 
   string parentOrderId;
@@ -86,7 +86,7 @@ public:
 };
 
 template<typename T>
-ExecutionOrder<T>::ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder) :
+ExecutionOrder<T>::ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, TickPrice _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder) :
   product(_product)
 {
   side = _side;
@@ -118,7 +118,7 @@ OrderType ExecutionOrder<T>::GetOrderType() const
 }
 
 template<typename T>
-double ExecutionOrder<T>::GetPrice() const
+TickPrice ExecutionOrder<T>::GetPrice() const
 {
   return price;
 }
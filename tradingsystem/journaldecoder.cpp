@@ -0,0 +1,43 @@
+// journaldecoder.cpp
+//
+// Author: Yuchen Liu
+//
+// Decode the binary historical data journals back into the csv outputs
+// usage: ./tradingsystem_journaldecoder [journal csv]
+// (without arguments, the journals of the main program under ./Data are decoded into ./Data/*.txt)
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include "JournalDecoder.hpp"
+#include "StopWatch.hpp"
+
+int main(int argc, char* argv[])
+{
+	// the journals and the csv files they are decoded into
+	std::vector<std::pair<std::string, std::string>> journals;
+	if (argc > 2)
+		journals.push_back(std::make_pair(std::string(argv[1]), std::string(argv[2])));
+	else
+	{
+		journals.push_back(std::make_pair(std::string("./Data/position"), std::string("./Data/position.txt")));
+		journals.push_back(std::make_pair(std::string("./Data/risk"), std::string("./Data/risk.txt")));
+		journals.push_back(std::make_pair(std::string("./Data/streaming"), std::string("./Data/streaming.txt")));
+		journals.push_back(std::make_pair(std::string("./Data/execution"), std::string("./Data/execution.txt")));
+		journals.push_back(std::make_pair(std::string("./Data/allinquiry"), std::string("./Data/allinquiry.txt")));
+	}
+
+	StopWatch sw;
+	for (auto &journal : journals)
+	{
+		sw.Reset();
+		sw.StartStopWatch();
+		long records = DecodeJournal(journal.first, journal.second);
+		sw.StopStopWatch();
+		std::cout << journal.first << " ==> " << journal.second << ": " << records << " records in "
+			<< sw.GetTime() << " seconds\n";
+	}
+
+	return 0;
+}
@@ -10,6 +10,8 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <memory>
+#include <thread>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include "soa.hpp"
@@ -19,6 +21,7 @@
 #include "Data/BondTradeDataGenerator.hpp"
 #include "Data/BondMarketDataGenerator.hpp"
 #include "Data/BondInquiryDataGenerator.hpp"
+#include "Data/BondReferenceDataGenerator.hpp"
 #include "BondService/BondAlgoExecutionSoa.hpp"
 #include "BondService/BondAlgoStreamingSoa.hpp"
 #include "BondService/BondExecutionSoa.hpp"
@@ -35,7 +38,13 @@
 #include "BondService/HistoricalDataSoa/BondPositionHistoricalDataSoa.hpp"
 #include "BondService/HistoricalDataSoa/BondRiskHistoricalDataSoa.hpp"
 #include "BondService/HistoricalDataSoa/BondStreamingHistoricalDataSoa.hpp"
+#include "AsyncServiceListener.hpp"
+#include "ConflatingServiceListener.hpp"
+#include "StaticPipeline.hpp"
+#include "ServiceGraphRunner.hpp"
 #include "StopWatch.hpp"
+#include "SecuritiesMaster.hpp"
+#include <sys/stat.h> // Unix only
 
 int main()
 {
@@ -57,50 +66,91 @@ int main()
 	std::string executionoutputPath("./Data/execution.txt");
 	std::string inquiryoutputPath("./Data/allinquiry.txt");
 
-	// product information (hard-coded) (latest data)
-	Bond treasury2Y("9128283H1", CUSIP, "T", 1.750,
-                    boost::gregorian::date(2019,Nov,30)); // 2Y bond
-	Bond treasury3Y("9128283G3", CUSIP, "T", 1.750,
-                    boost::gregorian::date(2020,Nov,15)); // 3Y bond
-	Bond treasury5Y("912828M80", CUSIP, "T", 2.000,
-                    boost::gregorian::date(2022,Nov,30)); // 5Y bond
-	Bond treasury7Y("9128283J7", CUSIP, "T", 2.125,
-                    boost::gregorian::date(2024,Nov,30)); // 7Y bond
-	Bond treasury10Y("9128283F5", CUSIP, "T", 2.25,
-                     boost::gregorian::date(2027,Nov,15)); // 10Y bond
-	Bond treasury30Y("912810RZ3", CUSIP, "T", 2.75,
-                     boost::gregorian::date(2047,Nov,15)); // 30Y bond
+	// reference data of the bonds, their PV01s and their bucketed sectors (the securities master)
+	// written with the treasuries (and this # of synthetic bonds) if there is none yet, then loaded at start-up
+	// (from its binary image ./Data/bonds.txt.bin if useReferenceImage and the file is unchanged)
+	std::string referenceinputPath("./Data/bonds.txt");
+	long syntheticBonds = 0;
+	bool useReferenceImage = true;
+	struct stat referenceInfo;
+	if (::stat(referenceinputPath.c_str(), &referenceInfo) != 0)
+		bond_reference_generator(referenceinputPath, syntheticBonds);
+	SecuritiesMaster securitiesMaster;
+	if (!securitiesMaster.Load(referenceinputPath, useReferenceImage))
+	{
+		std::cout << "Oh no! Cannot open the file! Maybe the path is not right?\n";
+		return 1;
+	}
+	securitiesMaster.Report(std::cout);
+	if (securitiesMaster.GetSize() == 0)
+	{
+		std::cout << "Oh no! No bond in the securities master " << referenceinputPath << "!\n";
+		return 1;
+	}
 
 	// bond product service
 	BondProductService bondProductService;
-	bondProductService.Add(treasury2Y);
-	bondProductService.Add(treasury3Y);
-	bondProductService.Add(treasury5Y);
-	bondProductService.Add(treasury7Y);
-	bondProductService.Add(treasury10Y);
-	bondProductService.Add(treasury30Y);
-
-	// pv01 information (hard-coded) (latest data)
-	std::unordered_map<string,double> pv01Treasury;
-	pv01Treasury.insert(std::make_pair(treasury2Y.GetProductId(), 0.0185));
-	pv01Treasury.insert(std::make_pair(treasury3Y.GetProductId(), 0.01034));
-	pv01Treasury.insert(std::make_pair(treasury5Y.GetProductId(), 0.0176));
-	pv01Treasury.insert(std::make_pair(treasury7Y.GetProductId(), 0.02215));
-	pv01Treasury.insert(std::make_pair(treasury10Y.GetProductId(), 0.0202));
-	pv01Treasury.insert(std::make_pair(treasury30Y.GetProductId(), 0.0275));
+	securitiesMaster.AddBonds(bondProductService);
+
+	// pv01 information
+	std::unordered_map<string,double> pv01Treasury = securitiesMaster.GetPV01s();
 
 	// bucketed sector information
-	std::vector<std::string> frontEnd = { treasury2Y.GetProductId() , treasury3Y.GetProductId() }; // front end
-	std::vector<std::string> belly = { treasury5Y.GetProductId() , treasury7Y.GetProductId(), treasury10Y.GetProductId() }; // belly
-	std::vector<std::string> longEnd = { treasury30Y.GetProductId() }; // long end
-	std::unordered_map<std::string, std::vector<std::string>> bucketTreasury;
-	bucketTreasury.insert(std::make_pair("FrontEnd", frontEnd));
-	bucketTreasury.insert(std::make_pair("Belly", belly));
-	bucketTreasury.insert(std::make_pair("LongEnd", longEnd));
+	std::unordered_map<std::string, std::vector<std::string>> bucketTreasury = securitiesMaster.GetBuckets();
 
 	// define a stop watch to record the time
 	StopWatch sw;
 
+	// dispatch mode of the heavy service hops:
+	// if true, the downstream service runs on its own thread fed by a bounded SPSC ring
+	bool asyncDispatch = true;
+
+	// whether the hops of the price line (algo streaming ==> streaming ==> historical data)
+	// are wired at compile time as a static pipeline instead of through runtime listeners
+	bool fusedPricingLine = true;
+
+	// whether the market data are handed over as incremental price level updates (the algo execution
+	// then runs only when the top of the book moves) instead of full order book snapshots
+	bool incrementalMarketData = true;
+
+	// whether the slow consumers (the GUI and the algo execution) only take the newest pending price/order book
+	// of each product, dropping the older ones, instead of processing every one of them in order
+	bool conflateSlowConsumers = false;
+
+	// whether the four service lines run concurrently (each on its own thread) or one after the other
+	bool concurrentLines = true;
+
+	// # of threads parsing the chunks of price.txt and of marketdata.txt each (0 for one per core),
+	// the records still reach the services in file order
+	size_t parseThreads = 0;
+
+	// scale of the simulated price.txt and marketdata.txt: # of rows of each product, # of products
+	// (0 for all the bonds of the ticker) and # of threads formatting them (0 for one per core)
+	long rowsPerProduct = 1000000;
+	size_t productCount = 0;
+	size_t generatorThreads = 0;
+
+	// whether the price and market data generators hand over typed records to the connectors through in-memory pipes
+	// (the lines then run the generators alongside the connectors, price.txt and marketdata.txt are not written)
+	// to measure the throughput of the service graph without the file I/O and the parsing
+	bool pipeInputs = false;
+
+	// durability of the historical data files, written by a group commit writer each:
+	// fsync after this # of records and/or every this # of milliseconds (0 leaves it to the OS)
+	size_t syncEveryRecords = 0;
+	long syncEveryMillis = 100;
+
+	// whether the historical data are appended to binary journals (./Data/position.000000.jnl, ...) instead of 
+	// the csv files, which then only keep their header (./tradingsystem_journaldecoder turns the journals into csv)
+	bool binaryJournal = false;
+	std::unique_ptr<JournalWriter> positionJournal, riskJournal, streamingJournal, executionJournal, inquiryJournal;
+
+	// the positions and the PV01s are snapshot every this # of updates (./Data/position.snp and ./Data/risk.snp);
+	// on a restart they are restored from the snapshots and the binary journals of the previous run
+	// (then the trades of trade.txt are booked on top of the restored positions)
+	size_t snapshotEveryUpdates = 10000;
+	bool restartFromSnapshot = false;
+
 	std::cout << "=====================================================\n";
 
 	std::cout << "=================== II. Generate data ========================\n";
@@ -112,17 +162,22 @@ int main()
 	std::cout << "Time for trade.txt: " << sw.GetTime() << " seconds\n\n";
 	sw.Reset();
 
-	sw.StartStopWatch();
-	bond_price_generator(priceinputPath, &bondProductService, "T"); // price.txt
-	sw.StopStopWatch();
-	std::cout << "Time for price.txt: " << sw.GetTime() << " seconds\n\n";
-	sw.Reset();
-
-	sw.StartStopWatch();
-	bond_market_data_generator(marketdatainputPath, &bondProductService, "T"); // marketdata.txt
-	sw.StopStopWatch();
-	std::cout << "Time for marketdata.txt: " << sw.GetTime() << " seconds\n\n";
-	sw.Reset();
+	if (!pipeInputs)
+	{
+		sw.StartStopWatch();
+		bond_price_generator(priceinputPath, &bondProductService, "T", rowsPerProduct, productCount, 
+			generatorThreads); // price.txt
+		sw.StopStopWatch();
+		std::cout << "Time for price.txt: " << sw.GetTime() << " seconds\n\n";
+		sw.Reset();
+
+		sw.StartStopWatch();
+		bond_market_data_generator(marketdatainputPath, &bondProductService, "T", rowsPerProduct, productCount, 
+			generatorThreads); // marketdata.txt
+		sw.StopStopWatch();
+		std::cout << "Time for marketdata.txt: " << sw.GetTime() << " seconds\n\n";
+		sw.Reset();
+	}
 
 	sw.StartStopWatch();
 	bond_inquiry_generator(inquiryinputPath, &bondProductService, "T"); // inquiry.txt
@@ -134,96 +189,144 @@ int main()
 
 	std::cout << "=================== III. Run services ========================\n";
 
-	std::cout << "(a) trade.txt ==> position.txt and risk.txt\n";
-
+	// (a) trade.txt ==> position.txt and risk.txt
 	// build service components
 	BondTradeBookingService bondTradeBookingService;
 	BondPositionService bondPositionService(&bondProductService, "T");
 	BondPositionListener bondPositionListener(&bondPositionService);
  	BondRiskService bondRiskService(&bondProductService, pv01Treasury);
 	BondRiskListener bondRiskListener(&bondRiskService);
-	BondRiskHistoricalDataConnector bondRiskHistoricalDataConnector(riskoutputPath);
-	BondRiskHistoricalDataService bondRiskHistoricalDataService(&bondRiskHistoricalDataConnector);
+	BondRiskHistoricalDataConnector bondRiskHistoricalDataConnector(riskoutputPath, 
+		syncEveryRecords, syncEveryMillis);
+	BondRiskHistoricalDataService bondRiskHistoricalDataService(&bondRiskHistoricalDataConnector, &bondProductService);
 	BondRiskHistoricalDataListener bondRiskHistoricalDataListener(&bondProductService, 
 		&bondRiskHistoricalDataService, &bondRiskService, bucketTreasury);
-	BondPositionHistoricalDataConnector bondPositionHistoricalDataConnector(positionoutputPath);
-	BondPositionHistoricalDataService bondPositionHistoricalDataService(&bondPositionHistoricalDataConnector);
+	BondPositionHistoricalDataConnector bondPositionHistoricalDataConnector(positionoutputPath, 
+		syncEveryRecords, syncEveryMillis);
+	BondPositionHistoricalDataService bondPositionHistoricalDataService(&bondPositionHistoricalDataConnector, &bondProductService);
 	BondPositionHistoricalDataListener bondPositionHistoricalDataListener(&bondPositionHistoricalDataService);
+	// the async and conflating listeners run a thread (and hold a ring) each: only those of the selected modes are built
+	std::unique_ptr<AsyncServiceListener<Position<Bond>>> asyncPositionHistoricalDataListener;
 
 	// link the service components
 	bondTradeBookingService.AddListener(&bondPositionListener);
 	bondPositionService.AddListener(&bondRiskListener);
-	bondPositionService.AddListener(&bondPositionHistoricalDataListener);
+	if (asyncDispatch)
+	{
+		asyncPositionHistoricalDataListener.reset(new AsyncServiceListener<Position<Bond>>(&bondPositionHistoricalDataListener));
+		bondPositionService.AddListener(asyncPositionHistoricalDataListener.get());
+	}
+	else bondPositionService.AddListener(&bondPositionHistoricalDataListener);
 	bondRiskService.AddListener(&bondRiskHistoricalDataListener);
 
-	// start
-	sw.StartStopWatch();
-	BondTradeBookingConnector bondTradeBookingConnector(tradeinputPath, &bondTradeBookingService, &bondProductService);
-	sw.StopStopWatch();
-	std::cout << "Time elapse: " << sw.GetTime() << " seconds\n\n";
-	sw.Reset();
-
-	//std::cout << "(b) price.txt ==> streaming.txt and gui.txt\n";
-
+	// (b) price.txt ==> streaming.txt and gui.txt
 	// build service components
 	int throttleVal = 300; // miliseconds
-	BondPricingService bondPricingService;
-	BondAlgoStreamingService bondAlgoStreamingService;
+	BondPricingService bondPricingService(&bondProductService);
+	BondAlgoStreamingService bondAlgoStreamingService(&bondProductService);
 	BondAlgoStreamingListener bondAlgoStreamingListener(&bondAlgoStreamingService);
-	BondStreamingService bondStreamingService;
+	BondStreamingService bondStreamingService(&bondProductService);
 	BondStreamingListener bondStreamingListener(&bondStreamingService);
-	BondStreamingHistoricalDataConnector bondStreamingHistoricalDataConnector(streamoutputPath);
-	BondStreamingHistoricalDataService bondStreamingHistoricalDataService(&bondStreamingHistoricalDataConnector);
+	BondStreamingHistoricalDataConnector bondStreamingHistoricalDataConnector(streamoutputPath, 
+		syncEveryRecords, syncEveryMillis);
+	BondStreamingHistoricalDataService bondStreamingHistoricalDataService(&bondStreamingHistoricalDataConnector, &bondProductService);
 	BondStreamingHistoricalDataListener bondStreamingHistoricalDataListener(&bondStreamingHistoricalDataService);
 	BondGUIConnector bondGUIConnector(guioutputPath);
-	BondGUIService bondGUIService(throttleVal, &bondGUIConnector);
+	BondGUIService bondGUIService(throttleVal, &bondGUIConnector, &bondProductService);
 	BondGUIListener bondGUIListener(&bondGUIService);
+	auto pricingPipeline = MakePipeline(BondAlgoStreamingStage(&bondAlgoStreamingService), 
+		BondStreamingStage(&bondStreamingService), BondStreamingHistoricalDataStage(&bondStreamingHistoricalDataService));
+	StaticPipelineListener<Price<Bond>, decltype(pricingPipeline)> pricingPipelineListener(&pricingPipeline);
+	ServiceListener<Price<Bond>>* algoStreamingListener = &bondAlgoStreamingListener;
+	if (fusedPricingLine) algoStreamingListener = &pricingPipelineListener;
+	std::unique_ptr<AsyncServiceListener<Price<Bond>>> asyncAlgoStreamingListener;
+	std::unique_ptr<AsyncServiceListener<PriceStream<Bond>>> asyncStreamingHistoricalDataListener;
+	std::unique_ptr<ConflatingServiceListener<Price<Bond>>> conflatingGUIListener;
 
 	// link the service components
-	bondPricingService.AddListener(&bondAlgoStreamingListener);
-	bondPricingService.AddListener(&bondGUIListener);
-	bondAlgoStreamingService.AddListener(&bondStreamingListener);
-	bondStreamingService.AddListener(&bondStreamingHistoricalDataListener);
-
-	// start
-	sw.StartStopWatch();
-	BondPricingConnector bondPricingConnector(priceinputPath, &bondPricingService, &bondProductService);
-	sw.StopStopWatch();
-	std::cout << "Time elapse: " << sw.GetTime() << " seconds\n\n";
-	sw.Reset();
-
-	std::cout << "(c) marketdata.txt ==> execution.txt, position.txt and risk.txt\n";
-
+	if (asyncDispatch)
+	{
+		asyncAlgoStreamingListener.reset(new AsyncServiceListener<Price<Bond>>(algoStreamingListener));
+		bondPricingService.AddListener(asyncAlgoStreamingListener.get());
+	}
+	else bondPricingService.AddListener(algoStreamingListener);
+	if (conflateSlowConsumers)
+	{
+		conflatingGUIListener.reset(new ConflatingServiceListener<Price<Bond>>(&bondGUIListener));
+		bondPricingService.AddListener(conflatingGUIListener.get());
+	}
+	else bondPricingService.AddListener(&bondGUIListener);
+	if (!fusedPricingLine)
+	{
+		bondAlgoStreamingService.AddListener(&bondStreamingListener);
+		if (asyncDispatch)
+		{
+			asyncStreamingHistoricalDataListener.reset(
+				new AsyncServiceListener<PriceStream<Bond>>(&bondStreamingHistoricalDataListener));
+			bondStreamingService.AddListener(asyncStreamingHistoricalDataListener.get());
+		}
+		else bondStreamingService.AddListener(&bondStreamingHistoricalDataListener);
+	}
+
+	// (c) marketdata.txt ==> execution.txt, position.txt and risk.txt
 	// build service components
-	BondMarketDataService bondMarketDataService;
-	BondAlgoExecutionService bondAlgoExecutionService;
+	BondMarketDataService bondMarketDataService(&bondProductService);
+	BondAlgoExecutionService bondAlgoExecutionService(&bondProductService);
 	BondAlgoExecutionListener bondAlgoExecutionListener(&bondAlgoExecutionService);
-	BondExecutionService bondExecutionService;
+	BondAlgoExecutionDeltaListener bondAlgoExecutionDeltaListener(&bondAlgoExecutionService);
+	BondExecutionService bondExecutionService(&bondProductService);
 	BondExecutionListener bondExecutionListener(&bondExecutionService);
 	BondTradeBookingListener bondTradeBookingListener(&bondTradeBookingService);
-	BondExecutionHistoricalDataConnector bondExecutionHistoricalDataConnector(executionoutputPath);
-	BondExecutionHistoricalDataService bondExecutionHistoricalDataService(&bondExecutionHistoricalDataConnector);
+	BondExecutionHistoricalDataConnector bondExecutionHistoricalDataConnector(executionoutputPath, 
+		syncEveryRecords, syncEveryMillis);
+	BondExecutionHistoricalDataService bondExecutionHistoricalDataService(&bondExecutionHistoricalDataConnector, &bondProductService);
 	BondExecutionHistoricalDataListener bondExecutionHistoricalDataListener(&bondExecutionHistoricalDataService);
+	std::unique_ptr<AsyncServiceListener<OrderBook<Bond>>> asyncAlgoExecutionListener;
+	std::unique_ptr<AsyncServiceListener<OrderBookDelta<Bond>>> asyncAlgoExecutionDeltaListener;
+	std::unique_ptr<ConflatingServiceListener<OrderBook<Bond>>> conflatingAlgoExecutionListener;
+	std::unique_ptr<ConflatingServiceListener<OrderBookDelta<Bond>>> conflatingAlgoExecutionDeltaListener;
+	std::unique_ptr<AsyncServiceListener<ExecutionOrder<Bond>>> asyncExecutionHistoricalDataListener;
 
 	// link the service components
-	bondMarketDataService.AddListener(&bondAlgoExecutionListener);
+	if (incrementalMarketData && conflateSlowConsumers)
+	{
+		conflatingAlgoExecutionDeltaListener.reset(
+			new ConflatingServiceListener<OrderBookDelta<Bond>>(&bondAlgoExecutionDeltaListener));
+		bondMarketDataService.AddDeltaListener(conflatingAlgoExecutionDeltaListener.get());
+	}
+	else if (incrementalMarketData && asyncDispatch)
+	{
+		asyncAlgoExecutionDeltaListener.reset(new AsyncServiceListener<OrderBookDelta<Bond>>(&bondAlgoExecutionDeltaListener));
+		bondMarketDataService.AddDeltaListener(asyncAlgoExecutionDeltaListener.get());
+	}
+	else if (incrementalMarketData) bondMarketDataService.AddDeltaListener(&bondAlgoExecutionDeltaListener);
+	else if (conflateSlowConsumers)
+	{
+		conflatingAlgoExecutionListener.reset(new ConflatingServiceListener<OrderBook<Bond>>(&bondAlgoExecutionListener));
+		bondMarketDataService.AddListener(conflatingAlgoExecutionListener.get());
+	}
+	else if (asyncDispatch)
+	{
+		asyncAlgoExecutionListener.reset(new AsyncServiceListener<OrderBook<Bond>>(&bondAlgoExecutionListener));
+		bondMarketDataService.AddListener(asyncAlgoExecutionListener.get());
+	}
+	else bondMarketDataService.AddListener(&bondAlgoExecutionListener);
 	bondAlgoExecutionService.AddListener(&bondExecutionListener);
 	bondExecutionService.AddListener(&bondTradeBookingListener);
-	bondExecutionService.AddListener(&bondExecutionHistoricalDataListener);
+	if (asyncDispatch)
+	{
+		asyncExecutionHistoricalDataListener.reset(
+			new AsyncServiceListener<ExecutionOrder<Bond>>(&bondExecutionHistoricalDataListener));
+		bondExecutionService.AddListener(asyncExecutionHistoricalDataListener.get());
+	}
+	else bondExecutionService.AddListener(&bondExecutionHistoricalDataListener);
 	
-	// start
-	sw.StartStopWatch();
-	BondMarketDataConnector bondMarketDataConnector(marketdatainputPath, &bondMarketDataService, &bondProductService);
-	sw.StopStopWatch();
-	std::cout << "Time elapse: " << sw.GetTime() << " seconds\n\n";
-	sw.Reset();
-
-	std::cout << "(d) inquiry.txt ==> allinquiry.txt\n";
-
+	// (d) inquiry.txt ==> allinquiry.txt
 	// build service components
 	BondInquiryService bondInquiryService;
 	BondInquiryListener bondInquiryListener(&bondInquiryService);
-	BondInquiryHistoricalDataConnector bondInquiryHistoricalDataConnector(inquiryoutputPath);
+	BondInquiryHistoricalDataConnector bondInquiryHistoricalDataConnector(inquiryoutputPath, 
+		syncEveryRecords, syncEveryMillis);
 	BondInquiryHistoricalDataService bondInquiryHistoricalDataService(&bondInquiryHistoricalDataConnector);
 	BondInquiryHistoricalDataListener bondInquiryHistoricalDataListener(&bondInquiryHistoricalDataService);
 
@@ -231,15 +334,178 @@ int main()
 	bondInquiryService.AddListener(&bondInquiryHistoricalDataListener);
 	bondInquiryService.AddListener(&bondInquiryListener);
 
+	// the snapshots, and the restart from the previous run (before its journals are overwritten)
+	bondPositionService.SetSnapshot("./Data/position.snp", snapshotEveryUpdates);
+	bondRiskService.SetSnapshot("./Data/risk.snp", snapshotEveryUpdates);
+	if (restartFromSnapshot)
+	{
+		sw.StartStopWatch();
+		long positionsReplayed = bondPositionService.Restore("./Data/position");
+		long risksReplayed = bondRiskService.Restore("./Data/risk", bucketTreasury);
+		sw.StopStopWatch();
+		if (positionsReplayed < 0 || risksReplayed < 0)
+			std::cout << "Oh no! No snapshot to restart from! Starting from zero positions instead.\n";
+		else
+			std::cout << "Restored the positions and the PV01s from the snapshots and " << positionsReplayed 
+				<< " position and " << risksReplayed << " risk journal records in " << sw.GetTime() << " seconds\n\n";
+		sw.Reset();
+	}
+
+	if (binaryJournal)
+	{
+		size_t segmentBytes = 64 << 20;
+		positionJournal.reset(new JournalWriter("./Data/position", segmentBytes, syncEveryRecords, syncEveryMillis));
+		riskJournal.reset(new JournalWriter("./Data/risk", segmentBytes, syncEveryRecords, syncEveryMillis));
+		streamingJournal.reset(new JournalWriter("./Data/streaming", segmentBytes, syncEveryRecords, syncEveryMillis));
+		executionJournal.reset(new JournalWriter("./Data/execution", segmentBytes, syncEveryRecords, syncEveryMillis));
+		inquiryJournal.reset(new JournalWriter("./Data/allinquiry", segmentBytes, syncEveryRecords, syncEveryMillis));
+	}
+
+	// the historical data go to the binary journals (no-op if they are not set up)
+	bondPositionHistoricalDataConnector.SetJournal(positionJournal.get());
+	bondRiskHistoricalDataConnector.SetJournal(riskJournal.get());
+	bondStreamingHistoricalDataConnector.SetJournal(streamingJournal.get());
+	bondExecutionHistoricalDataConnector.SetJournal(executionJournal.get());
+	bondInquiryHistoricalDataConnector.SetJournal(inquiryJournal.get());
+	bondPositionHistoricalDataService.SetJournal(positionJournal.get());
+	bondRiskHistoricalDataService.SetJournal(riskJournal.get());
+	bondPositionService.SetJournal(positionJournal.get()); // recorded in the snapshots, for the next restart
+	bondRiskService.SetJournal(riskJournal.get());
+	bondStreamingHistoricalDataService.SetJournal(streamingJournal.get());
+	bondExecutionHistoricalDataService.SetJournal(executionJournal.get());
+	bondInquiryHistoricalDataService.SetJournal(inquiryJournal.get());
+
+	// the snapshots of the restored state, recorded against the journals of this run
+	// (a restart before the next periodic snapshot replays them)
+	if (restartFromSnapshot)
+	{
+		bondPositionService.SaveSnapshot();
+		bondRiskService.SaveSnapshot();
+	}
+
+	// the service graph: each line reads its input file through the subscribe connector
+	// and waits until its queued hops are drained
+	// (the trade line and the execution line share the bond trade booking service, so the position hop
+	// is drained once both are done, and timed on its own)
+	ServiceGraphRunner runner;
+	runner.AddLine("(a) trade.txt ==> position.txt and risk.txt", [&]() {
+		BondTradeBookingConnector bondTradeBookingConnector(tradeinputPath, &bondTradeBookingService, &bondProductService);
+		return bondTradeBookingConnector.GetRecordCount();
+	});
+	runner.AddLine("(b) price.txt ==> streaming.txt and gui.txt", [&]() {
+		std::unique_ptr<BondPricingConnector> bondPricingConnector;
+		if (pipeInputs)
+		{
+			RecordPipe<Price<Bond>> pipe;
+			std::thread generator([&]() { 
+				bond_price_generator(&pipe, &bondProductService, "T", rowsPerProduct, productCount); });
+			bondPricingConnector.reset(new BondPricingConnector(&pipe, &bondPricingService));
+			generator.join();
+		}
+		else
+		{
+			bondPricingConnector.reset(new BondPricingConnector(priceinputPath, &bondPricingService, &bondProductService, 
+				1024, parseThreads));
+		}
+		if (asyncAlgoStreamingListener) asyncAlgoStreamingListener->Flush();
+		if (asyncStreamingHistoricalDataListener) asyncStreamingHistoricalDataListener->Flush();
+		if (conflatingGUIListener) conflatingGUIListener->Flush();
+		return bondPricingConnector->GetRecordCount();
+	});
+	runner.AddLine("(c) marketdata.txt ==> execution.txt, position.txt and risk.txt", [&]() {
+		std::unique_ptr<BondMarketDataConnector> bondMarketDataConnector;
+		if (pipeInputs)
+		{
+			RecordPipe<BondMarketDataRow> pipe;
+			std::thread generator([&]() {
+				bond_market_data_generator(&pipe, &bondProductService, "T", rowsPerProduct, productCount); });
+			bondMarketDataConnector.reset(new BondMarketDataConnector(&pipe, &bondMarketDataService, 
+				1024, incrementalMarketData));
+			generator.join();
+		}
+		else
+		{
+			bondMarketDataConnector.reset(new BondMarketDataConnector(marketdatainputPath, &bondMarketDataService, 
+				&bondProductService, 1024, incrementalMarketData, parseThreads));
+		}
+		if (asyncAlgoExecutionListener) asyncAlgoExecutionListener->Flush();
+		if (asyncAlgoExecutionDeltaListener) asyncAlgoExecutionDeltaListener->Flush();
+		if (conflatingAlgoExecutionListener) conflatingAlgoExecutionListener->Flush();
+		if (conflatingAlgoExecutionDeltaListener) conflatingAlgoExecutionDeltaListener->Flush();
+		if (asyncExecutionHistoricalDataListener) asyncExecutionHistoricalDataListener->Flush();
+		return bondMarketDataConnector->GetRecordCount();
+	});
+	runner.AddLine("(d) inquiry.txt ==> allinquiry.txt", [&]() {
+		BondInquiryConnector bondInquiryConnector(inquiryinputPath, &bondInquiryService, &bondProductService);
+		return bondInquiryConnector.GetRecordCount();
+	});
+
 	// start
+	runner.Run(concurrentLines);
 	sw.StartStopWatch();
-	BondInquiryConnector bondInquiryConnector(inquiryinputPath, &bondInquiryService, &bondProductService);
+	if (asyncPositionHistoricalDataListener) asyncPositionHistoricalDataListener->Flush();
 	sw.StopStopWatch();
-	std::cout << "Time elapse: " << sw.GetTime() << " seconds\n\n";
+	double positionDrainSeconds = sw.GetTime();
 	sw.Reset();
+	bondPositionService.SaveSnapshot();
+	bondRiskService.SaveSnapshot();
+	std::cout << "\n";
+	runner.Report(std::cout);
+	std::cout << "Position historical data (trade and execution lines) drained in " << positionDrainSeconds << " seconds\n";
+	if (conflateSlowConsumers)
+	{
+		std::cout << "Conflation: GUI processed " << conflatingGUIListener->GetProcessedCount() << " prices, dropped "
+			<< conflatingGUIListener->GetDroppedCount() << "\n";
+		if (incrementalMarketData)
+			std::cout << "Conflation: algo execution processed " << conflatingAlgoExecutionDeltaListener->GetProcessedCount()
+				<< " order books, dropped " << conflatingAlgoExecutionDeltaListener->GetDroppedCount() << "\n";
+		else
+			std::cout << "Conflation: algo execution processed " << conflatingAlgoExecutionListener->GetProcessedCount()
+				<< " order books, dropped " << conflatingAlgoExecutionListener->GetDroppedCount() << "\n";
+	}
+
+	// the historical data files
+	GroupCommitWriter* writers[5] = { &bondPositionHistoricalDataConnector.GetWriter(), 
+		&bondRiskHistoricalDataConnector.GetWriter(), &bondStreamingHistoricalDataConnector.GetWriter(),
+		&bondExecutionHistoricalDataConnector.GetWriter(), &bondInquiryHistoricalDataConnector.GetWriter() };
+	std::cout << "\nGroup commit of the historical data:\n";
+	for (GroupCommitWriter* writer : writers)
+	{
+		writer->Flush();
+		writer->Report(std::cout);
+	}
+	if (binaryJournal)
+	{
+		JournalWriter* journals[5] = { positionJournal.get(), riskJournal.get(), streamingJournal.get(),
+			executionJournal.get(), inquiryJournal.get() };
+		std::cout << "\nBinary journals of the historical data:\n";
+		for (JournalWriter* journal : journals)
+		{
+			journal->Flush();
+			journal->Report(std::cout);
+		}
+
+		// indexed query of the journal: only the blocks holding the bond are mapped
+		// (the 5Y treasury, if the securities master has it)
+		const Bond* treasury5Y = bondProductService.GetTable().Find("912828M80");
+		if (treasury5Y == nullptr)
+			std::cout << "\nOh no! No bond 912828M80 in the securities master to query the risk journal for!\n";
+		else
+		{
+			StopWatch queryWatch;
+			queryWatch.StartStopWatch();
+			std::vector<JournalEntry<PV01Record>> pv01s = bondRiskHistoricalDataService.QueryRisk(*treasury5Y);
+			queryWatch.StopStopWatch();
+			std::cout << "\nPV01 of " << treasury5Y->GetProductId() << " in the risk journal: " << pv01s.size()
+				<< " records found in " << queryWatch.GetTime() << " seconds";
+			if (!pv01s.empty())
+				std::cout << ", last PV01 " << pv01s.back().record.pv01 << " on " << pv01s.back().record.quantity;
+			std::cout << "\n";
+		}
+	}
 
 	std::cout << "==============================================================\n";
 
 
 	return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include "soa.hpp"
+#include "TickPrice.hpp"
 
 using namespace std;
 
@@ -25,11 +26,11 @@ class Order
 public:
 
   // ctor for an order
-  Order(double _price, long _quantity, PricingSide _side);
+  Order(TickPrice _price, long _quantity, PricingSide _side);
   Order() {}
 
   // Get the price on the order
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the quantity on the order
   long GetQuantity() const;
@@ -38,7 +39,7 @@ public:
   PricingSide GetSide() const;
 
 private:
-  double price;
+  TickPrice price;
   long quantity;
   PricingSide side;
 
@@ -91,8 +92,8 @@ public:
   // Get the offer stack
   const vector<Order>& GetOfferStack() const;
 
-  // Get the best bid/offer pair
-  const BidOffer& GetBestBidOffer() const;
+  // Get the best bid/offer pair (by value, an empty stack gives a zero order)
+  BidOffer GetBestBidOffer() const;
 
 private:
   T product;
@@ -113,21 +114,21 @@ class MarketDataService : public Service<string,OrderBook <T> >
 public:
 
   // Get the best bid/offer order
-  virtual const BidOffer& GetBestBidOffer(const string &productId) = 0;
+  virtual BidOffer GetBestBidOffer(const string &productId) = 0;
 
   // Aggregate the order book
   virtual const OrderBook<T>& AggregateDepth(const string &productId) = 0;
 
 };
 
-Order::Order(double _price, long _quantity, PricingSide _side)
+Order::Order(TickPrice _price, long _quantity, PricingSide _side)
 {
   price = _price;
   quantity = _quantity;
   side = _side;
 }
 
-double Order::GetPrice() const
+TickPrice Order::GetPrice() const
 {
   return price;
 }
@@ -182,10 +183,10 @@ const vector<Order>& OrderBook<T>::GetOfferStack() const
 }
 
 template<typename T>
-const BidOffer& OrderBook<T>::GetBestBidOffer() const
+BidOffer OrderBook<T>::GetBestBidOffer() const
 {
-	// find the bid order with the highest bid price
-	Order maxBidOrder = bidStack[0];
+	// find the bid order with the highest bid price (a zero order if there is no bid)
+	Order maxBidOrder = bidStack.empty() ? Order(TickPrice(), 0, BID) : bidStack[0];
 	int nBid = bidStack.size();
 	for (int i = 1; i < nBid; i++)
 	{
@@ -193,8 +194,8 @@ const BidOffer& OrderBook<T>::GetBestBidOffer() const
 			maxBidOrder = bidStack[i];
 	}
 
-	// find the offer order with the lowest offer price
-	Order minOfferOrder = offerStack[0];
+	// find the offer order with the lowest offer price (a zero order if there is no offer)
+	Order minOfferOrder = offerStack.empty() ? Order(TickPrice(), 0, OFFER) : offerStack[0];
 	int nOffer = offerStack.size();
 	for (int i = 1; i < nOffer; i++)
 	{
@@ -202,8 +203,7 @@ const BidOffer& OrderBook<T>::GetBestBidOffer() const
 			minOfferOrder = offerStack[i];
 	}
 
-	BidOffer temp(maxBidOrder, minOfferOrder);
-	return temp;
+	return BidOffer(maxBidOrder, minOfferOrder);
 }
 
 #endif
@@ -9,6 +9,7 @@
 
 #include <string>
 #include "soa.hpp"
+#include "TickPrice.hpp"
 
 /**
  * A price object consisting of mid and bid/offer spread.
@@ -21,22 +22,22 @@ class Price
 public:
 
   // ctor for a price
-  Price(const T &_product, double _mid, double _bidOfferSpread);
+  Price(const T &_product, TickPrice _mid, TickPrice _bidOfferSpread);
   Price() {} 
 
   // Get the product
   const T& GetProduct() const;
 
   // Get the mid price
-  double GetMid() const;
+  TickPrice GetMid() const;
 
   // Get the bid/offer spread around the mid
-  double GetBidOfferSpread() const;
+  TickPrice GetBidOfferSpread() const;
 
 private:
   T product; // revised
-  double mid;
-  double bidOfferSpread;
+  TickPrice mid;
+  TickPrice bidOfferSpread;
 
 };
 
@@ -51,7 +52,7 @@ class PricingService : public Service<string,Price <T> >
 };
 
 template<typename T>
-Price<T>::Price(const T &_product, double _mid, double _bidOfferSpread) :
+Price<T>::Price(const T &_product, TickPrice _mid, TickPrice _bidOfferSpread) :
   product(_product)
 {
   mid = _mid;
@@ -65,13 +66,13 @@ const T& Price<T>::GetProduct() const
 }
 
 template<typename T>
-double Price<T>::GetMid() const
+TickPrice Price<T>::GetMid() const
 {
   return mid;
 }
 
 template<typename T>
-double Price<T>::GetBidOfferSpread() const
+TickPrice Price<T>::GetBidOfferSpread() const
 {
   return bidOfferSpread;
 }
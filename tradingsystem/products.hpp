@@ -9,14 +9,27 @@
 
 #include <iostream>
 #include <string>
+#include <cstdint>
+#include <type_traits>
 
 #include "boost/date_time/gregorian/gregorian.hpp"
+#include "FixedString.hpp"
 
 using namespace std;
 using namespace boost::gregorian;
 
 enum ProductType { IRSWAP, BOND };
 
+// Dense integer handle of a product, assigned by its product service at registration
+typedef int ProductHandle;
+const ProductHandle NO_PRODUCT_HANDLE = -1;
+
+// Product identifier stored inline (up to 12 characters, the length of an ISIN; a CUSIP has 9)
+typedef FixedString<12> ProductId;
+
+// Bond ticker stored inline (up to 8 characters)
+typedef FixedString<8> Ticker;
+
 /**
  * Base class for a product.
  */
@@ -29,14 +42,21 @@ public:
   Product(string _productId, ProductType _productType);
 
   // Get the product identifier
-  const string& GetProductId() const;
+  const ProductId& GetProductId() const;
 
   // Ge the product type
   ProductType GetProductType() const;
 
+  // Get the product handle (NO_PRODUCT_HANDLE if the product is not registered)
+  ProductHandle GetHandle() const;
+
+  // Set the product handle (called by the product service at registration)
+  void SetHandle(ProductHandle _handle);
+
 private:
-  string productId;
+  ProductId productId;
   ProductType productType;
+  ProductHandle handle;
 
 };
 
@@ -44,6 +64,7 @@ enum BondIdType { CUSIP, ISIN };
 
 /**
  * Bond product class
+ * Trivially copyable: the identifier and the ticker are stored inline and the maturity date as its day number
  */
 class Bond : public Product
 {
@@ -55,13 +76,16 @@ public:
   Bond();
 
   // Get the ticker
-  const string& GetTicker() const;
+  const Ticker& GetTicker() const;
 
   // Get the coupon
   float GetCoupon() const;
 
   // Get the maturity date
-  const date& GetMaturityDate() const;
+  date GetMaturityDate() const;
+
+  // Get the maturity date as a serial date (its day number, 0 for none)
+  std::int32_t GetMaturitySerialDate() const;
 
   // Get the bond identifier type
   BondIdType GetBondIdType() const;
@@ -70,14 +94,16 @@ public:
   friend ostream& operator<<(ostream &output, const Bond &bond);
 
 private:
-  string productId;
   BondIdType bondIdType;
-  string ticker;
+  Ticker ticker;
   float coupon;
-  date maturityDate;
+  std::int32_t maturitySerialDate;
 
 };
 
+// a Bond is copied by value into every order book, price, trade, position, PV01, inquiry...
+static_assert(std::is_trivially_copyable<Bond>::value, "Bond should be trivially copyable");
+
 /**
  * Interest Rate Swap enums
  */
@@ -161,11 +187,14 @@ private:
 
 Product::Product(string _productId, ProductType _productType)
 {
+  if (!ProductId::Fits(_productId))
+    std::cout << "Oh no! The product identifier " << _productId << " is longer than " << ProductId::GetCapacity() << " characters!\n";
   productId = _productId;
   productType = _productType;
+  handle = NO_PRODUCT_HANDLE;
 }
 
-const string& Product::GetProductId() const
+const ProductId& Product::GetProductId() const
 {
   return productId;
 }
@@ -175,19 +204,34 @@ ProductType Product::GetProductType() const
   return productType;
 }
 
+ProductHandle Product::GetHandle() const
+{
+  return handle;
+}
+
+void Product::SetHandle(ProductHandle _handle)
+{
+  handle = _handle;
+}
+
 Bond::Bond(string _productId, BondIdType _bondIdType, string _ticker, float _coupon, date _maturityDate) : Product(_productId, BOND)
 {
+  if (!Ticker::Fits(_ticker))
+    std::cout << "Oh no! The ticker " << _ticker << " is longer than " << Ticker::GetCapacity() << " characters!\n";
   bondIdType = _bondIdType;
   ticker = _ticker;
   coupon = _coupon;
-  maturityDate =_maturityDate;
+  maturitySerialDate = _maturityDate.is_special() ? 0 : static_cast<std::int32_t>(_maturityDate.day_number());
 }
 
-Bond::Bond() : Product(0, BOND)
+Bond::Bond() : Product("", BOND)
 {
+  bondIdType = CUSIP;
+  coupon = 0;
+  maturitySerialDate = 0;
 }
 
-const string& Bond::GetTicker() const
+const Ticker& Bond::GetTicker() const
 {
   return ticker;
 }
@@ -197,9 +241,16 @@ float Bond::GetCoupon() const
   return coupon;
 }
 
-const date& Bond::GetMaturityDate() const
+date Bond::GetMaturityDate() const
+{
+  if (maturitySerialDate == 0)
+    return date(not_a_date_time);
+  return date(gregorian_calendar::from_day_number(maturitySerialDate));
+}
+
+std::int32_t Bond::GetMaturitySerialDate() const
 {
-  return maturityDate;
+  return maturitySerialDate;
 }
 
 BondIdType Bond::GetBondIdType() const
@@ -231,7 +282,7 @@ IRSwap::IRSwap(string _productId, DayCountConvention _fixedLegDayCountConvention
   terminationDate =_terminationDate;
 }
 
-IRSwap::IRSwap() : Product(0, IRSWAP)
+IRSwap::IRSwap() : Product("", IRSWAP)
 {
 }
 
@@ -5,6 +5,9 @@
  * Add class to model service for future products
  * Add utility methods on the BondProductService and IRSwapProductService to
  * search for all instances of a Bond/IR Swap for a particular attribute
+ * Intern each bond to a dense integer handle at registration
+ * Keep the bonds in an immutable reference data table with secondary indexes (see BondReferenceTable.hpp)
+ * Index the IR Swaps by attribute with bitmaps (see ProductBitmap.hpp)
  */
 
 #ifndef productservice_hpp
@@ -12,12 +15,27 @@
 
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include "boost/utility/string_view.hpp"
 #include "products.hpp"
 #include "soa.hpp"
+#include "BondReferenceTable.hpp"
+#include "ProductBitmap.hpp"
 
  /**
  * Bond Product Service to own reference data over a set of bond securities.
  * Key is the productId string, value is a Bond.
+ * The bonds are registered at start-up, then looked up without a lock in an immutable table,
+ * built once at the first lookup (the bonds must not be modified through GetData()).
+ * A bond added after a lookup replaces the table at the next lookup: the bonds, views and table
+ * handed out before are then invalidated.
  */
 class BondProductService : public Service<string, Bond>
 {
@@ -26,14 +44,32 @@ public:
 	// BondProductService ctor
 	BondProductService();
 
-	// Return the bond data for a particular bond product identifier
-	virtual Bond& GetData(string productId);
+	// Return the bond data for a particular bond product identifier (throw std::out_of_range if not registered)
+	virtual Bond& GetData(const string &productId);
 
-	// Add a bond to the service (convenience method)
+	// Return the bond data for a particular bond product handle (throw std::out_of_range if not registered)
+	Bond& GetData(ProductHandle handle);
+
+	// Return the handle of a particular bond product identifier (NO_PRODUCT_HANDLE if not registered)
+	ProductHandle GetHandle(const string &productId);
+
+	// Get the number of registered bonds (the handles are 0, ..., GetSize() - 1)
+	size_t GetSize();
+
+	// Add a bond to the service (convenience method), and set the handle of the bond
 	void Add(Bond &bond);
 
-	// Get all Bonds with the specified ticker
-	vector<Bond> GetBonds(string& _ticker);
+	// Get all Bonds with the specified ticker (sorted by identifier)
+	BondView GetBonds(const string &_ticker);
+
+	// Get all Bonds maturing in [_from, _to] (sorted by maturity date)
+	BondView GetBondsByMaturity(const date &_from, const date &_to);
+
+	// Get all Bonds with a coupon in [_low, _high] (sorted by coupon)
+	BondView GetBondsByCoupon(float _low, float _high);
+
+	// Get the reference data table of the registered bonds (built if a bond was added since the last one, which is released)
+	const BondReferenceTable& GetTable();
 
 	// The callback that a Connector should invoke for any new or updated data
 	virtual void OnMessage(Bond &data);
@@ -46,14 +82,21 @@ public:
 	virtual const vector< ServiceListener<Bond>* >& GetListeners() const;
 
 private:
-	map<string, Bond> bondMap; // cache of bond products
+	std::vector<Bond> bonds; // registered bond products indexed by handle
+	std::unordered_map<string, ProductHandle> handleMap; // handles of the registered bond products
+	std::unique_ptr<BondReferenceTable> built; // the last table built
+	std::atomic<const BondReferenceTable*> table; // the current table, nullptr if a bond was added since it was built
 	std::vector<ServiceListener<Bond>*> listeners;
+	std::mutex bondMutex; // guards the registration and the building of the table
 
 };
 
 /**
 * Interest Rate Swap Product Service to own reference data over a set of IR Swap products
 * Key is the productId string, value is a IRSwap.
+* The swaps are stored densely in the order they are added, with a bitmap of the swaps of each value
+* of the attributes searched, so a query on several attributes is a bitwise AND/OR of bitmaps.
+* The GetSwaps() functions return the swaps sorted by product identifier.
 */
 class IRSwapProductService : public Service<string, IRSwap>
 {
@@ -61,12 +104,15 @@ public:
 	// IRSwapProductService ctor
 	IRSwapProductService();
 
-	// Return the IR Swap data for a particular bond product identifier
-	IRSwap& GetData(string productId);
+	// Return the IR Swap data for a particular bond product identifier (throw std::out_of_range if not added)
+	IRSwap& GetData(const string &productId);
 
 	// Add a bond to the service (convenience method)
 	void Add(IRSwap &swap);
 
+	// Get the number of swaps (the positions of the bitmaps are 0, ..., GetSize() - 1)
+	size_t GetSize() const;
+
 	// Get all Swaps with the specified fixed leg day count convention
 	vector<IRSwap> GetSwaps(DayCountConvention _fixedLegDayCountConvention);
 
@@ -88,36 +134,131 @@ public:
 	// Get all Swaps with the specified swap leg type
 	vector<IRSwap> GetSwaps(SwapLegType _swapLegType);
 
+	// Get all Swaps of a selection, e.g. Select(LIBOR) & (Select(OUTRIGHT) | Select(CURVE)) & SelectLessThan(10)
+	vector<IRSwap> GetSwaps(const ProductBitmap &_selection);
+
+	// Get the bitmap of the Swaps with the specified fixed leg day count convention
+	const ProductBitmap& Select(DayCountConvention _fixedLegDayCountConvention) const;
+
+	// Get the bitmap of the Swaps with the specified fixed leg payment frequency
+	const ProductBitmap& Select(PaymentFrequency _fixedLegPaymentFrequency) const;
+
+	// Get the bitmap of the Swaps with the specified floating index
+	const ProductBitmap& Select(FloatingIndex _floatingIndex) const;
+
+	// Get the bitmap of the Swaps with the specified swap type
+	const ProductBitmap& Select(SwapType _swapType) const;
+
+	// Get the bitmap of the Swaps with the specified swap leg type
+	const ProductBitmap& Select(SwapLegType _swapLegType) const;
+
+	// Get the bitmap of the Swaps with a term in years greater than (or equal to) the specified value
+	ProductBitmap SelectGreaterThan(int _termYears) const;
+
+	// Get the bitmap of the Swaps with a term in years strictly less than the specified value
+	ProductBitmap SelectLessThan(int _termYears) const;
+
+	// The callback that a Connector should invoke for any new or updated data
+	virtual void OnMessage(IRSwap &data);
+
+	// Add a listener to the Service for callbacks on add, remove, and update events
+	// for data to the Service.
+	virtual void AddListener(ServiceListener<IRSwap> *listener);
+
+	// Get all listeners on the Service.
+	virtual const vector< ServiceListener<IRSwap>* >& GetListeners() const;
+
 private:
-	map<string, IRSwap> swapMap; // cache of IR Swap products
+	std::vector<IRSwap> swaps; // IR Swap products in the order they were added
+	std::unordered_map<string, size_t> swapPositions; // positions of the IR Swap products
+	std::vector<ProductBitmap> fixedLegDayCountConventionIndex; // bitmap of each value of the attribute
+	std::vector<ProductBitmap> fixedLegPaymentFrequencyIndex;
+	std::vector<ProductBitmap> floatingIndexIndex;
+	std::vector<ProductBitmap> swapTypeIndex;
+	std::vector<ProductBitmap> swapLegTypeIndex;
+	std::map<int, ProductBitmap> termYearsIndex; // bitmap of each term in years
+	ProductBitmap noSwap; // empty bitmap
+	std::vector<ServiceListener<IRSwap>*> listeners;
+
+	// Set the bit of a position in the bitmap of a value of an attribute
+	static void Index(std::vector<ProductBitmap> &index, int value, size_t position);
+
+	// Get the bitmap of a value of an attribute
+	const ProductBitmap& Select(const std::vector<ProductBitmap> &index, int value) const;
 
 };
 
 
-BondProductService::BondProductService()
+BondProductService::BondProductService() : table(nullptr)
 {
-	bondMap = map<string, Bond>();
 }
 
-Bond& BondProductService::GetData(string productId)
+Bond& BondProductService::GetData(const string &productId)
 {
-	return bondMap[productId];
+	// the Service interface hands out mutable references, the bonds are not modified
+	return const_cast<Bond&>(GetTable().GetBond(productId));
+}
+
+Bond& BondProductService::GetData(ProductHandle handle)
+{
+	return const_cast<Bond&>(GetTable().GetBond(handle));
+}
+
+ProductHandle BondProductService::GetHandle(const string &productId)
+{
+	return GetTable().GetHandle(productId);
+}
+
+size_t BondProductService::GetSize()
+{
+	return GetTable().GetSize();
 }
 
 void BondProductService::Add(Bond &bond)
 {
-	bondMap.insert(pair<string, Bond>(bond.GetProductId(), bond));
+	std::lock_guard<std::mutex> lock(bondMutex);
+	auto iter = handleMap.find(bond.GetProductId());
+	if (iter != handleMap.end()) // already registered, keep the stored bond and its handle
+	{
+		bond.SetHandle(iter->second);
+		return;
+	}
+	bond.SetHandle(static_cast<ProductHandle>(bonds.size()));
+	handleMap.insert(pair<string, ProductHandle>(bond.GetProductId(), bond.GetHandle()));
+	bonds.push_back(bond);
+	table.store(nullptr, std::memory_order_release); // built again at the next lookup
+}
+
+BondView BondProductService::GetBonds(const string &_ticker)
+{
+	return GetTable().GetByTicker(_ticker);
 }
 
-vector<Bond> BondProductService::GetBonds(string& _ticker)
+BondView BondProductService::GetBondsByMaturity(const date &_from, const date &_to)
 {
-	vector<Bond> result;
-	for (auto iter = bondMap.begin(); iter != bondMap.end(); iter++)
+	return GetTable().GetByMaturity(_from, _to);
+}
+
+BondView BondProductService::GetBondsByCoupon(float _low, float _high)
+{
+	return GetTable().GetByCoupon(_low, _high);
+}
+
+const BondReferenceTable& BondProductService::GetTable()
+{
+	const BondReferenceTable* current = table.load(std::memory_order_acquire);
+	if (current != nullptr)
+		return *current;
+
+	std::lock_guard<std::mutex> lock(bondMutex);
+	current = table.load(std::memory_order_acquire);
+	if (current == nullptr)
 	{
-		if (iter->second.GetTicker() == _ticker)
-			result.push_back(iter->second);
+		built.reset(new BondReferenceTable(bonds));
+		current = built.get();
+		table.store(current, std::memory_order_release);
 	}
-	return result;
+	return *current;
 }
 
 void BondProductService::OnMessage(Bond &data)
@@ -136,98 +277,157 @@ const vector< ServiceListener<Bond>* >& BondProductService::GetListeners() const
 
 IRSwapProductService::IRSwapProductService()
 {
-	swapMap = map<string, IRSwap>();
 }
 
-IRSwap& IRSwapProductService::GetData(string productId)
+IRSwap& IRSwapProductService::GetData(const string &productId)
 {
-	return swapMap[productId];
+	auto iter = swapPositions.find(productId);
+	if (iter == swapPositions.end())
+		throw std::out_of_range("no swap " + productId + " in the reference data");
+	return swaps[iter->second];
 }
 
 void IRSwapProductService::Add(IRSwap &swap)
 {
-	swapMap.insert(pair<string, IRSwap>(swap.GetProductId(), swap));
+	if (swapPositions.find(swap.GetProductId()) != swapPositions.end()) // already added
+		return;
+	size_t position = swaps.size();
+	swapPositions.insert(pair<string, size_t>(swap.GetProductId(), position));
+	swaps.push_back(swap);
+	Index(fixedLegDayCountConventionIndex, swap.GetFixedLegDayCountConvention(), position);
+	Index(fixedLegPaymentFrequencyIndex, swap.GetFixedLegPaymentFrequency(), position);
+	Index(floatingIndexIndex, swap.GetFloatingIndex(), position);
+	Index(swapTypeIndex, swap.GetSwapType(), position);
+	Index(swapLegTypeIndex, swap.GetSwapLegType(), position);
+	termYearsIndex[swap.GetTermYears()].Set(position);
 }
 
-vector<IRSwap> IRSwapProductService::GetSwaps(DayCountConvention _fixedLegDayCountConvention)
+size_t IRSwapProductService::GetSize() const
 {
-	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetFixedLegDayCountConvention() == _fixedLegDayCountConvention)
-			result.push_back(iter->second);
-	}
+	return swaps.size();
+}
+
+void IRSwapProductService::Index(std::vector<ProductBitmap> &index, int value, size_t position)
+{
+	if (value < 0)
+		return;
+	if (static_cast<size_t>(value) >= index.size())
+		index.resize(value + 1);
+	index[value].Set(position);
+}
+
+const ProductBitmap& IRSwapProductService::Select(const std::vector<ProductBitmap> &index, int value) const
+{
+	return (value >= 0 && static_cast<size_t>(value) < index.size()) ? index[value] : noSwap;
+}
+
+const ProductBitmap& IRSwapProductService::Select(DayCountConvention _fixedLegDayCountConvention) const
+{
+	return Select(fixedLegDayCountConventionIndex, _fixedLegDayCountConvention);
+}
+
+const ProductBitmap& IRSwapProductService::Select(PaymentFrequency _fixedLegPaymentFrequency) const
+{
+	return Select(fixedLegPaymentFrequencyIndex, _fixedLegPaymentFrequency);
+}
+
+const ProductBitmap& IRSwapProductService::Select(FloatingIndex _floatingIndex) const
+{
+	return Select(floatingIndexIndex, _floatingIndex);
+}
+
+const ProductBitmap& IRSwapProductService::Select(SwapType _swapType) const
+{
+	return Select(swapTypeIndex, _swapType);
+}
+
+const ProductBitmap& IRSwapProductService::Select(SwapLegType _swapLegType) const
+{
+	return Select(swapLegTypeIndex, _swapLegType);
+}
+
+ProductBitmap IRSwapProductService::SelectGreaterThan(int _termYears) const
+{
+	ProductBitmap result;
+	for (auto iter = termYearsIndex.lower_bound(_termYears); iter != termYearsIndex.end(); iter++) // greater or equal than
+		result |= iter->second;
 	return result;
 }
 
-vector<IRSwap> IRSwapProductService::GetSwaps(PaymentFrequency _fixedLegPaymentFrequency)
+ProductBitmap IRSwapProductService::SelectLessThan(int _termYears) const
 {
-	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetFixedLegPaymentFrequency() == _fixedLegPaymentFrequency)
-			result.push_back(iter->second);
-	}
+	ProductBitmap result;
+	for (auto iter = termYearsIndex.begin(); iter != termYearsIndex.lower_bound(_termYears); iter++) // strictly less than
+		result |= iter->second;
 	return result;
 }
 
-vector<IRSwap> IRSwapProductService::GetSwaps(FloatingIndex _floatingIndex)
+vector<IRSwap> IRSwapProductService::GetSwaps(const ProductBitmap &_selection)
 {
+	// the positions are in the order the swaps were added, the swaps are returned by product identifier
+	std::vector<size_t> positions;
+	positions.reserve(_selection.Count());
+	_selection.ForEach([&positions](size_t position) { positions.push_back(position); });
+	std::sort(positions.begin(), positions.end(), [this](size_t left, size_t right) {
+		return swaps[left].GetProductId() < swaps[right].GetProductId(); });
+
 	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetFloatingIndex() == _floatingIndex)
-			result.push_back(iter->second);
-	}
+	result.reserve(positions.size());
+	for (size_t position : positions)
+		result.push_back(swaps[position]);
 	return result;
 }
 
+void IRSwapProductService::OnMessage(IRSwap &data)
+{
+}
+
+void IRSwapProductService::AddListener(ServiceListener<IRSwap> *listener)
+{
+	listeners.push_back(listener);
+}
+
+const vector< ServiceListener<IRSwap>* >& IRSwapProductService::GetListeners() const
+{
+	return listeners;
+}
+
+vector<IRSwap> IRSwapProductService::GetSwaps(DayCountConvention _fixedLegDayCountConvention)
+{
+	return GetSwaps(Select(_fixedLegDayCountConvention));
+}
+
+vector<IRSwap> IRSwapProductService::GetSwaps(PaymentFrequency _fixedLegPaymentFrequency)
+{
+	return GetSwaps(Select(_fixedLegPaymentFrequency));
+}
+
+vector<IRSwap> IRSwapProductService::GetSwaps(FloatingIndex _floatingIndex)
+{
+	return GetSwaps(Select(_floatingIndex));
+}
+
 vector<IRSwap> IRSwapProductService::GetSwapsGreaterThan(int _termYears)
 {
-	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetTermYears() >= _termYears) // greater or equal than
-			result.push_back(iter->second);
-	}
-	return result;
+	return GetSwaps(SelectGreaterThan(_termYears));
 }
 
 vector<IRSwap> IRSwapProductService::GetSwapsLessThan(int _termYears)
 {
-	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetTermYears() < _termYears) // strictly less than
-			result.push_back(iter->second);
-	}
-	return result;
+	return GetSwaps(SelectLessThan(_termYears));
 }
 
 vector<IRSwap> IRSwapProductService::GetSwaps(SwapType _swapType)
 {
-	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetSwapType() == _swapType)
-			result.push_back(iter->second);
-	}
-	return result;
+	return GetSwaps(Select(_swapType));
 }
 
 vector<IRSwap> IRSwapProductService::GetSwaps(SwapLegType _swapLegType)
 {
-	vector<IRSwap> result;
-	for (auto iter = swapMap.begin(); iter != swapMap.end(); iter++)
-	{
-		if (iter->second.GetSwapLegType() == _swapLegType)
-			result.push_back(iter->second);
-	}
-	return result;
+	return GetSwaps(Select(_swapLegType));
 }
 
 
-
 #endif // !productservice_hpp
 
 
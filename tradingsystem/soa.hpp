@@ -9,6 +9,7 @@
 #define SOA_HPP
 
 #include <vector>
+#include <cstddef>
 
 using namespace std;
 
@@ -32,6 +33,14 @@ public:
   // Listener callback to process an update event to the Service
   virtual void ProcessUpdate(V &data) = 0;
 
+  // Listener callback to process a contiguous batch of add events to the Service
+  // (defaults to one ProcessAdd() per element)
+  virtual void ProcessAddBatch(V *data, size_t size);
+
+  // Listener callback to process a contiguous batch of update events to the Service
+  // (defaults to one ProcessUpdate() per element)
+  virtual void ProcessUpdateBatch(V *data, size_t size);
+
 };
 
 /**
@@ -45,11 +54,15 @@ class Service
 public:
 
   // Get data on our service given a key
-  virtual V& GetData(K key) = 0;
+  virtual V& GetData(const K &key) = 0;
 
   // The callback that a Connector should invoke for any new or updated data
   virtual void OnMessage(V &data) = 0;
 
+  // The callback that a Connector can invoke for a contiguous batch of new or updated data
+  // (defaults to one OnMessage() per element)
+  virtual void OnMessageBatch(V *data, size_t size);
+
   // Add a listener to the Service for callbacks on add, remove, and update events
   // for data to the Service.
   virtual void AddListener(ServiceListener<V> *listener) = 0;
@@ -76,6 +89,38 @@ public:
   // Publish data to the Connector
   virtual void Publish(V &data) = 0;
 
+  // Publish a contiguous batch of data to the Connector
+  // (defaults to one Publish() per element)
+  virtual void PublishBatch(V *data, size_t size);
+
 };
 
+template<typename V>
+void ServiceListener<V>::ProcessAddBatch(V *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    ProcessAdd(data[i]);
+}
+
+template<typename V>
+void ServiceListener<V>::ProcessUpdateBatch(V *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    ProcessUpdate(data[i]);
+}
+
+template<typename K, typename V>
+void Service<K,V>::OnMessageBatch(V *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    OnMessage(data[i]);
+}
+
+template<typename V>
+void Connector<V>::PublishBatch(V *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    Publish(data[i]);
+}
+
 #endif
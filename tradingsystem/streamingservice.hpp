@@ -19,14 +19,14 @@ class PriceStreamOrder
 public:
 
   // ctor for an order
-  PriceStreamOrder(double _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side);
+  PriceStreamOrder(TickPrice _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side);
   PriceStreamOrder() {} 
 
   // The side on this order
   PricingSide GetSide() const; 
 
   // Get the price on this order
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the visible quantity on this order
   long GetVisibleQuantity() const;
@@ -35,7 +35,7 @@ public:
   long GetHiddenQuantity() const;
 
 private:
-  double price;
+  TickPrice price;
   long visibleQuantity;
   long hiddenQuantity;
   PricingSide side;
@@ -88,7 +88,7 @@ public:
 
 };
 
-PriceStreamOrder::PriceStreamOrder(double _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side)
+PriceStreamOrder::PriceStreamOrder(TickPrice _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side)
 {
   price = _price;
   visibleQuantity = _visibleQuantity;
@@ -101,7 +101,7 @@ PricingSide PriceStreamOrder::GetSide() const
 	return side;
 }
 
-double PriceStreamOrder::GetPrice() const
+TickPrice PriceStreamOrder::GetPrice() const
 {
   return price;
 }
@@ -10,6 +10,9 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <cstddef>
+#include <cmath>
+#include <limits>
 #include "boost/algorithm/string.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 
@@ -79,6 +82,167 @@ std::string PricetoString(T price)
 	
 }
 
+// lookup tables of the fractional price notation 99-xyz
+struct PriceNotationTable
+{
+	unsigned char digit[256]; // value of a digit character, 0xFF otherwise
+	unsigned char eighth[256]; // value of the z character ('+' is 4), 0xFF otherwise
+	char thirtySecond[32][2]; // the xy characters, "00" to "31"
+	char eighthChar[8]; // the z characters, '0' to '7' with '+' for 4
+
+	PriceNotationTable(); // ctor, fills the tables
+};
+
+PriceNotationTable::PriceNotationTable()
+{
+	for (int c = 0; c < 256; c++)
+	{
+		digit[c] = (c >= '0' && c <= '9') ? static_cast<unsigned char>(c - '0') : 0xFF;
+		eighth[c] = (c >= '0' && c <= '7' && c != '4') ? static_cast<unsigned char>(c - '0') : 0xFF;
+	}
+	eighth[static_cast<unsigned char>('+')] = 4;
+	for (int i = 0; i < 32; i++)
+	{
+		thirtySecond[i][0] = static_cast<char>('0' + i / 10);
+		thirtySecond[i][1] = static_cast<char>('0' + i % 10);
+	}
+	for (int i = 0; i < 8; i++)
+		eighthChar[i] = (i == 4) ? '+' : static_cast<char>('0' + i);
+}
+
+// get the (shared) lookup tables of the fractional price notation
+inline const PriceNotationTable& GetPriceNotationTable()
+{
+	static const PriceNotationTable table;
+	return table;
+}
+
+// convert the price characters [str, str + size) to the number of 1/256 ticks, without allocation
+// Input format is like 99-xyz (see StringtoPrice), the xyz part always takes the last three characters
+// return false if the characters are not in this format
+inline bool BuffertoTicks(const char* str, std::size_t size, long &ticks)
+{
+	const PriceNotationTable &table = GetPriceNotationTable();
+	if (size < 5 || str[size - 4] != '-')
+		return false;
+
+	// the integer part
+	long integer = 0;
+	unsigned char bad = 0; // OR of the lookups, 0xFF if any character is invalid
+	for (std::size_t i = 0; i < size - 4; i++)
+	{
+		unsigned char d = table.digit[static_cast<unsigned char>(str[i])];
+		bad |= d;
+		integer = integer * 10 + (d & 0x0F);
+	}
+
+	// the xy part and the z part
+	unsigned char x = table.digit[static_cast<unsigned char>(str[size - 3])];
+	unsigned char y = table.digit[static_cast<unsigned char>(str[size - 2])];
+	unsigned char z = table.eighth[static_cast<unsigned char>(str[size - 1])];
+	int xy = x * 10 + y;
+	if ((bad | x | y | z) == 0xFF || xy > 31) // 0xFF is only reached through an invalid character
+		return false;
+
+	ticks = integer * 256 + xy * 8 + z;
+	return true;
+}
+
+// convert the price characters [str, str + size) to the price, without allocation
+// same as StringtoPrice, but return NaN if the characters are not in the 99-xyz format
+inline double BuffertoPrice(const char* str, std::size_t size)
+{
+	long ticks;
+	if (!BuffertoTicks(str, size, ticks))
+		return std::numeric_limits<double>::quiet_NaN();
+	return ticks / 256.0;
+}
+
+// convert a column of price fields to numbers of 1/256 ticks
+// return false if any field is not in the 99-xyz format (its ticks are then unspecified)
+// Type Field is a contiguous character range with data() and size() (e.g. std::string, boost::string_view)
+template <typename Field>
+bool BuffertoTicksBatch(const Field* fields, std::size_t n, long* ticks)
+{
+	bool allValid = true;
+	for (std::size_t i = 0; i < n; i++)
+		allValid &= BuffertoTicks(fields[i].data(), fields[i].size(), ticks[i]);
+	return allValid;
+}
+
+// convert a column of price fields to prices (NaN for the fields not in the 99-xyz format)
+// the ticks are extracted first, then converted in one straight loop the compiler can vectorize
+// Type Field is a contiguous character range with data() and size() (e.g. std::string, boost::string_view)
+template <typename Field>
+void BuffertoPriceBatch(const Field* fields, std::size_t n, double* prices)
+{
+	const std::size_t chunk = 64;
+	long ticks[chunk];
+	bool valid[chunk];
+	for (std::size_t begin = 0; begin < n; begin += chunk)
+	{
+		std::size_t size = (n - begin < chunk) ? n - begin : chunk;
+		bool allValid = true;
+		for (std::size_t i = 0; i < size; i++)
+		{
+			valid[i] = BuffertoTicks(fields[begin + i].data(), fields[begin + i].size(), ticks[i]);
+			allValid = allValid && valid[i];
+		}
+		for (std::size_t i = 0; i < size; i++)
+			prices[begin + i] = ticks[i] * (1.0 / 256);
+		if (!allValid)
+		{
+			for (std::size_t i = 0; i < size; i++)
+				if (!valid[i]) prices[begin + i] = std::numeric_limits<double>::quiet_NaN();
+		}
+	}
+}
+
+// convert a number of 1/256 ticks to the price characters written into buffer (null-terminated, at least 32 characters)
+// and return the number of characters written (without the null character), without allocation
+// Output format is the same as PricetoString
+inline std::size_t TickstoBuffer(long ticks, char* buffer)
+{
+	const PriceNotationTable &table = GetPriceNotationTable();
+
+	// the integer part and the number of 1/256 ticks above it
+	long integer = (ticks >= 0) ? ticks / 256 : -((255 - ticks) / 256);
+	int fraction = static_cast<int>(ticks - integer * 256);
+
+	// the integer part, written backwards
+	char digits[24];
+	std::size_t n = 0;
+	unsigned long magnitude = (integer < 0) ? 0UL - static_cast<unsigned long>(integer) : static_cast<unsigned long>(integer);
+	do
+	{
+		digits[n++] = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude > 0);
+
+	std::size_t size = 0;
+	if (integer < 0) buffer[size++] = '-';
+	while (n > 0) buffer[size++] = digits[--n];
+
+	// the xy part and the z part
+	buffer[size++] = '-';
+	buffer[size++] = table.thirtySecond[fraction >> 3][0];
+	buffer[size++] = table.thirtySecond[fraction >> 3][1];
+	buffer[size++] = table.eighthChar[fraction & 7];
+	buffer[size] = '\0';
+	return size;
+}
+
+// convert the price to the price characters written into buffer (null-terminated, at least 32 characters)
+// and return the number of characters written (without the null character), without allocation
+// Output format is the same as PricetoString (truncated to the tick below)
+inline std::size_t PricetoBuffer(double price, char* buffer)
+{
+	double floorPrice = std::floor(price);
+	long fraction = static_cast<long>((price - floorPrice) * 256);
+	if (fraction > 255) fraction = 255; // price - floorPrice rounded up to 1
+	return TickstoBuffer(static_cast<long>(floorPrice) * 256 + fraction, buffer);
+}
+
 // convert boost::gregorian::date to us date string
 template <typename Date>
 std::string DatetoUsString(Date d)